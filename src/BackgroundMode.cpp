@@ -0,0 +1,441 @@
+#include "BackgroundMode.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QProcess>
+#include <QSettings>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// How often a throttled worker checks whether it was cancelled
+const std::chrono::milliseconds CANCEL_POLL(250);
+
+#if defined(__linux__)
+// From linux/ioprio.h, which not every distribution installs
+const int IOPRIO_WHO_PROCESS = 1;
+const int IOPRIO_CLASS_IDLE = 3;
+const int IOPRIO_CLASS_SHIFT = 13;
+#endif
+
+thread_local bool threadLowered = false;
+
+// Steady clock milliseconds of the last input to our windows, 0 for none
+std::atomic<int64_t> lastInputMs(0);
+
+int64_t steadyMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Lowest CPU and I/O priority for the calling thread, or with wholeProcess
+ * for the process. Runs in a freshly forked child, so only plain system
+ * calls: no allocation, no locks, no logging.
+ */
+bool lowerPriority(bool wholeProcess)
+{
+#if defined(__linux__)
+    // Linux applies these to the calling thread, despite the names;
+    // a forked child has only the one
+    bool ok = setpriority(PRIO_PROCESS, 0, 19) == 0;
+    ok = syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) == 0 && ok;
+#ifdef SCHED_IDLE
+    // Threads share db_mutex with the GUI; one starved under SCHED_IDLE
+    // while holding it would freeze the window. Helpers hold no such lock.
+    if (wholeProcess) {
+        struct sched_param param = {};
+        ok = sched_setscheduler(0, SCHED_IDLE, &param) == 0 && ok;
+    }
+#endif
+    return ok;
+#elif defined(__APPLE__)
+    // The background band lowers CPU, I/O and network priority at once
+    return setpriority(wholeProcess ? PRIO_DARWIN_PROCESS : PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG) == 0;
+#elif defined(_WIN32)
+    if (wholeProcess) {
+        return SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN) != 0;
+    }
+    return SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != 0;
+#else
+    // Elsewhere nice applies to the whole process, which would stay lowered
+    return wholeProcess && setpriority(PRIO_PROCESS, 0, 19) == 0;
+#endif
+}
+
+#ifdef _WIN32
+int64_t fileTimeUs(const FILETIME& time)
+{
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<int64_t>(value.QuadPart / 10);
+}
+#else
+int64_t timevalUs(const struct timeval& time)
+{
+    return static_cast<int64_t>(time.tv_sec) * 1000000 + time.tv_usec;
+}
+#endif
+
+/*
+ * CPU time all processors spent busy and in total since boot, summed
+ * over processors. False where the system does not tell.
+ */
+bool systemCpuUs(int64_t& busyUs, int64_t& totalUs)
+{
+#if defined(__linux__)
+    std::ifstream stat("/proc/stat");
+    std::string label;
+    int64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    if (!(stat >> label >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal) || label != "cpu") {
+        return false;
+    }
+    const int64_t ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (ticksPerSecond <= 0) {
+        return false;
+    }
+    const int64_t busy = user + nice + system + irq + softirq + steal;
+    busyUs = busy * 1000000 / ticksPerSecond;
+    totalUs = (busy + idle + iowait) * 1000000 / ticksPerSecond;
+    return true;
+#elif defined(_WIN32)
+    FILETIME idle, kernel, user;
+    if (!GetSystemTimes(&idle, &kernel, &user)) {
+        return false;
+    }
+    // Kernel time includes the idle time
+    totalUs = fileTimeUs(kernel) + fileTimeUs(user);
+    busyUs = totalUs - fileTimeUs(idle);
+    return true;
+#else
+    (void)busyUs;
+    (void)totalUs;
+    return false;
+#endif
+}
+
+// CPU time of a running helper, -1 where unknown
+int64_t processCpuUs(int64_t pid)
+{
+#if defined(__linux__)
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line)) {
+        return -1;
+    }
+    // The command name may hold spaces; the fields after it do not.
+    // utime and stime are fields 14 and 15, state is field 3.
+    size_t nameEnd = line.rfind(')');
+    if (nameEnd == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(line.substr(nameEnd + 1));
+    std::string field;
+    int64_t utime = 0, stime = 0;
+    for (int i = 3; i <= 13; ++i) {
+        fields >> field;
+    }
+    if (!(fields >> utime >> stime)) {
+        return -1;
+    }
+    const int64_t ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticksPerSecond > 0 ? (utime + stime) * 1000000 / ticksPerSecond : -1;
+#elif defined(_WIN32)
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+    if (!process) {
+        return -1;
+    }
+    FILETIME creation, exit, kernel, user;
+    int64_t used = -1;
+    if (GetProcessTimes(process, &creation, &exit, &kernel, &user)) {
+        used = fileTimeUs(kernel) + fileTimeUs(user);
+    }
+    CloseHandle(process);
+    return used;
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// Reports input to any of our windows; never consumes the event
+class InputWatcher : public QObject {
+public:
+    using QObject::QObject;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        switch (event->type()) {
+        case QEvent::KeyPress:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseMove:
+        case QEvent::Wheel:
+        case QEvent::TouchBegin:
+            BackgroundMode::noteInput();
+            break;
+        default:
+            break;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+}
+
+BackgroundMode::BackgroundMode(double loadThreshold, int idleSec)
+    : loadThreshold(loadThreshold), idleSec(idleSec), fromSettings(loadThreshold < 0.0 || idleSec < 0)
+{
+    if (fromSettings) {
+        QSettings settings;
+        if (this->loadThreshold < 0.0) {
+            this->loadThreshold = settings.value("backgroundLoadThreshold", 0.5).toDouble();
+        }
+        if (this->idleSec < 0) {
+            this->idleSec = settings.value("backgroundIdleSec", 60).toInt();
+        }
+    }
+}
+
+BackgroundMode& BackgroundMode::shared()
+{
+    static BackgroundMode mode;
+    return mode;
+}
+
+bool BackgroundMode::enabled()
+{
+    QSettings settings;
+    return settings.value("backgroundMode", false).toBool();
+}
+
+void BackgroundMode::lowerCurrentThread()
+{
+    if (threadLowered) {
+        return;
+    }
+    threadLowered = true;
+    if (!lowerPriority(false)) {
+        // Whatever did apply stays; the throttle still works
+        qDebug() << "[BackgroundMode::lowerCurrentThread] Could not fully lower the priority of" << QThread::currentThread();
+    }
+}
+
+bool BackgroundMode::currentThreadLowered()
+{
+    return threadLowered;
+}
+
+void BackgroundMode::prepareChild(QProcess& process)
+{
+    if (!enabled()) {
+        return;
+    }
+#if defined(_WIN32)
+    process.setCreateProcessArgumentsModifier([](QProcess::CreateProcessArguments* arguments) {
+        arguments->flags |= IDLE_PRIORITY_CLASS;
+    });
+#else
+    process.setChildProcessModifier([]() {
+        lowerPriority(true);
+    });
+#endif
+}
+
+void BackgroundMode::trackProcess(int64_t pid)
+{
+    if (pid <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    trackedPids.insert(pid);
+}
+
+void BackgroundMode::untrackProcess(int64_t pid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    trackedPids.erase(pid);
+}
+
+void BackgroundMode::installInputWatcher(QCoreApplication* app)
+{
+    if (!app) {
+        return;
+    }
+    app->installEventFilter(new InputWatcher(app));
+}
+
+void BackgroundMode::noteInput()
+{
+    lastInputMs.store(steadyMs(), std::memory_order_relaxed);
+}
+
+bool BackgroundMode::waitForTurn(int slot, const std::function<bool()>& cancelled)
+{
+    while (true) {
+        if (cancelled && cancelled()) {
+            return false;
+        }
+        if (slot <= 0) {
+            return true;
+        }
+        refresh();
+        if (!throttled()) {
+            return true;
+        }
+        std::this_thread::sleep_for(CANCEL_POLL);
+    }
+}
+
+bool BackgroundMode::update(const Sample& sample)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    lastSample = std::chrono::steady_clock::now();
+    sampledOnce = true;
+
+    const bool inputRecent = sample.idleMs >= 0 && sample.idleMs < static_cast<int64_t>(idleSec) * 1000;
+    if (!throttling) {
+        if (sample.othersLoad > loadThreshold || inputRecent) {
+            throttling = true;
+            qDebug() << "[BackgroundMode::update] Throttling indexing; CPU share of other programs:" << sample.othersLoad
+                << "seconds since input:" << (sample.idleMs < 0 ? -1 : sample.idleMs / 1000);
+        }
+    }
+    // Unknown load counts as calm
+    else if (sample.othersLoad < loadThreshold / 2.0 && !inputRecent) {
+        throttling = false;
+        qDebug() << "[BackgroundMode::update] Machine is idle, indexing at full speed";
+    }
+    return throttling;
+}
+
+bool BackgroundMode::throttled() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return throttling;
+}
+
+void BackgroundMode::refresh()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sampledOnce && std::chrono::steady_clock::now() - lastSample < SAMPLE_INTERVAL) {
+            return;
+        }
+        // Claimed, so other workers do not sample the same interval
+        lastSample = std::chrono::steady_clock::now();
+        sampledOnce = true;
+
+        if (fromSettings) {
+            QSettings settings;
+            loadThreshold = settings.value("backgroundLoadThreshold", 0.5).toDouble();
+            idleSec = settings.value("backgroundIdleSec", 60).toInt();
+        }
+    }
+    update(sampleSystem());
+}
+
+BackgroundMode::Sample BackgroundMode::sampleSystem()
+{
+    Sample sample;
+
+#ifdef _WIN32
+    LASTINPUTINFO input;
+    input.cbSize = sizeof(input);
+    if (GetLastInputInfo(&input)) {
+        sample.idleMs = static_cast<int64_t>(GetTickCount() - input.dwTime);
+    }
+#else
+    const int64_t lastInput = lastInputMs.load(std::memory_order_relaxed);
+    if (lastInput > 0) {
+        sample.idleMs = steadyMs() - lastInput;
+    }
+#endif
+
+    const int64_t ownUs = ownCpuUs();
+    const auto now = std::chrono::steady_clock::now();
+    int64_t busyUs = 0;
+    int64_t totalUs = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (systemCpuUs(busyUs, totalUs)) {
+        // Everything busy that was not us, over the last interval
+        if (lastTotalUs >= 0 && totalUs > lastTotalUs && lastOwnUs >= 0) {
+            const double othersUs = static_cast<double>((busyUs - lastBusyUs) - (ownUs - lastOwnUs));
+            sample.othersLoad = std::clamp(othersUs / static_cast<double>(totalUs - lastTotalUs), 0.0, 1.0);
+        }
+        lastBusyUs = busyUs;
+        lastTotalUs = totalUs;
+    }
+#ifndef _WIN32
+    else {
+        // Runnable threads over the last minute, less our share of them
+        double load[1];
+        const int cpus = std::max(1, QThread::idealThreadCount());
+        if (getloadavg(load, 1) == 1 && lastOwnUs >= 0) {
+            const double wallUs = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - lastOwnAt).count());
+            const double ownShare = wallUs > 0.0 ? static_cast<double>(ownUs - lastOwnUs) / (wallUs * cpus) : 0.0;
+            sample.othersLoad = std::clamp(load[0] / cpus - ownShare, 0.0, 1.0);
+        }
+    }
+#endif
+    lastOwnUs = ownUs;
+    lastOwnAt = now;
+    return sample;
+}
+
+int64_t BackgroundMode::ownCpuUs()
+{
+    int64_t used = 0;
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        used = fileTimeUs(kernel) + fileTimeUs(user);
+    }
+#else
+    // Finished children count once they are reaped
+    struct rusage self, children;
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+        used += timevalUs(self.ru_utime) + timevalUs(self.ru_stime);
+    }
+    if (getrusage(RUSAGE_CHILDREN, &children) == 0) {
+        used += timevalUs(children.ru_utime) + timevalUs(children.ru_stime);
+    }
+#endif
+
+    std::set<int64_t> pids;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pids = trackedPids;
+    }
+    for (int64_t pid : pids) {
+        used += std::max<int64_t>(0, processCpuUs(pid));
+    }
+    return used;
+}
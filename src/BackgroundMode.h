@@ -0,0 +1,136 @@
+#ifndef BACKGROUNDMODE_H
+#define BACKGROUNDMODE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+
+class QCoreApplication;
+class QProcess;
+
+/**
+ * @brief Keeps indexing out of the way of interactive work on the machine
+ *
+ * With the "backgroundMode" setting on, the indexer's pipeline threads,
+ * the render threads under them and the helper, rt and gist processes
+ * they start run at the lowest CPU and I/O priority the platform offers
+ * (nice 19 and the idle I/O class on Linux, plus SCHED_IDLE for the
+ * processes, the background band on macOS and Windows). Threads stay off
+ * SCHED_IDLE: they take the catalog lock the GUI waits on. Only threads
+ * that end with their batch are lowered: an unprivileged process cannot
+ * raise a priority back.
+ *
+ * On top of that the indexer throttles itself. Before each job a worker
+ * calls waitForTurn(); while the machine is busy every worker but the
+ * first sleeps. Busy means other programs use more than the
+ * "backgroundLoadThreshold" share of the CPU (default 0.5), or there was
+ * input less than "backgroundIdleSec" seconds ago (default 60). Full
+ * speed comes back once other programs use less than half the threshold
+ * and input has been idle that long. The state is sampled at most every
+ * SAMPLE_INTERVAL.
+ *
+ * Input is the system's last input on Windows; elsewhere it is input to
+ * CADventory's own windows, which installInputWatcher() reports.
+ *
+ * Usage example:
+ *
+ * if (BackgroundMode::enabled()) {
+ *     BackgroundMode::lowerCurrentThread();
+ * }
+ * while (BackgroundMode::shared().waitForTurn(workerIndex, stopped)) { ... next job ... }
+ */
+class BackgroundMode {
+public:
+    static constexpr std::chrono::milliseconds SAMPLE_INTERVAL{ 5000 };
+
+    // What the throttle decides on; -1 where unknown
+    struct Sample {
+        double othersLoad = -1.0;   // share of all CPUs used by other programs, 0 to 1
+        int64_t idleMs = -1;        // since the last input
+    };
+
+    // Negative values read the "backgroundLoadThreshold" and
+    // "backgroundIdleSec" settings, again at every sample
+    explicit BackgroundMode(double loadThreshold = -1.0, int idleSec = -1);
+    BackgroundMode(const BackgroundMode&) = delete;
+    BackgroundMode& operator=(const BackgroundMode&) = delete;
+
+    // The process-wide throttle
+    static BackgroundMode& shared();
+
+    // "backgroundMode" setting
+    static bool enabled();
+
+    /*
+     * Lowers the calling thread's CPU and I/O priority for the rest of
+     * its life. Children it starts inherit the lowering on Linux.
+     */
+    static void lowerCurrentThread();
+    static bool currentThreadLowered();
+
+    /*
+     * Makes process start at the lowest priority when background mode is
+     * on. Call before start().
+     */
+    static void prepareChild(QProcess& process);
+
+    /*
+     * Started helpers whose CPU time counts as CADventory's own, not as
+     * another program's load (see TrackedChild).
+     */
+    void trackProcess(int64_t pid);
+    void untrackProcess(int64_t pid);
+
+    // Input to CADventory's windows, reported through noteInput()
+    static void installInputWatcher(QCoreApplication* app);
+    static void noteInput();
+
+    /*
+     * Blocks worker slot while the machine is busy; slot 0 never waits,
+     * so indexing always moves. Returns false if cancelled() turns true.
+     */
+    bool waitForTurn(int slot, const std::function<bool()>& cancelled = nullptr);
+
+    // Takes one sample into account and returns whether to throttle
+    bool update(const Sample& sample);
+    bool throttled() const;
+
+private:
+    void refresh();
+    Sample sampleSystem();
+    int64_t ownCpuUs();
+
+    double loadThreshold;
+    int idleSec;
+    const bool fromSettings;
+
+    mutable std::mutex mutex;
+    bool throttling = false;
+    bool sampledOnce = false;
+    std::chrono::steady_clock::time_point lastSample;
+    std::set<int64_t> trackedPids;
+
+    // Previous cumulative counters, for the load over the last interval
+    int64_t lastBusyUs = -1;
+    int64_t lastTotalUs = -1;
+    int64_t lastOwnUs = -1;
+    std::chrono::steady_clock::time_point lastOwnAt;
+};
+
+/**
+ * @brief Counts a started child as CADventory's own load while in scope
+ */
+class TrackedChild {
+public:
+    explicit TrackedChild(int64_t pid) : pid(pid) { BackgroundMode::shared().trackProcess(pid); }
+    ~TrackedChild() { BackgroundMode::shared().untrackProcess(pid); }
+    TrackedChild(const TrackedChild&) = delete;
+    TrackedChild& operator=(const TrackedChild&) = delete;
+
+private:
+    int64_t pid;
+};
+
+#endif // BACKGROUNDMODE_H
@@ -0,0 +1,275 @@
+#include "ContentHasher.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+// Size of each memory-mapped window; keeps address space usage bounded
+// even for very large databases.
+const qint64 MAP_WINDOW_SIZE = 64LL * 1024 * 1024;
+
+// Buffer used when a file cannot be mapped
+const qint64 READ_BUFFER_SIZE = 4LL * 1024 * 1024;
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const unsigned char* p) {
+    // XXH64 is defined over little-endian words
+    return static_cast<uint64_t>(p[0]) | (static_cast<uint64_t>(p[1]) << 8) |
+        (static_cast<uint64_t>(p[2]) << 16) | (static_cast<uint64_t>(p[3]) << 24) |
+        (static_cast<uint64_t>(p[4]) << 32) | (static_cast<uint64_t>(p[5]) << 40) |
+        (static_cast<uint64_t>(p[6]) << 48) | (static_cast<uint64_t>(p[7]) << 56);
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    acc *= PRIME64_1;
+    return acc;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    val = round64(0, val);
+    acc ^= val;
+    acc = acc * PRIME64_1 + PRIME64_4;
+    return acc;
+}
+
+}  // namespace
+
+ContentHasher::ContentHasher(uint64_t seed)
+{
+    reset(seed);
+}
+
+void ContentHasher::reset(uint64_t newSeed)
+{
+    seed = newSeed;
+    v1 = seed + PRIME64_1 + PRIME64_2;
+    v2 = seed + PRIME64_2;
+    v3 = seed;
+    v4 = seed - PRIME64_1;
+    totalLength = 0;
+    bufferSize = 0;
+}
+
+void ContentHasher::consumeStripe(const unsigned char* p)
+{
+    v1 = round64(v1, read64(p));
+    v2 = round64(v2, read64(p + 8));
+    v3 = round64(v3, read64(p + 16));
+    v4 = round64(v4, read64(p + 24));
+}
+
+void ContentHasher::update(const void* data, size_t length)
+{
+    if (!data || length == 0) {
+        return;
+    }
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + length;
+    totalLength += length;
+
+    // Top up a partially filled stripe first
+    if (bufferSize + length < sizeof(buffer)) {
+        std::memcpy(buffer + bufferSize, p, length);
+        bufferSize += length;
+        return;
+    }
+
+    if (bufferSize > 0) {
+        size_t fill = sizeof(buffer) - bufferSize;
+        std::memcpy(buffer + bufferSize, p, fill);
+        consumeStripe(buffer);
+        p += fill;
+        bufferSize = 0;
+    }
+
+    while (p + 32 <= end) {
+        consumeStripe(p);
+        p += 32;
+    }
+
+    if (p < end) {
+        bufferSize = static_cast<size_t>(end - p);
+        std::memcpy(buffer, p, bufferSize);
+    }
+}
+
+uint64_t ContentHasher::digest() const
+{
+    uint64_t h;
+    if (totalLength >= 32) {
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += totalLength;
+
+    const unsigned char* p = buffer;
+    const unsigned char* const end = buffer + bufferSize;
+
+    while (p + 8 <= end) {
+        uint64_t k1 = round64(0, read64(p));
+        h ^= k1;
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= static_cast<uint64_t>(*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+bool ContentHasher::hashFile(const std::string& path, uint64_t& digest)
+{
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "[ContentHasher::hashFile] Could not open file for hashing:"
+            << QString::fromStdString(path);
+        return false;
+    }
+
+    ContentHasher hasher;
+    const qint64 fileSize = file.size();
+    qint64 offset = 0;
+
+    // Walk the file through mapped windows, the kernel does the read-ahead
+    while (offset < fileSize) {
+        qint64 windowSize = std::min(MAP_WINDOW_SIZE, fileSize - offset);
+        uchar* window = file.map(offset, windowSize);
+        if (!window) {
+            break;
+        }
+        hasher.update(window, static_cast<size_t>(windowSize));
+        file.unmap(window);
+        offset += windowSize;
+    }
+
+    // Mapping is not available everywhere (pipes, some network shares)
+    if (offset < fileSize) {
+        if (!file.seek(offset)) {
+            qDebug() << "[ContentHasher::hashFile] Seek failed for"
+                << QString::fromStdString(path);
+            return false;
+        }
+        QByteArray chunk;
+        while (!file.atEnd()) {
+            chunk = file.read(READ_BUFFER_SIZE);
+            if (chunk.isEmpty()) {
+                qDebug() << "[ContentHasher::hashFile] Read failed for"
+                    << QString::fromStdString(path);
+                return false;
+            }
+            hasher.update(chunk.constData(), static_cast<size_t>(chunk.size()));
+        }
+    }
+
+    digest = hasher.digest();
+    return true;
+}
+
+bool ContentHasher::statFile(const std::string& path, int64_t& size, int64_t& mtime)
+{
+    QFileInfo info(QString::fromStdString(path));
+    if (!info.exists() || !info.isFile()) {
+        return false;
+    }
+    size = info.size();
+    mtime = info.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+uint64_t ContentHasher::fileInode(const std::string& path)
+{
+#ifndef _WIN32
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) {
+        return static_cast<uint64_t>(st.st_ino);
+    }
+#else
+    Q_UNUSED(path);
+#endif
+    return 0;
+}
+
+FileFingerprint ContentHasher::fingerprint(const std::string& path)
+{
+    FileFingerprint fp;
+    fp.file_path = path;
+
+    if (!statFile(path, fp.size, fp.mtime)) {
+        return fp;
+    }
+    fp.inode = fileInode(path);
+
+    uint64_t digest = 0;
+    if (hashFile(path, digest)) {
+        fp.content_hash = toHex(digest);
+    }
+    return fp;
+}
+
+std::vector<FileFingerprint> ContentHasher::fingerprintFiles(const std::vector<std::string>& paths)
+{
+    QList<std::string> input(paths.begin(), paths.end());
+    QList<FileFingerprint> result = QtConcurrent::blockingMapped<QList<FileFingerprint>>(
+        input, [](const std::string& path) { return ContentHasher::fingerprint(path); });
+    return std::vector<FileFingerprint>(result.begin(), result.end());
+}
+
+std::string ContentHasher::toHex(uint64_t digest)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        hex[static_cast<size_t>(i)] = digits[digest & 0xF];
+        digest >>= 4;
+    }
+    return hex;
+}
@@ -0,0 +1,80 @@
+#ifndef CONTENTHASHER_H
+#define CONTENTHASHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Identity of a file on disk at one point in time
+ *
+ * Size and modification time are cheap to read and are compared first;
+ * the content hash is only needed when those differ.
+ */
+struct FileFingerprint {
+    std::string file_path;
+    int64_t size = 0;
+    int64_t mtime = 0;          // milliseconds since the epoch
+    uint64_t inode = 0;         // 0 where the filesystem has no inode numbers
+    std::string content_hash;   // 16 hex digits, empty if the file could not be read
+
+    bool valid() const { return !content_hash.empty(); }
+};
+
+/**
+ * @brief Streaming 64-bit content hasher (XXH64)
+ *
+ * Files are read through memory-mapped windows (QFile::map) so that
+ * multi-GB .g databases are hashed without ever being copied into a
+ * single buffer. Falls back to large buffered reads when mapping is not
+ * possible.
+ *
+ * Usage example:
+ *
+ * std::vector<FileFingerprint> prints = ContentHasher::fingerprintFiles(paths);
+ * for (const auto& fp : prints) {
+ *     if (fp.valid()) { ... fp.content_hash ... }
+ * }
+ */
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0);
+
+    void reset(uint64_t seed = 0);
+    void update(const void* data, size_t length);
+    uint64_t digest() const;
+
+    // Hash the full contents of a file, returns false if it cannot be read
+    static bool hashFile(const std::string& path, uint64_t& digest);
+
+    // Read size/mtime only, without touching the contents
+    static bool statFile(const std::string& path, int64_t& size, int64_t& mtime);
+
+    // Inode number on POSIX systems, 0 elsewhere or on error
+    static uint64_t fileInode(const std::string& path);
+
+    // Size, mtime, inode and content hash of a single file
+    static FileFingerprint fingerprint(const std::string& path);
+
+    /**
+     * @brief Fingerprints a batch of files in parallel
+     *
+     * Runs on the global Qt thread pool. The result is in the same order
+     * as the input paths; unreadable files yield an invalid fingerprint.
+     */
+    static std::vector<FileFingerprint> fingerprintFiles(const std::vector<std::string>& paths);
+
+    static std::string toHex(uint64_t digest);
+
+private:
+    void consumeStripe(const unsigned char* p);
+
+    uint64_t seed;
+    uint64_t v1, v2, v3, v4;
+    uint64_t totalLength;
+    unsigned char buffer[32];
+    size_t bufferSize;
+};
+
+#endif // CONTENTHASHER_H
@@ -0,0 +1,79 @@
+#include "DuplicateIndex.h"
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+void DuplicateIndex::addCatalog(const std::string& libraryName, Model* model)
+{
+    if (model) {
+        catalogs.push_back({ libraryName, model });
+    }
+}
+
+std::vector<DuplicateCluster> DuplicateIndex::fileClusters() const
+{
+    std::map<std::string, DuplicateCluster> byHash;
+
+    for (const auto& catalog : catalogs) {
+        for (const auto& modelData : catalog.model->getAllModels()) {
+            if (modelData.content_hash.empty()) {
+                continue;
+            }
+            DuplicateCluster& cluster = byHash[modelData.content_hash];
+            cluster.kind = DuplicateCluster::File;
+            cluster.hash = modelData.content_hash;
+            cluster.members.push_back({ catalog.libraryName, modelData.id, modelData.file_path, "" });
+        }
+    }
+
+    std::vector<DuplicateCluster> clusters;
+    for (auto& entry : byHash) {
+        if (entry.second.members.size() > 1) {
+            clusters.push_back(std::move(entry.second));
+        }
+    }
+    return clusters;
+}
+
+std::vector<DuplicateCluster> DuplicateIndex::assemblyClusters() const
+{
+    std::map<std::string, DuplicateCluster> byHash;
+
+    // A comb referenced from several parents appears once per reference
+    std::set<std::tuple<std::string, int, std::string>> seen;
+
+    for (const auto& catalog : catalogs) {
+        std::unordered_map<int, std::string> paths;
+        for (const auto& modelData : catalog.model->getAllModels()) {
+            paths[modelData.id] = modelData.file_path;
+        }
+
+        for (const auto& obj : catalog.model->getStructureHashedObjects()) {
+            if (!seen.insert(std::make_tuple(catalog.libraryName, obj.model_id, obj.name)).second) {
+                continue;
+            }
+            DuplicateCluster& cluster = byHash[obj.structure_hash];
+            cluster.kind = DuplicateCluster::Assembly;
+            cluster.hash = obj.structure_hash;
+            cluster.members.push_back({ catalog.libraryName, obj.model_id, paths[obj.model_id], obj.name });
+        }
+    }
+
+    std::vector<DuplicateCluster> clusters;
+    for (auto& entry : byHash) {
+        if (entry.second.members.size() > 1) {
+            clusters.push_back(std::move(entry.second));
+        }
+    }
+    return clusters;
+}
+
+std::vector<DuplicateCluster> DuplicateIndex::allClusters() const
+{
+    std::vector<DuplicateCluster> clusters = fileClusters();
+    std::vector<DuplicateCluster> assemblies = assemblyClusters();
+    clusters.insert(clusters.end(), assemblies.begin(), assemblies.end());
+    return clusters;
+}
@@ -0,0 +1,67 @@
+#ifndef DUPLICATEINDEX_H
+#define DUPLICATEINDEX_H
+
+#include <string>
+#include <vector>
+
+#include "Model.h"
+
+struct DuplicateMember {
+    std::string library_name;
+    int model_id = 0;
+    std::string file_path;
+    std::string object_name;    // empty for whole-file duplicates
+};
+
+struct DuplicateCluster {
+    enum Kind {
+        File,       // byte-identical .g files (content hash)
+        Assembly    // identical comb trees under any name (structure hash)
+    };
+
+    Kind kind = File;
+    std::string hash;
+    std::vector<DuplicateMember> members;
+};
+
+/**
+ * @brief Finds duplicate geometry across every registered library
+ *
+ * Built on demand from the catalogs' content hashes (models table) and
+ * the Merkle structure hashes ProcessGFiles stores for combinations
+ * (objects table). Only clusters with two or more members are returned.
+ * File > Find Duplicates shows them in a DuplicatesDialog.
+ *
+ * Only whole-file duplicates share indexing results (see
+ * ProcessGFiles::reuseDuplicate). Thumbnails, metrics and tags belong to
+ * a model, not to its objects, so identical sub-assemblies are reported
+ * here but each file containing one is still indexed on its own.
+ *
+ * Usage example:
+ *
+ * DuplicateIndex index;
+ * for (Library* lib : mainWindow->getLibraries()) {
+ *     index.addCatalog(lib->name(), lib->model);
+ * }
+ * for (const auto& cluster : index.fileClusters()) { ... }
+ */
+class DuplicateIndex {
+public:
+    void addCatalog(const std::string& libraryName, Model* model);
+
+    std::vector<DuplicateCluster> fileClusters() const;
+    std::vector<DuplicateCluster> assemblyClusters() const;
+
+    // File clusters first, then assembly clusters
+    std::vector<DuplicateCluster> allClusters() const;
+
+private:
+    struct Catalog {
+        std::string libraryName;
+        Model* model;
+    };
+
+    std::vector<Catalog> catalogs;
+};
+
+#endif // DUPLICATEINDEX_H
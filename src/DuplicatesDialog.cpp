@@ -0,0 +1,56 @@
+#include "DuplicatesDialog.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QTreeWidgetItem>
+#include <QVBoxLayout>
+
+DuplicatesDialog::DuplicatesDialog(const std::vector<DuplicateCluster>& clusters, QWidget* parent)
+    : QDialog(parent) {
+    setWindowTitle("Duplicates");
+    resize(720, 420);
+
+    treeWidget = new QTreeWidget();
+    treeWidget->setColumnCount(3);
+    treeWidget->setHeaderLabels({"File", "Library", "Object"});
+    treeWidget->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    treeWidget->setRootIsDecorated(true);
+
+    populateTreeWidget(clusters);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout();
+    mainLayout->addWidget(treeWidget);
+    mainLayout->addWidget(buttons);
+    setLayout(mainLayout);
+}
+
+void DuplicatesDialog::populateTreeWidget(const std::vector<DuplicateCluster>& clusters) {
+    if (clusters.empty()) {
+        QTreeWidgetItem* none = new QTreeWidgetItem({"No duplicates found"});
+        none->setFlags(Qt::NoItemFlags);
+        treeWidget->addTopLevelItem(none);
+        return;
+    }
+
+    for (const auto& cluster : clusters) {
+        const QString count = QString::number(cluster.members.size());
+        QTreeWidgetItem* clusterItem = new QTreeWidgetItem();
+        clusterItem->setText(0, cluster.kind == DuplicateCluster::File
+                                    ? count + " identical files"
+                                    : count + " identical sub-assemblies");
+        clusterItem->setToolTip(0, QString::fromStdString(cluster.hash));
+        for (const auto& member : cluster.members) {
+            QTreeWidgetItem* memberItem = new QTreeWidgetItem(clusterItem);
+            memberItem->setText(0, QString::fromStdString(member.file_path));
+            memberItem->setToolTip(0, QString::fromStdString(member.file_path));
+            memberItem->setText(1, QString::fromStdString(member.library_name));
+            memberItem->setText(2, QString::fromStdString(member.object_name));
+        }
+        treeWidget->addTopLevelItem(clusterItem);
+    }
+    treeWidget->expandAll();
+    treeWidget->resizeColumnToContents(1);
+}
@@ -0,0 +1,28 @@
+#ifndef DUPLICATESDIALOG_H
+#define DUPLICATESDIALOG_H
+
+#include <QDialog>
+#include <QTreeWidget>
+#include <vector>
+#include "DuplicateIndex.h"
+
+/**
+ * @brief Lists what DuplicateIndex found, one expandable row per cluster
+ *
+ * Each cluster shows its members with their library, file and, for
+ * identical sub-assemblies, the object name. Read-only.
+ */
+class DuplicatesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    DuplicatesDialog(const std::vector<DuplicateCluster>& clusters, QWidget* parent = nullptr);
+    QTreeWidget* getTreeWidget() const { return treeWidget; }
+
+private:
+    void populateTreeWidget(const std::vector<DuplicateCluster>& clusters);
+
+    QTreeWidget* treeWidget;
+};
+
+#endif // DUPLICATESDIALOG_H
@@ -1,4 +1,5 @@
 #include "FileSystemModelWithCheckboxes.h"
+#include "LibraryScanner.h"
 
 #include <QDir>
 #include <QDebug>
@@ -41,6 +42,13 @@ void FileSystemModelWithCheckboxes::initializeCheckStates(const QModelIndex& par
                 std::string filePathStd = QDir::cleanPath(path).toStdString();
                 ModelData modelData = model->getModelByFilePath(filePathStd);
 
+                if (modelData.id == 0)
+                {
+                    // A cataloged file that was moved or renamed keeps its row
+                    LibraryScanner scanner(model, rootPath.toStdString());
+                    modelData = scanner.detectMove(filePathStd);
+                }
+
                 if (modelData.id == 0)
                 {
                     // Model not found in database, create a new one
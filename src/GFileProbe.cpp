@@ -0,0 +1,262 @@
+#include "GFileProbe.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// On-disk layout of a v5 object header, see BRL-CAD's db5.h
+const unsigned char DB5_MAGIC1 = 0x76;
+const unsigned char DB5_MAGIC2 = 0x35;
+const unsigned char HFLAGS_DLI_MASK = 0x03;
+const unsigned char HFLAGS_DLI_APPLICATION_DATA = 0;
+const unsigned char HFLAGS_DLI_HEADER_OBJECT = 1;
+const unsigned char HFLAGS_NAME_PRESENT = 0x20;
+const unsigned char HFLAGS_NAME_WIDTH_MASK = 0x18;
+const int HFLAGS_NAME_WIDTH_SHIFT = 3;
+const unsigned char HFLAGS_OBJECT_WIDTH_MASK = 0xc0;
+const int HFLAGS_OBJECT_WIDTH_SHIFT = 6;
+const unsigned char FLAGS_ZZZ_MASK = 0x07;     // compression, a- and bflags
+const unsigned char FLAGS_PRESENT = 0x20;
+const unsigned char FLAGS_WIDTH_MASK = 0xc0;
+const int FLAGS_WIDTH_SHIFT = 6;
+const size_t DB5_FIXED_HEADER = 6;              // magic1 .. minor type
+const size_t DB5_MAJOR_TYPE = 4;
+const size_t DB5_MINOR_TYPE = 5;
+const unsigned char MAJORTYPE_BRLCAD = 1;
+
+// BRL-CAD minor types, see BRL-CAD's rt/defines.h
+const unsigned char MINORTYPE_COMBINATION = 31;
+
+// Primitives whose cost grows with their data rather than their count
+bool isMeshType(unsigned char minorType)
+{
+    switch (minorType) {
+    case 5:     // ARS
+    case 9:     // B-spline
+    case 11:    // NMG
+    case 12:    // EBM
+    case 13:    // VOL
+    case 24:    // HF
+    case 25:    // DSP
+    case 30:    // BoT
+    case 36:    // metaball
+    case 37:    // B-rep
+        return true;
+    default:
+        return false;
+    }
+}
+
+// v4 databases start with an ident record: id, units, version, title
+const unsigned char DB4_ID_IDENT = 'I';
+const size_t DB4_TITLE_OFFSET = 8;
+const size_t DB4_TITLE_LENGTH = 72;
+
+const char* const GLOBAL_OBJECT = "_GLOBAL";
+
+// Big-endian length of 1, 2, 4 or 8 bytes; false past the end
+bool decodeLength(const unsigned char*& p, const unsigned char* end, int widthCode, uint64_t& value)
+{
+    const size_t width = size_t(1) << widthCode;
+    if (static_cast<size_t>(end - p) < width) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value = (value << 8) | p[i];
+    }
+    p += width;
+    return true;
+}
+
+// Attributes are "key\0value\0...\0"
+std::string attributeValue(const unsigned char* p, size_t length, const char* key)
+{
+    const char* text = reinterpret_cast<const char*>(p);
+    size_t offset = 0;
+    while (offset < length) {
+        const char* name = text + offset;
+        size_t nameLength = strnlen(name, length - offset);
+        if (nameLength == 0 || offset + nameLength + 1 >= length) {
+            break;
+        }
+        const char* value = name + nameLength + 1;
+        size_t valueLength = strnlen(value, length - offset - nameLength - 1);
+        if (std::strcmp(name, key) == 0 && nameLength == std::strlen(key)) {
+            return std::string(value, valueLength);
+        }
+        offset += nameLength + 1 + valueLength + 1;
+    }
+    return std::string();
+}
+
+// _GLOBAL stores units as the millimeters per local unit
+std::string unitsName(const std::string& factor)
+{
+    if (factor.empty()) {
+        return factor;
+    }
+    char* end = nullptr;
+    double value = std::strtod(factor.c_str(), &end);
+    if (end == factor.c_str()) {
+        return factor;
+    }
+    static const struct { const char* name; double mm; } known[] = {
+        { "um", 0.001 }, { "mm", 1.0 }, { "cm", 10.0 }, { "m", 1000.0 }, { "km", 1000000.0 },
+        { "in", 25.4 }, { "ft", 304.8 }, { "yd", 914.4 }, { "mi", 1609344.0 }
+    };
+    for (const auto& unit : known) {
+        if (std::fabs(value - unit.mm) <= unit.mm * 1e-9) {
+            return unit.name;
+        }
+    }
+    return factor;
+}
+
+GFileHeader parseV4(const unsigned char* data, size_t size)
+{
+    GFileHeader header;
+    header.db_version = 4;
+    if (size >= DB4_TITLE_OFFSET + DB4_TITLE_LENGTH) {
+        const char* title = reinterpret_cast<const char*>(data + DB4_TITLE_OFFSET);
+        header.title.assign(title, strnlen(title, DB4_TITLE_LENGTH));
+    }
+    header.ok = true;
+    return header;
+}
+
+GFileHeader parseV5(const unsigned char* data, size_t size)
+{
+    GFileHeader header;
+    header.db_version = 5;
+    header.object_count = 0;
+    header.comb_count = 0;
+    header.mesh_count = 0;
+    header.mesh_bytes = 0;
+
+    const unsigned char* const end = data + size;
+    const unsigned char* object = data;
+    while (object < end) {
+        if (static_cast<size_t>(end - object) < DB5_FIXED_HEADER + 1 || object[0] != DB5_MAGIC1) {
+            qDebug() << "[GFileProbe::parse] Bad object header at offset" << (object - data);
+            return header;
+        }
+        const unsigned char hflags = object[1];
+        const unsigned char aflags = object[2];
+
+        const unsigned char* p = object + DB5_FIXED_HEADER;
+        uint64_t objectLength = 0;
+        if (!decodeLength(p, end, (hflags & HFLAGS_OBJECT_WIDTH_MASK) >> HFLAGS_OBJECT_WIDTH_SHIFT, objectLength)) {
+            return header;
+        }
+        // Lengths count 8-byte units
+        objectLength <<= 3;
+        if (objectLength == 0 || objectLength > static_cast<uint64_t>(end - object) ||
+            object[objectLength - 1] != DB5_MAGIC2) {
+            qDebug() << "[GFileProbe::parse] Bad object length at offset" << (object - data);
+            return header;
+        }
+        const unsigned char* const objectEnd = object + objectLength;
+
+        const unsigned char dli = hflags & HFLAGS_DLI_MASK;
+        if (dli == HFLAGS_DLI_APPLICATION_DATA && (hflags & HFLAGS_NAME_PRESENT)) {
+            uint64_t nameLength = 0;
+            if (!decodeLength(p, objectEnd, (hflags & HFLAGS_NAME_WIDTH_MASK) >> HFLAGS_NAME_WIDTH_SHIFT, nameLength) ||
+                nameLength > static_cast<uint64_t>(objectEnd - p)) {
+                return header;
+            }
+            const char* name = reinterpret_cast<const char*>(p);
+            const bool isGlobal = nameLength == std::strlen(GLOBAL_OBJECT) + 1 &&
+                std::memcmp(name, GLOBAL_OBJECT, nameLength) == 0;
+            p += nameLength;
+
+            if (!isGlobal) {
+                header.object_count++;
+                if (object[DB5_MAJOR_TYPE] == MAJORTYPE_BRLCAD) {
+                    if (object[DB5_MINOR_TYPE] == MINORTYPE_COMBINATION) {
+                        header.comb_count++;
+                    }
+                    else if (isMeshType(object[DB5_MINOR_TYPE])) {
+                        header.mesh_count++;
+                        header.mesh_bytes += static_cast<int64_t>(objectLength);
+                    }
+                }
+            }
+            else if ((aflags & FLAGS_PRESENT) && (aflags & FLAGS_ZZZ_MASK) == 0) {
+                uint64_t attributesLength = 0;
+                if (decodeLength(p, objectEnd, (aflags & FLAGS_WIDTH_MASK) >> FLAGS_WIDTH_SHIFT, attributesLength) &&
+                    attributesLength <= static_cast<uint64_t>(objectEnd - p)) {
+                    header.title = attributeValue(p, static_cast<size_t>(attributesLength), "title");
+                    header.units = unitsName(attributeValue(p, static_cast<size_t>(attributesLength), "units"));
+                }
+            }
+        }
+        else if (dli == HFLAGS_DLI_HEADER_OBJECT && object != data) {
+            qDebug() << "[GFileProbe::parse] Unexpected header object at offset" << (object - data);
+            return header;
+        }
+
+        object = objectEnd;
+    }
+
+    header.ok = true;
+    return header;
+}
+
+}
+
+GFileHeader GFileProbe::parse(const unsigned char* data, size_t size)
+{
+    if (!data || size == 0) {
+        return GFileHeader();
+    }
+    // Every v5 database opens with the 8-byte free-standing header object
+    if (size >= 8 && data[0] == DB5_MAGIC1 && data[7] == DB5_MAGIC2 &&
+        (data[1] & HFLAGS_DLI_MASK) == HFLAGS_DLI_HEADER_OBJECT) {
+        return parseV5(data, size);
+    }
+    if (data[0] == DB4_ID_IDENT) {
+        return parseV4(data, size);
+    }
+    return GFileHeader();
+}
+
+GFileHeader GFileProbe::probe(const std::string& path)
+{
+    GFileHeader header;
+
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "[GFileProbe::probe] Could not open" << QString::fromStdString(path);
+        header.file_path = path;
+        return header;
+    }
+
+    const qint64 size = file.size();
+    uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (!mapped) {
+        // Left to the full extraction; the probe is only a head start
+        qDebug() << "[GFileProbe::probe] Could not map" << QString::fromStdString(path);
+        header.file_path = path;
+        return header;
+    }
+
+    header = parse(mapped, static_cast<size_t>(size));
+    header.file_path = path;
+    file.unmap(mapped);
+    return header;
+}
+
+std::vector<GFileHeader> GFileProbe::probeFiles(const std::vector<std::string>& paths)
+{
+    QList<std::string> input(paths.begin(), paths.end());
+    QList<GFileHeader> result = QtConcurrent::blockingMapped<QList<GFileHeader>>(
+        input, [](const std::string& path) { return GFileProbe::probe(path); });
+    return std::vector<GFileHeader>(result.begin(), result.end());
+}
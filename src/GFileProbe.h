@@ -0,0 +1,59 @@
+#ifndef GFILEPROBE_H
+#define GFILEPROBE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What a .g file's headers say about it, read without librt
+ */
+struct GFileHeader {
+    std::string file_path;
+    bool ok = false;
+    int db_version = 0;         // 4 or 5; 0 if the file is not a database
+    std::string title;
+    std::string units;          // "mm", "in", ... or the raw factor; empty if unset
+    int64_t object_count = -1;  // named objects as "ls -a" lists them; -1 if unknown
+
+    // Primitive mix, v5 only; -1 if unknown
+    int64_t comb_count = -1;    // combinations, regions included
+    int64_t mesh_count = -1;    // BoTs, NMG, B-rep, volumes: slow to prep and shoot
+    int64_t mesh_bytes = -1;    // their size on disk
+};
+
+/**
+ * @brief Fast first look at BRL-CAD databases
+ *
+ * Opening a database through ged_open builds its whole in-memory
+ * directory. The probe instead maps the file and walks the v5 object
+ * headers: it reads the _GLOBAL object's attributes for title and units
+ * and counts named objects by kind, touching only the pages that hold
+ * headers.
+ * For v4 databases only the title from the ident record is read.
+ *
+ * Usage example:
+ *
+ * std::vector<GFileHeader> headers = GFileProbe::probeFiles(paths);
+ * for (const auto& header : headers) {
+ *     if (header.ok) { ... header.title ... }
+ * }
+ */
+class GFileProbe {
+public:
+    static GFileHeader probe(const std::string& path);
+
+    // Parses a database image already in memory
+    static GFileHeader parse(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Probes a batch of files in parallel
+     *
+     * Runs on the global Qt thread pool; the result is in the same order
+     * as the input paths.
+     */
+    static std::vector<GFileHeader> probeFiles(const std::vector<std::string>& paths);
+};
+
+#endif // GFILEPROBE_H
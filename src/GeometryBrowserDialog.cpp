@@ -11,6 +11,7 @@
 #include <array>
 #include <regex>
 #include <sstream>
+#include <unordered_map>
 
 GeometryBrowserDialog::GeometryBrowserDialog(int modelId, Model* model, QWidget* parent)
     : QDialog(parent), modelId(modelId), model(model) {
@@ -40,81 +41,47 @@ GeometryBrowserDialog::GeometryBrowserDialog(int modelId, Model* model, QWidget*
 
 void GeometryBrowserDialog::loadObjects() {
     // Get the objects from the model
-    std::vector<ObjectData> objects = model->getObjectsForModel(modelId);
-
-    // Build the geometryData map and objectNameToIdMap
-    for (const auto& obj : objects) {
-        objectNameToIdMap[obj.name] = obj.object_id;
-
-        if (obj.parent_object_id == -1) {
-            geometryData[obj.name] = std::vector<std::string>();
-        } else {
-            std::string parentName;
-            for (const auto& potentialParent : objects) {
-                if (potentialParent.object_id == obj.parent_object_id) {
-                    parentName = potentialParent.name;
-                    break;
-                }
-            }
-            if (!parentName.empty()) {
-                geometryData[parentName].push_back(obj.name);
-            } else {
-                // handle missing parent
-                geometryData[obj.name] = std::vector<std::string>();
-            }
-        }
-    }
+    objects = model->getObjectsForModel(modelId);
 }
 
 void GeometryBrowserDialog::populateTreeWidget() {
     QIcon folderClosedIcon = QApplication::style()->standardIcon(QStyle::SP_DirClosedIcon);
     QIcon fileIcon = QApplication::style()->standardIcon(QStyle::SP_FileIcon);
 
-    // map object names to their selection state
-    std::map<std::string, bool> objectSelectionMap;
-    for (const auto& [name, id] : objectNameToIdMap) {
-        ObjectData objData = model->getObjectById(id);
-        objectSelectionMap[name] = objData.is_selected;
-    }
-
-    // create a mapping from object name to QTreeWidgetItem
-    std::map<std::string, QTreeWidgetItem*> itemMap;
-
-    // create all items
-    for (const auto& [name, _] : objectNameToIdMap) {
+    // create all items, keyed by object id; names repeat in shared subtrees
+    std::unordered_map<int, QTreeWidgetItem*> itemMap;
+    itemMap.reserve(objects.size());
+    std::vector<QTreeWidgetItem*> items;
+    items.reserve(objects.size());
+    for (const auto& obj : objects) {
         QTreeWidgetItem* item = new QTreeWidgetItem();
-        item->setText(0, QString::fromStdString(name));
-        item->setCheckState(0, objectSelectionMap[name] ? Qt::Checked : Qt::Unchecked);
+        item->setText(0, QString::fromStdString(obj.name));
+        item->setData(0, Qt::UserRole, obj.object_id);
+        item->setCheckState(0, obj.is_selected ? Qt::Checked : Qt::Unchecked);
 
-        itemMap[name] = item;
+        itemMap[obj.object_id] = item;
+        items.push_back(item);
     }
 
-    // set up hierarchy
-    for (const auto& [parentName, childrenNames] : geometryData) {
-        QTreeWidgetItem* parentItem = itemMap[parentName];
-        for (const auto& childName : childrenNames) {
-            QTreeWidgetItem* childItem = itemMap[childName];
-            parentItem->addChild(childItem);
+    // set up hierarchy; objects whose parent is missing become top-level
+    QList<QTreeWidgetItem*> topLevelItems;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        auto parent = itemMap.find(objects[i].parent_object_id);
+        if (parent != itemMap.end() && parent->second != items[i]) {
+            parent->second->addChild(items[i]);
+        } else {
+            topLevelItems.append(items[i]);
         }
     }
+    treeWidget->addTopLevelItems(topLevelItems);
 
-    // add top-level items to the tree widget
-    for (const auto& [name, item] : itemMap) {
-        if (geometryData.find(name) != geometryData.end()) {
-            if (!item->parent()) {
-                treeWidget->addTopLevelItem(item);
-            }
-            item->setIcon(0, folderClosedIcon);
-        } else {
-            if (!item->parent()) {
-                treeWidget->addTopLevelItem(item);
-            }
-            item->setIcon(0, fileIcon);
-        }
+    for (QTreeWidgetItem* item : items) {
+        item->setIcon(0, item->childCount() > 0 ? folderClosedIcon : fileIcon);
     }
 
-    // expand all items
-    treeWidget->expandAll();
+    // expand the top-level objects and their members; deeper assemblies
+    // open on demand, which keeps huge models responsive
+    treeWidget->expandToDepth(1);
 }
 
 void GeometryBrowserDialog::onItemChanged(QTreeWidgetItem* item, int column) {
@@ -124,11 +91,9 @@ void GeometryBrowserDialog::onItemChanged(QTreeWidgetItem* item, int column) {
     if (isUpdatingCheckState)
         return;
 
-    QString itemName = item->text(0);
-    std::string objectName = itemName.toStdString();
-
-    if (objectNameToIdMap.find(objectName) != objectNameToIdMap.end()) {
-        int objectId = objectNameToIdMap[objectName];
+    QVariant objectIdData = item->data(0, Qt::UserRole);
+    if (objectIdData.isValid()) {
+        int objectId = objectIdData.toInt();
         bool isSelected = (item->checkState(0) == Qt::Checked);
 
         // begin updating check states
@@ -162,11 +127,9 @@ void GeometryBrowserDialog::uncheckItemRecursively(QTreeWidgetItem* item, QTreeW
         item->setCheckState(0, Qt::Unchecked);
 
         // update the model's selection state
-        QString itemName = item->text(0);
-        std::string objectName = itemName.toStdString();
-        if (objectNameToIdMap.find(objectName) != objectNameToIdMap.end()) {
-            int objectId = objectNameToIdMap[objectName];
-            model->setObjectData(objectId, false, Model::IsSelectedRole);
+        QVariant objectIdData = item->data(0, Qt::UserRole);
+        if (objectIdData.isValid()) {
+            model->setObjectData(objectIdData.toInt(), false, Model::IsSelectedRole);
         }
     }
 
@@ -3,7 +3,7 @@
 
 #include <QDialog>
 #include <QTreeWidget>
-#include <map>
+#include <vector>
 #include "Model.h"
 
 class GeometryBrowserDialog : public QDialog {
@@ -26,11 +26,9 @@ private:
     Model* model;
     QTreeWidget* treeWidget;
 
-    // map object names to their IDs
-    std::map<std::string, int> objectNameToIdMap;
-
-    // map parent object names to their children's names
-    std::map<std::string, std::vector<std::string>> geometryData;
+    // objects of the model, parents before children; an object used in
+    // several assemblies appears once per use, each with its own id
+    std::vector<ObjectData> objects;
 
     bool isUpdatingCheckState = false;
 };
@@ -0,0 +1,37 @@
+#ifndef GEOMETRYMETRICS_H
+#define GEOMETRYMETRICS_H
+
+#include <map>
+#include <string>
+
+/**
+ * @brief What ProcessGFiles learns about a model's geometry
+ *
+ * Counts and tree depth cover the whole database and are read during
+ * extraction. The bounding box, volume and surface area are ray-sampled
+ * during the full render, on the object the thumbnail shows: rays on a jittered grid are shot from many directions spread
+ * over the sphere, volume follows from the lengths inside the geometry
+ * and surface area from the number of surface crossings (Cauchy-Crofton).
+ * Each estimate carries the half-width of its 95% confidence interval,
+ * taken from the spread between directions.
+ *
+ * Lengths are in millimeters, BRL-CAD's base unit. Values that were not
+ * measured are -1.
+ */
+struct GeometryMetrics {
+    int primitive_count = -1;
+    int region_count = -1;
+    int comb_count = -1;
+    int tree_depth = -1;                        // a lone primitive is 1
+    std::map<std::string, int> primitive_types; // librt type label ("arb8", "bot", ...) to count
+
+    bool sampled = false;                       // the fields below are set
+    double bbox_min[3] = { 0.0, 0.0, 0.0 };
+    double bbox_max[3] = { 0.0, 0.0, 0.0 };
+    double volume = -1.0;                       // mm^3
+    double volume_error = -1.0;
+    double surface_area = -1.0;                 // mm^2
+    double surface_area_error = -1.0;
+};
+
+#endif // GEOMETRYMETRICS_H
@@ -1,11 +1,81 @@
 #include "IndexingWorker.h"
+#include "BackgroundMode.h"
+#include "BoundedQueue.h"
+#include "MemoryBudget.h"
 #include "ProcessGFiles.h"
+#include "ProgressBatcher.h"
+#include "ReadAhead.h"
+#include "RenderCostModel.h"
+#include "StageTime.h"
+#include "WorkerProcess.h"
 #include "Model.h"
 #include <QDebug>
+#include <QSettings>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// File headers and size/mtime/content hash of a set of models
+struct PreparedModels {
+    std::vector<ModelData> models;
+    std::vector<GFileHeader> headers;
+    std::vector<FileFingerprint> fingerprints;
+};
+
+/*
+ * Reads the headers and fingerprints in parallel and fills them into
+ * models. Nothing is written to the catalog, so any thread may call it;
+ * the catalog's writer stores the result with storePreparation.
+ */
+PreparedModels prepareModels(std::vector<ModelData>& models) {
+    std::vector<std::string> paths;
+    paths.reserve(models.size());
+    for (const auto& modelData : models) {
+        paths.push_back(modelData.file_path);
+    }
+
+    PreparedModels preparation;
+    preparation.headers = GFileProbe::probeFiles(paths);
+    preparation.fingerprints = ContentHasher::fingerprintFiles(paths);
+    for (size_t i = 0; i < models.size(); ++i) {
+        const FileFingerprint& fingerprint = preparation.fingerprints[i];
+        if (fingerprint.valid()) {
+            // Lets the processor spot exact copies it has already handled
+            models[i].content_hash = fingerprint.content_hash;
+            models[i].file_size = fingerprint.size;
+        }
+        // Size and primitive mix drive the render cost estimate
+        const GFileHeader& header = preparation.headers[i];
+        if (header.ok) {
+            models[i].db_version = header.db_version;
+            models[i].object_count = header.object_count;
+            models[i].comb_count = header.comb_count;
+            models[i].mesh_count = header.mesh_count;
+            models[i].mesh_bytes = header.mesh_bytes;
+        }
+    }
+    preparation.models = models;
+    return preparation;
+}
+
+// Titles and object counts show in the library long before extraction
+// gets to each file
+void storePreparation(Model* model, const PreparedModels& preparation) {
+    model->storeHeaders(preparation.models, preparation.headers);
+    model->storeFingerprints(preparation.models, preparation.fingerprints);
+}
+
+}
+
 IndexingWorker::IndexingWorker(Library* library, QObject* parent)
     : QObject(parent),
     library(library),
@@ -30,14 +100,15 @@ void IndexingWorker::process() {
         // Reset reindex request for this iteration
         m_reindexRequested.store(false);
 
-        ProcessGFiles processor(library->model);
-
         // Retrieve models that need processing
         std::vector<ModelData> modelsToProcess = library->model->getIncludedNotProcessedModels();
         int totalFiles = modelsToProcess.size();
-        int processedFiles = 0;
 
         if (totalFiles == 0) {
+            // An earlier run may have been interrupted before its full renders
+            if (progressivePreviews() && !m_stopRequested.load()) {
+                refineThumbnails(renderWorkerCount());
+            }
             emit progressUpdated("No files to process", 100);
             // If no models to process, check if reindex was requested
             if (!m_reindexRequested.load()) {
@@ -49,20 +120,15 @@ void IndexingWorker::process() {
             continue;
         }
 
-        for (const auto& modelData : modelsToProcess) {
-            if (m_stopRequested.load()) {
-                qDebug() << "IndexingWorker::process() stopping due to stop request";
-                break;
-            }
-            int percentage = (processedFiles * 100) / totalFiles;
+        // No pipeline runs yet, so this thread is the catalog's only writer
+        emit progressUpdated("Reading file headers", 0);
+        storePreparation(library->model, prepareModels(modelsToProcess));
 
-            // Emit progress signal before processing the file
-            QString currentObject = QString::fromStdString(modelData.short_name);
-            emit progressUpdated(currentObject, percentage);
-            emit modelProcessed(modelData.id);
+        processBatch(modelsToProcess, workerCount(), renderWorkerCount());
 
-            processor.processGFile(modelData);
-            processedFiles++;
+        // Full renders only once every model has at least a coarse preview
+        if (progressivePreviews() && !m_stopRequested.load()) {
+            refineThumbnails(renderWorkerCount());
         }
 
         // Emit final progress signal to indicate completion
@@ -76,3 +142,556 @@ void IndexingWorker::process() {
         }
     }
 }
+
+int IndexingWorker::workerCount() const {
+    QSettings settings;
+    int threads = settings.value("indexingThreads", QThread::idealThreadCount()).toInt();
+
+    // Each worker holds a librt resource slot; stay well below MAX_PSW
+    return std::clamp(threads, 1, 64);
+}
+
+int IndexingWorker::renderWorkerCount() const {
+    QSettings settings;
+    int threads = settings.value("renderThreads", std::max(1, QThread::idealThreadCount() / 2)).toInt();
+    return std::clamp(threads, 1, 64);
+}
+
+bool IndexingWorker::progressivePreviews() const {
+    QSettings settings;
+    return settings.value("progressivePreviews", true).toBool();
+}
+
+namespace {
+
+// Oversize files waiting for the serial lane before extraction stalls
+const size_t SERIAL_LANE_CAPACITY = 16;
+
+// What the writer receives: a finished (or failed) extraction or render,
+// or the headers and fingerprints of files that joined the batch
+struct PersistJob {
+    enum Kind { Extraction, Render, Preparation };
+    Kind kind = Extraction;
+    std::string name;
+    ExtractionResult extraction;
+    RenderResult render;
+    PreparedModels preparation;
+};
+
+}
+
+void IndexingWorker::processBatch(const std::vector<ModelData>& modelsToProcess, int extractWorkers, int renderWorkers) {
+    ProcessingQueue* queue = library->queue;
+    QSettings settings;
+    queue->setAgingRate(settings.value("queueAgingRate", 1.0).toDouble());
+
+    // Cheap files first, so the library fills in quickly
+    RenderCostModel costs;
+    costs.calibrate(library->model->getRenderTimings());
+    qDebug() << "IndexingWorker::processBatch() render speed factor" << costs.speedFactor()
+        << "from" << costs.samples() << "recorded renders";
+    for (const auto& modelData : modelsToProcess) {
+        queue->enqueue(modelData, ProcessingQueue::Background, costs.estimate(modelData));
+    }
+
+    // Cold files of the next few models are read while this one is parsed
+    ReadAhead readAhead;
+    readAhead.prefetch(queue->peek(static_cast<size_t>(readAhead.depth())));
+
+    // Grows when newly included files join the running batch. The pools
+    // are not sized to it: idle workers wait on the queue for those files.
+    std::atomic<int> totalFiles(static_cast<int>(modelsToProcess.size()));
+    extractWorkers = std::max(1, extractWorkers);
+    renderWorkers = std::max(1, renderWorkers);
+
+    qDebug() << "IndexingWorker::processBatch() using" << extractWorkers << "extract and"
+        << renderWorkers << "render workers for" << totalFiles << "files";
+
+    // Renders are the slow stage; let extraction stay a little ahead of them
+    BoundedQueue<ExtractionResult> renderQueue(static_cast<size_t>(renderWorkers) * 2);
+    BoundedQueue<PersistJob> persistQueue(static_cast<size_t>(extractWorkers + renderWorkers) * 2);
+
+    // Models persisted in full; the share of totalFiles is the progress
+    std::atomic<int> completed(0);
+    std::atomic<int> activeExtractors(extractWorkers);
+    // The serial lane delivers renders too
+    std::atomic<int> activeRenderers(renderWorkers + 1);
+
+    // Models handed to a worker in this batch; they stay unprocessed in
+    // the catalog until persisted, or for good if extraction fails
+    std::mutex takenMutex;
+    std::set<int> taken;
+    for (const auto& modelData : modelsToProcess) {
+        taken.insert(modelData.id);
+    }
+
+    // A reindex request while the batch runs (files were included) adds
+    // the new models to the queue instead of waiting for the next batch
+    auto refill = [&]() {
+        if (!m_reindexRequested.exchange(false)) {
+            return;
+        }
+        std::vector<ModelData> added;
+        {
+            std::lock_guard<std::mutex> lock(takenMutex);
+            for (auto& modelData : library->model->getIncludedNotProcessedModels()) {
+                if (taken.insert(modelData.id).second) {
+                    added.push_back(std::move(modelData));
+                }
+            }
+        }
+        if (added.empty()) {
+            return;
+        }
+        // Read here, stored by the writer before any result for these
+        // models, which are only queued after it
+        PersistJob prepared;
+        prepared.kind = PersistJob::Preparation;
+        prepared.preparation = prepareModels(added);
+        persistQueue.push(std::move(prepared));
+        for (const auto& modelData : added) {
+            queue->enqueue(modelData, ProcessingQueue::NewlyIncluded, costs.estimate(modelData));
+        }
+        totalFiles.fetch_add(static_cast<int>(added.size()));
+        qDebug() << "IndexingWorker::processBatch() queued" << added.size() << "newly included files";
+    };
+
+    // "isolatedWorkers": each pipeline thread hands its files to a helper
+    // process of its own instead of opening them here
+    const bool isolated = WorkerProcess::enabled();
+
+    // Every open and render reserves its expected peak memory first;
+    // files too big to share the budget go to a serial lane
+    MemoryBudget& memory = MemoryBudget::shared();
+    BoundedQueue<ModelData> serialLane(SERIAL_LANE_CAPACITY);
+    auto stopped = [this]() { return m_stopRequested.load(); };
+
+    // "backgroundMode": pipeline threads run at idle priority, and all
+    // but the first worker of each stage pause while the machine is busy
+    const bool background = BackgroundMode::enabled();
+    auto waitForTurn = [&](int slot) {
+        return !background || BackgroundMode::shared().waitForTurn(slot, stopped);
+    };
+
+    // Progress reaches the UI in batches, whichever thread has news
+    ProgressBatcher batcher;
+    auto announce = [&](const ModelData& modelData) {
+        if (batcher.progress(modelData.short_name, (completed.load() * 100) / totalFiles.load())) {
+            sendProgress(batcher, false);
+        }
+    };
+
+    // Helpers only see files that need opening
+    auto extractModel = [&](ProcessGFiles& processor, WorkerProcess* helper, const ModelData& modelData,
+                            const MemoryReservation& reservation) {
+        ExtractionResult extraction;
+        if (!helper) {
+            extraction = processor.extract(modelData);
+            extraction.peakRss = reservation.peakRssAlone();
+        }
+        else if (!processor.reuseDuplicate(modelData, extraction)
+                 && !processor.resumeExtraction(modelData, extraction)) {
+            helper->extract(modelData, extraction);
+        }
+        return extraction;
+    };
+
+    // What the render stage needs of a finished extraction, if anything
+    auto renderJobFor = [&](const ExtractionResult& extraction, ExtractionResult& renderJob) {
+        if (!extraction.ok || extraction.duplicateOf != 0 || extraction.thumbnailObject.empty()) {
+            return false;
+        }
+        renderJob.modelData = extraction.modelData;
+        renderJob.thumbnailObject = extraction.thumbnailObject;
+        renderJob.renderCost = costs.estimate(extraction.modelData);
+        renderJob.ok = true;
+        return true;
+    };
+
+    const bool coarse = progressivePreviews();
+
+    auto renderModel = [&](ProcessGFiles& processor, WorkerProcess* helper, const ExtractionResult& extraction,
+                           const MemoryReservation& reservation) {
+        RenderResult render;
+        if (!helper) {
+            render = processor.render(extraction, coarse);
+            render.peakRss = reservation.peakRssAlone();
+        }
+        else {
+            // A crash or timeout reads as a failed render, which backs
+            // the model off until a retry
+            helper->render(extraction, coarse, render);
+        }
+        return render;
+    };
+
+    // Each worker owns a ProcessGFiles, and so a librt resource; worker
+    // indices stay unique across both stages
+    auto extractWork = [&](int workerIndex) {
+        if (background) {
+            BackgroundMode::lowerCurrentThread();
+        }
+        ProcessGFiles processor(library->model, workerIndex);
+        std::unique_ptr<WorkerProcess> helper;
+        if (isolated) {
+            helper = std::make_unique<WorkerProcess>();
+        }
+
+        ModelData modelData;
+        while (!m_stopRequested.load()) {
+            if (!waitForTurn(workerIndex)) {
+                break;
+            }
+            refill();
+            if (!queue->pop(modelData)) {
+                break;
+            }
+            readAhead.prefetch(queue->peek(static_cast<size_t>(readAhead.depth())));
+
+            // Exact copies need neither the file nor memory
+            PersistJob job;
+            job.name = modelData.short_name;
+            if (processor.reuseDuplicate(modelData, job.extraction)) {
+                announce(modelData);
+                persistQueue.push(std::move(job));
+                continue;
+            }
+
+            const int64_t need = MemoryBudget::estimate(modelData);
+            if (memory.isOversize(need)) {
+                serialLane.push(modelData);
+                continue;
+            }
+            announce(modelData);
+            {
+                MemoryReservation reservation(memory, need, stopped);
+                if (!reservation.admitted()) {
+                    break;
+                }
+                job.extraction = extractModel(processor, helper.get(), modelData, reservation);
+            }
+
+            // Queued for the writer before the render so the objects and
+            // title always land ahead of the thumbnail; a failure is
+            // recorded there so the model backs off
+            ExtractionResult renderJob;
+            bool needsRender = renderJobFor(job.extraction, renderJob);
+            persistQueue.push(std::move(job));
+            if (needsRender) {
+                renderQueue.push(std::move(renderJob));
+            }
+        }
+
+        if (activeExtractors.fetch_sub(1) == 1) {
+            renderQueue.close();
+            serialLane.close();
+        }
+    };
+
+    auto renderWork = [&](int workerIndex) {
+        if (background) {
+            BackgroundMode::lowerCurrentThread();
+        }
+        ProcessGFiles processor(library->model, workerIndex);
+        std::unique_ptr<WorkerProcess> helper;
+        if (isolated) {
+            helper = std::make_unique<WorkerProcess>();
+        }
+
+        ExtractionResult extraction;
+        while (renderQueue.pop(extraction)) {
+            // Drain without rendering; the models stay unprocessed
+            if (m_stopRequested.load() || !waitForTurn(workerIndex - extractWorkers)) {
+                continue;
+            }
+            PersistJob job;
+            job.kind = PersistJob::Render;
+            job.name = extraction.modelData.short_name;
+            {
+                MemoryReservation reservation(memory, MemoryBudget::estimate(extraction.modelData), stopped);
+                if (!reservation.admitted()) {
+                    continue;
+                }
+                job.render = renderModel(processor, helper.get(), extraction, reservation);
+            }
+            persistQueue.push(std::move(job));
+        }
+
+        if (activeRenderers.fetch_sub(1) == 1) {
+            persistQueue.close();
+        }
+    };
+
+    // Oversize files one at a time, extraction and render under one
+    // reservation that takes precedence over ordinary ones
+    auto laneWork = [&](int workerIndex) {
+        // Alone on its lane, so it never pauses
+        if (background) {
+            BackgroundMode::lowerCurrentThread();
+        }
+        ProcessGFiles processor(library->model, workerIndex);
+
+        ModelData modelData;
+        while (serialLane.pop(modelData)) {
+            if (m_stopRequested.load()) {
+                continue;
+            }
+            const int64_t need = MemoryBudget::estimate(modelData);
+            MemoryReservation reservation(memory, need, stopped, true);
+            if (!reservation.admitted()) {
+                continue;
+            }
+            announce(modelData);
+            qDebug() << "IndexingWorker::processBatch() serial lane takes" << QString::fromStdString(modelData.short_name)
+                << "expecting" << need / (1024 * 1024) << "MB";
+
+            // The usual helper memory limit is sized for ordinary files
+            std::unique_ptr<WorkerProcess> helper;
+            if (isolated) {
+                QSettings laneSettings;
+                int limitMb = laneSettings.value("workerMemoryMB", 2048).toInt();
+                limitMb = std::max(limitMb, static_cast<int>(2 * need / (1024 * 1024)));
+                helper = std::make_unique<WorkerProcess>(-1, limitMb);
+            }
+
+            PersistJob job;
+            job.name = modelData.short_name;
+            job.extraction = extractModel(processor, helper.get(), modelData, reservation);
+            ExtractionResult renderJob;
+            bool needsRender = renderJobFor(job.extraction, renderJob);
+            persistQueue.push(std::move(job));
+
+            if (needsRender && !m_stopRequested.load()) {
+                PersistJob rendered;
+                rendered.kind = PersistJob::Render;
+                rendered.name = modelData.short_name;
+                rendered.render = renderModel(processor, helper.get(), renderJob, reservation);
+                persistQueue.push(std::move(rendered));
+            }
+        }
+
+        if (activeRenderers.fetch_sub(1) == 1) {
+            persistQueue.close();
+        }
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(extractWorkers + renderWorkers + 1);
+    QList<QFuture<void>> futures;
+    for (int i = 0; i < extractWorkers; ++i) {
+        futures.append(QtConcurrent::run(&pool, extractWork, i));
+    }
+    for (int i = 0; i < renderWorkers; ++i) {
+        futures.append(QtConcurrent::run(&pool, renderWork, extractWorkers + i));
+    }
+    futures.append(QtConcurrent::run(&pool, laneWork, extractWorkers + renderWorkers));
+
+    // Single writer: every catalog update of the batch happens here
+    ProcessGFiles writer(library->model);
+    // Time blocked versus computing per stage, to tell I/O-bound batches
+    StageTotals openTotals, extractTotals, renderTotals, persistTotals;
+    PersistJob job;
+    bool idle = false;
+    while (persistQueue.popFor(job, ProgressBatcher::INTERVAL, idle) || idle) {
+        if (idle) {
+            // What finished before a long job still goes out in time
+            sendProgress(batcher, false);
+            continue;
+        }
+        int modelId = 0;
+        bool complete = false;
+        StageClock persistClock;
+
+        if (job.kind == PersistJob::Preparation) {
+            storePreparation(library->model, job.preparation);
+        }
+        else if (job.kind == PersistJob::Extraction) {
+            modelId = job.extraction.modelData.id;
+            bool stored = writer.persistExtraction(job.extraction);
+            complete = stored && (job.extraction.duplicateOf != 0 || job.extraction.thumbnailObject.empty());
+            if (job.extraction.openTime.wallUs > 0) {
+                openTotals.add(job.extraction.openTime);
+            }
+            if (job.extraction.extractTime.wallUs > 0) {
+                extractTotals.add(job.extraction.extractTime);
+            }
+        }
+        else {
+            modelId = job.render.modelId;
+            complete = writer.persistRender(job.render);
+            renderTotals.add(job.render.renderTime);
+        }
+        persistTotals.add(persistClock.elapsed());
+
+        if (complete) {
+            int done = completed.fetch_add(1) + 1;
+            batcher.progress(job.name, (done * 100) / totalFiles.load());
+        }
+        // The store methods leave the list model alone; the UI reloads
+        // every row this thread wrote, a batch at a time
+        if (modelId != 0 && batcher.processed(modelId)) {
+            sendProgress(batcher, false);
+        }
+    }
+    sendProgress(batcher, true);
+
+    for (auto& future : futures) {
+        future.waitForFinished();
+    }
+
+    const std::pair<const char*, const StageTotals*> stages[] = {
+        { "open", &openTotals }, { "extract", &extractTotals }, { "render", &renderTotals }, { "persist", &persistTotals }
+    };
+    for (const auto& stage : stages) {
+        if (stage.second->count() > 0) {
+            qDebug() << "IndexingWorker::processBatch()" << stage.second->summary(stage.first).c_str();
+        }
+    }
+    readAhead.wait();
+    qDebug() << "IndexingWorker::processBatch() read ahead" << readAhead.hintedFiles() << "files,"
+        << readAhead.hintedBytes() / (1024 * 1024) << "MB";
+
+    if (m_stopRequested.load()) {
+        // Whatever is left is picked up again by the next run
+        queue->clear();
+        qDebug() << "IndexingWorker::process() stopping due to stop request";
+    }
+}
+
+void IndexingWorker::refineThumbnails(int renderWorkers) {
+    std::vector<ModelData> pending = library->model->getModelsPendingFullRender();
+    const int total = static_cast<int>(pending.size());
+    if (total == 0) {
+        return;
+    }
+
+    // Shortest first, as in the main pass
+    RenderCostModel costs;
+    costs.calibrate(library->model->getRenderTimings());
+    std::vector<double> estimates;
+    estimates.reserve(pending.size());
+    for (const auto& modelData : pending) {
+        estimates.push_back(costs.estimate(modelData));
+    }
+    std::vector<size_t> order(pending.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return estimates[a] < estimates[b];
+    });
+
+    renderWorkers = std::max(1, std::min(renderWorkers, total));
+
+    qDebug() << "IndexingWorker::refineThumbnails() rendering" << total << "full previews";
+
+    BoundedQueue<RenderResult> persistQueue(static_cast<size_t>(renderWorkers) * 2);
+    std::atomic<int> nextIndex(0);
+    std::atomic<int> activeRenderers(renderWorkers);
+
+    auto yieldRequested = [this]() {
+        return m_stopRequested.load() || m_reindexRequested.load();
+    };
+    const bool background = BackgroundMode::enabled();
+
+    auto renderWork = [&](int workerIndex) {
+        // Refinement never competes with indexing or the UI for the CPU
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        if (background) {
+            BackgroundMode::lowerCurrentThread();
+        }
+        ProcessGFiles processor(library->model, workerIndex);
+        std::unique_ptr<WorkerProcess> helper;
+        if (WorkerProcess::enabled()) {
+            helper = std::make_unique<WorkerProcess>();
+        }
+
+        while (!yieldRequested()) {
+            if (background && !BackgroundMode::shared().waitForTurn(workerIndex, yieldRequested)) {
+                break;
+            }
+            int index = nextIndex.fetch_add(1);
+            if (index >= total) {
+                break;
+            }
+
+            const size_t next = order[static_cast<size_t>(index)];
+            ExtractionResult extraction;
+            extraction.modelData = pending[next];
+            extraction.renderCost = estimates[next];
+            std::vector<ObjectData> selected = library->model->getSelectedObjectsForModel(extraction.modelData.id);
+            extraction.thumbnailObject = selected.empty() ? "all" : selected.front().name;
+
+            // A crashed helper reads as a failed render: the coarse preview stays
+            RenderResult result;
+            {
+                MemoryReservation reservation(MemoryBudget::shared(), MemoryBudget::estimate(extraction.modelData),
+                                              yieldRequested);
+                if (!reservation.admitted()) {
+                    break;
+                }
+                if (helper) {
+                    helper->render(extraction, false, result);
+                }
+                else {
+                    result = processor.render(extraction);
+                    result.peakRss = reservation.peakRssAlone();
+                }
+            }
+            persistQueue.push(std::move(result));
+        }
+
+        QThread::currentThread()->setPriority(QThread::InheritPriority);
+        if (activeRenderers.fetch_sub(1) == 1) {
+            persistQueue.close();
+        }
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(renderWorkers);
+    QList<QFuture<void>> futures;
+    for (int i = 0; i < renderWorkers; ++i) {
+        futures.append(QtConcurrent::run(&pool, renderWork, i));
+    }
+
+    ProcessGFiles writer(library->model);
+    ProgressBatcher batcher;
+    int refined = 0;
+    RenderResult result;
+    bool idle = false;
+    while (persistQueue.popFor(result, ProgressBatcher::INTERVAL, idle) || idle) {
+        if (idle) {
+            sendProgress(batcher, false);
+            continue;
+        }
+        // A failed full render keeps the coarse preview on screen and is
+        // retried after its backoff
+        if (writer.persistRender(result)) {
+            refined++;
+            batcher.progress("Refining previews", (refined * 100) / total);
+        }
+        if (batcher.processed(result.modelId)) {
+            sendProgress(batcher, false);
+        }
+    }
+    sendProgress(batcher, true);
+
+    for (auto& future : futures) {
+        future.waitForFinished();
+    }
+}
+
+void IndexingWorker::sendProgress(ProgressBatcher& batcher, bool all) {
+    // Taken and sent under one lock, so batches reach the UI in order
+    std::lock_guard<std::mutex> lock(progressMutex);
+    ProgressBatcher::Batch batch;
+    if (!(all ? batcher.take(batch) : batcher.takeDue(batch))) {
+        return;
+    }
+    if (!batch.modelIds.empty()) {
+        emit modelsProcessed(QList<int>(batch.modelIds.begin(), batch.modelIds.end()));
+    }
+    if (batch.hasProgress) {
+        emit progressUpdated(QString::fromStdString(batch.status), batch.percentage);
+    }
+}
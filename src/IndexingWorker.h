@@ -1,10 +1,15 @@
 #ifndef INDEXINGWORKER_H
 #define INDEXINGWORKER_H
 
+#include <QList>
 #include <QObject>
 #include <atomic>
+#include <mutex>
+#include <vector>
 #include "Library.h"
 
+class ProgressBatcher;
+
 class IndexingWorker : public QObject {
     Q_OBJECT
 public:
@@ -16,15 +21,50 @@ public slots:
     void requestReindex();
 
 signals:
-    void modelProcessed(int modelId);
+    // Models whose catalog rows were written since the last batch; sent
+    // at most every ProgressBatcher::INTERVAL, or sooner once enough have
+    // piled up. The only way indexing results reach the list model.
+    void modelsProcessed(const QList<int>& modelIds);
     void progressUpdated(const QString& currentObject, int percentage);
     void finished();
 
 private:
+    // Number of extraction workers, from the "indexingThreads" setting
+    int workerCount() const;
+    // Number of thumbnail workers, from the "renderThreads" setting
+    int renderWorkerCount() const;
+
+    /*
+     * Extract -> render -> persist pipeline. Extraction and rendering run
+     * on pools of their own; everything they produce goes through one
+     * bounded queue to this thread, the only one writing to the catalog.
+     * Models are taken from the library's ProcessingQueue, so what the user
+     * looks at goes first and cheap files before expensive ones; files
+     * included while the batch runs join it, their headers read on a
+     * worker and stored by this thread as well. Opens and renders wait for
+     * room in the MemoryBudget; oversize files go through a serial lane
+     * of their own, extraction and render back to back.
+     */
+    void processBatch(const std::vector<ModelData>& modelsToProcess, int extractWorkers, int renderWorkers);
+
+    // "progressivePreviews" setting: coarse preview first, full render later
+    bool progressivePreviews() const;
+
+    /*
+     * Second, low-priority pass replacing coarse previews with full
+     * renders. Gives way as soon as a stop or reindex is requested; what
+     * is left stays pending for the next run.
+     */
+    void refineThumbnails(int renderWorkers);
+
+    // Sends the batch if it is due, or whatever waits with all
+    void sendProgress(ProgressBatcher& batcher, bool all);
+
     Library* library;
     std::atomic<bool> m_stopRequested;
     std::atomic<bool> m_reindexRequested;
     bool previewFlag;
+    std::mutex progressMutex;
 };
 
 #endif // INDEXINGWORKER_H
@@ -15,6 +15,7 @@ Library::Library(const char* _label, const char* _path)
     : shortName(_label ? _label : ""),
     fullPath(_path ? _path : ""),
     model(new Model(_path)),
+    queue(new ProcessingQueue()),
     index(nullptr)
 {
 }
@@ -22,6 +23,7 @@ Library::Library(const char* _label, const char* _path)
 Library::~Library()
 {
     delete index;
+    delete queue;
     delete model;
 }
 
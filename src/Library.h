@@ -7,6 +7,7 @@
 #include <vector>
 #include "FilesystemIndexer.h"
 #include "Model.h"
+#include "ProcessingQueue.h"
 
 class Library {
 public:
@@ -28,6 +29,8 @@ public:
     std::string shortName;
     std::string fullPath;
     Model* model;
+    // Models waiting for the indexing worker, in processing order
+    ProcessingQueue* queue;
 
 private:
     FilesystemIndexer* index;
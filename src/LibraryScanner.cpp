@@ -0,0 +1,246 @@
+#include "LibraryScanner.h"
+#include "ContentHasher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+#include <unordered_set>
+
+LibraryScanner::LibraryScanner(Model* model, const std::string& libraryPath)
+    : model(model), libraryPath(libraryPath)
+{
+}
+
+std::vector<std::string> LibraryScanner::listGFiles() const
+{
+    std::vector<std::string> files;
+    QDirIterator it(QString::fromStdString(libraryPath), QDir::Files | QDir::NoDotAndDotDot,
+        QDirIterator::Subdirectories);
+
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo fileInfo = it.fileInfo();
+        if (fileInfo.suffix().compare("g", Qt::CaseInsensitive) != 0) {
+            continue;
+        }
+
+        // Same normalization FileSystemModelWithCheckboxes uses for file_path
+        QString path = QDir::cleanPath(fileInfo.absoluteFilePath());
+        if (path.contains("/.cadventory/")) {
+            continue;
+        }
+        files.push_back(path.toStdString());
+    }
+    return files;
+}
+
+ScanResult LibraryScanner::rescan()
+{
+    return apply(plan());
+}
+
+ScanPlan LibraryScanner::plan() const
+{
+    ScanPlan plan;
+    if (!model) {
+        return plan;
+    }
+
+    std::vector<std::string> onDisk = listGFiles();
+    std::unordered_set<std::string> diskFiles(onDisk.begin(), onDisk.end());
+    std::unordered_set<std::string> cataloged;
+
+    std::vector<ModelData> all = model->getAllModels();
+    std::vector<ModelData> present;
+    std::vector<int> missing;
+    for (const auto& modelData : all) {
+        cataloged.insert(modelData.file_path);
+        if (diskFiles.count(modelData.file_path) == 0) {
+            missing.push_back(modelData.id);
+        }
+        else {
+            present.push_back(modelData);
+        }
+    }
+
+    // Files that moved keep their row; only look when something went missing
+    std::unordered_set<int> claimed;
+    for (const auto& path : onDisk) {
+        if (cataloged.count(path) != 0) {
+            continue;
+        }
+        FileFingerprint fp;
+        ModelData match;
+        match.id = 0;
+        if (missing.size() > claimed.size()) {
+            match = findMove(path, fp, claimed);
+        }
+        if (match.id != 0) {
+            claimed.insert(match.id);
+            plan.moves.push_back({ match.id, match.file_path, fp });
+        }
+        else {
+            plan.added++;
+        }
+    }
+
+    for (int id : missing) {
+        if (claimed.count(id) == 0) {
+            plan.removedIds.push_back(id);
+        }
+    }
+
+    // Pass 1: size/mtime only, no file contents are read
+    for (const auto& modelData : present) {
+        int64_t size = 0;
+        int64_t mtime = 0;
+        bool statOk = ContentHasher::statFile(modelData.file_path, size, mtime);
+        if (statOk && !modelData.content_hash.empty() &&
+            size == modelData.file_size && mtime == modelData.file_mtime) {
+            plan.unchanged++;
+            continue;
+        }
+        plan.hashed.push_back(modelData);
+    }
+
+    // Pass 2: hash only the files whose metadata changed
+    std::vector<std::string> paths;
+    paths.reserve(plan.hashed.size());
+    for (const auto& modelData : plan.hashed) {
+        paths.push_back(modelData.file_path);
+    }
+    plan.fingerprints = ContentHasher::fingerprintFiles(paths);
+    return plan;
+}
+
+ScanResult LibraryScanner::apply(const ScanPlan& plan)
+{
+    ScanResult result;
+    if (!model) {
+        return result;
+    }
+    result.unchanged = plan.unchanged;
+    result.added = plan.added;
+
+    for (const auto& move : plan.moves) {
+        if (!model->relocateModel(move.id, move.fingerprint.file_path)) {
+            result.added++;
+            continue;
+        }
+        model->updateFingerprint(move.id, move.fingerprint);
+        qDebug() << "[LibraryScanner::apply] Model" << move.id << "moved from"
+            << QString::fromStdString(move.oldPath) << "to"
+            << QString::fromStdString(move.fingerprint.file_path);
+        result.moved++;
+    }
+
+    for (int id : plan.removedIds) {
+        qDebug() << "[LibraryScanner::apply] Removing missing file of model" << id;
+        if (model->deleteModel(id)) {
+            result.removed++;
+        }
+    }
+
+    for (size_t i = 0; i < plan.hashed.size(); ++i) {
+        const ModelData& modelData = plan.hashed[i];
+        const FileFingerprint& fp = plan.fingerprints[i];
+
+        if (!fp.valid()) {
+            qDebug() << "[LibraryScanner::apply] Could not fingerprint"
+                << QString::fromStdString(modelData.file_path) << "- leaving it untouched";
+            result.unchanged++;
+            continue;
+        }
+
+        // Catalogs written before fingerprints existed have no hash to compare
+        // against; trust the extracted data and just record the fingerprint.
+        bool changed = !modelData.content_hash.empty() && fp.content_hash != modelData.content_hash;
+        if (changed && model->markModelForReprocessing(modelData.id)) {
+            result.modified++;
+            result.modifiedIds.push_back(modelData.id);
+        }
+        else {
+            result.unchanged++;
+        }
+    }
+
+    // Record the new size/mtime so the next rescan takes the fast path
+    model->storeFingerprints(plan.hashed, plan.fingerprints);
+
+    qDebug() << "[LibraryScanner::apply] unchanged:" << result.unchanged
+        << "modified:" << result.modified << "moved:" << result.moved
+        << "removed:" << result.removed << "new:" << result.added;
+    return result;
+}
+
+ModelData LibraryScanner::detectMove(const std::string& newFilePath)
+{
+    FileFingerprint fp;
+    ModelData match = findMove(newFilePath, fp);
+    if (match.id == 0 || !model->relocateModel(match.id, newFilePath)) {
+        match.id = 0;
+        return match;
+    }
+    model->updateFingerprint(match.id, fp);
+
+    qDebug() << "[LibraryScanner::detectMove] Model" << match.id << "moved from"
+        << QString::fromStdString(match.file_path) << "to"
+        << QString::fromStdString(newFilePath);
+    return model->getModelById(match.id);
+}
+
+ModelData LibraryScanner::findMove(const std::string& newFilePath, FileFingerprint& fp,
+    const std::unordered_set<int>& claimed) const
+{
+    ModelData none;
+    none.id = 0;
+    if (!model) {
+        return none;
+    }
+
+    int64_t size = 0;
+    int64_t mtime = 0;
+    if (!ContentHasher::statFile(newFilePath, size, mtime)) {
+        return none;
+    }
+
+    std::vector<ModelData> candidates;
+    for (const auto& modelData : model->getModelsByFileSize(size)) {
+        if (modelData.file_path != newFilePath && !modelData.content_hash.empty() &&
+            claimed.count(modelData.id) == 0 &&
+            !QFileInfo::exists(QString::fromStdString(modelData.file_path))) {
+            candidates.push_back(modelData);
+        }
+    }
+    if (candidates.empty()) {
+        return none;
+    }
+
+    fp = ContentHasher::fingerprint(newFilePath);
+    if (!fp.valid()) {
+        return none;
+    }
+
+    const ModelData* match = nullptr;
+    for (const auto& modelData : candidates) {
+        if (fp.inode != 0 && modelData.file_inode == fp.inode &&
+            modelData.content_hash == fp.content_hash) {
+            match = &modelData;
+            break;
+        }
+    }
+
+    // Copied across filesystems: the inode changed, fall back to content alone
+    if (!match) {
+        for (const auto& modelData : candidates) {
+            if (modelData.content_hash == fp.content_hash) {
+                match = &modelData;
+                break;
+            }
+        }
+    }
+
+    return match ? *match : none;
+}
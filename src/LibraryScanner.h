@@ -0,0 +1,99 @@
+#ifndef LIBRARYSCANNER_H
+#define LIBRARYSCANNER_H
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ContentHasher.h"
+#include "Model.h"
+
+/**
+ * @brief Outcome of a library rescan
+ */
+struct ScanResult {
+    int unchanged = 0;      // size/mtime or content hash matched, kept as-is
+    int modified = 0;       // content changed, queued for reprocessing
+    int removed = 0;        // no longer on disk, dropped from the catalog
+    int moved = 0;          // relocated cataloged file, path rewritten in place
+    int added = 0;          // on disk but not yet in the catalog
+    std::vector<int> modifiedIds;
+};
+
+/**
+ * @brief What a rescan found on disk, before the catalog is touched
+ */
+struct ScanPlan {
+    struct Move {
+        int id = 0;
+        std::string oldPath;
+        FileFingerprint fingerprint;    // of the file at its new path
+    };
+
+    int unchanged = 0;                      // size/mtime matched, nothing to do
+    int added = 0;
+    std::vector<Move> moves;
+    std::vector<int> removedIds;
+    std::vector<ModelData> hashed;          // size/mtime changed
+    std::vector<FileFingerprint> fingerprints;  // parallel to hashed
+};
+
+/**
+ * @brief Reconciles the catalog with the .g files currently on disk
+ *
+ * Every cataloged file is checked cheaply first (size and mtime against
+ * the stored fingerprint). Only files whose metadata changed are hashed,
+ * in parallel, and only those whose content hash differs lose their
+ * extracted objects and thumbnail. Untouched files keep everything,
+ * including user tags, so reloading a large library only pays for what
+ * actually changed.
+ *
+ * A file that appears at a new path is first matched against cataloged
+ * files that vanished (same size, then inode or content hash); a match
+ * keeps its row, so objects, thumbnail, tags and selection survive a
+ * move or rename without reprocessing. Unmatched new files are not
+ * inserted here; FileSystemModelWithCheckboxes adds them as their
+ * directories are loaded.
+ */
+class LibraryScanner {
+public:
+    LibraryScanner(Model* model, const std::string& libraryPath);
+
+    ScanResult rescan();
+
+    /*
+     * rescan() in two halves. plan() only reads the catalog and does the
+     * slow part (listing, stat calls, hashing), so it may run on a worker
+     * thread; apply() writes the catalog and emits the model's signals,
+     * so it belongs on the thread that owns the Model, with indexing
+     * stopped: it deletes and requeues models the pipeline may hold.
+     */
+    ScanPlan plan() const;
+    ScanResult apply(const ScanPlan& plan);
+
+    // All .g files below the library root, excluding .cadventory
+    std::vector<std::string> listGFiles() const;
+
+    /**
+     * @brief Checks whether an uncataloged file is a moved cataloged one
+     *
+     * Candidates are models with the same stored size whose file no longer
+     * exists. The inode is tried first (a rename or same-filesystem move
+     * keeps it), confirmed by the content hash so a recycled inode is not
+     * mistaken for a move; otherwise the content hash alone decides.
+     * On a match the model's file_path is rewritten in place.
+     *
+     * @return the relocated model, or a model with id 0 if none matched
+     */
+    ModelData detectMove(const std::string& newFilePath);
+
+private:
+    // The vanished model newFilePath is a copy of, not yet in claimed; id 0 if none
+    ModelData findMove(const std::string& newFilePath, FileFingerprint& fp,
+        const std::unordered_set<int>& claimed = {}) const;
+
+    Model* model;
+    std::string libraryPath;
+};
+
+#endif // LIBRARYSCANNER_H
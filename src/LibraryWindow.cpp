@@ -8,12 +8,14 @@
 #include "ReportGenerationWindow.h"
 #include "ReportGeneratorWorker.h"
 #include "FileSystemFilterProxyModel.h"
+#include "LibraryScanner.h"
 
 #include <QThread>
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QListView>
+#include <QScrollBar>
 #include <QPushButton>
 #include <QComboBox>
 #include <QMenuBar>
@@ -24,6 +26,10 @@
 #include <QIcon>
 #include <QTimer>
 #include <QDebug>
+#include <QSettings>
+#include <QDateTime>
+#include <QHash>
+#include <QtConcurrent>
 
 #include <iostream>
 #include <string>
@@ -48,11 +54,20 @@ LibraryWindow::LibraryWindow(QWidget* parent)
     indexingWorker(nullptr)
 {
     ui.setupUi(this);
+
+    connect(&gcWatcher, &QFutureWatcher<GarbageReport>::finished,
+            this, &LibraryWindow::onCatalogCompacted);
+    connect(&rescanWatcher, &QFutureWatcher<ScanPlan>::finished,
+            this, &LibraryWindow::onLibraryRescanned);
 }
 
 LibraryWindow::~LibraryWindow() {
     qDebug() << "LibraryWindow destructor called";
 
+    // The catalog must outlive a running GC pass or rescan
+    gcWatcher.waitForFinished();
+    rescanWatcher.waitForFinished();
+
     // Ensure the indexing thread is stopped if it wasn't already
     if (indexingThread && indexingThread->isRunning()) {
         qDebug() << "Waiting for indexingThread to finish in destructor";
@@ -99,6 +114,11 @@ void LibraryWindow::loadFromLibrary(Library* _library) {
 }
 
 void LibraryWindow::startIndexing() {
+    // A rescan about to change the catalog restarts indexing itself
+    if (rescanApplyPending) {
+        return;
+    }
+
     if (indexingThread && indexingThread->isRunning()) {
         if (indexingWorker) {
             indexingWorker->requestReindex();
@@ -114,7 +134,7 @@ void LibraryWindow::startIndexing() {
 
     // Connect signals and slots
     connect(indexingThread, &QThread::started, indexingWorker, &IndexingWorker::process);
-    connect(indexingWorker, &IndexingWorker::modelProcessed, this, &LibraryWindow::onModelProcessed);
+    connect(indexingWorker, &IndexingWorker::modelsProcessed, this, &LibraryWindow::onModelsProcessed);
     connect(indexingWorker, &IndexingWorker::progressUpdated, this, &LibraryWindow::onProgressUpdated);
     connect(indexingWorker, &IndexingWorker::finished, this, &LibraryWindow::onIndexingComplete);
     connect(indexingWorker, &IndexingWorker::finished, indexingThread, &QThread::quit);
@@ -148,7 +168,7 @@ void LibraryWindow::processNextFile() {
 
     CADventory* app = qobject_cast<CADventory*>(QCoreApplication::instance());
     ModelTagging* modelTagging = app->getModelTagging();
-    modelTagging->generateTags(filepath);
+    modelTagging->generateTags(filepath, model);
 }
 
 void LibraryWindow::onTagsGeneratedFromBatch(const std::vector<std::string>& tags) {
@@ -168,6 +188,7 @@ void LibraryWindow::onTagsGeneratedFromBatch(const std::vector<std::string>& tag
                 model->addTagToModel(modelId, tag);
             }
         }
+        model->recordStage(modelId, ProcessingStage::Tag, tags.empty() ? StageFailed : StageOk);
 
         model->refreshModelData();
         availableModelsProxyModel->invalidate();
@@ -265,10 +286,15 @@ void LibraryWindow::onGenerateAllTagsClicked() {
     ui.statusLabel->setText("Generating tags...");
     ui.generateAllTagsButton->setEnabled(false);
 
+    // Files tagged by an earlier run are not sent to the LLM again
     filesToTag.clear();
     for (const auto& rel : relativePaths) {
-        filesToTag.push_back(library->fullPath + "/" + rel);
+        std::string filepath = library->fullPath + "/" + rel;
+        if (model->getModelByFilePath(filepath).tagged_at == 0) {
+            filesToTag.push_back(filepath);
+        }
     }
+    ui.progressBar->setMaximum(static_cast<int>(filesToTag.size()));
 
     if (canceled || currentFileIndex <= 0) {
         currentFileIndex = 0;
@@ -290,6 +316,33 @@ void LibraryWindow::setMainWindow(MainWindow* mainWindow) {
 
     this->mainWindow->editMenu->addAction(reload);
     connect(reload, &QAction::triggered, this, &LibraryWindow::reloadLibrary);
+
+    compact = new QAction(tr("&Compact Catalog"), this);
+    this->mainWindow->editMenu->addAction(compact);
+    connect(compact, &QAction::triggered, this, &LibraryWindow::compactCatalog);
+}
+
+void LibraryWindow::compactCatalog() {
+    if (!model || gcWatcher.isRunning()) {
+        return;
+    }
+
+    ui.statusLabel->setText("Compacting catalog...");
+    Model* catalog = model;
+    gcWatcher.setFuture(QtConcurrent::run([catalog]() { return catalog->collectGarbage(); }));
+}
+
+void LibraryWindow::onCatalogCompacted() {
+    GarbageReport report = gcWatcher.result();
+
+    QSettings settings;
+    settings.setValue(QString("catalogGc/%1").arg(QString::fromStdString(library->fullPath)),
+                      QDateTime::currentDateTime());
+
+    ui.statusLabel->setText(QString("Catalog compacted: %1 orphaned objects, %2 tag links removed, %3 KiB reclaimed")
+        .arg(report.orphan_objects)
+        .arg(report.orphan_model_tags)
+        .arg(report.bytesReclaimed() / 1024));
 }
 
 void LibraryWindow::setupModelsAndViews() {
@@ -304,10 +357,19 @@ void LibraryWindow::setupModelsAndViews() {
     ui.availableModelsView->setUniformItemSizes(true);
     ui.availableModelsView->setSelectionMode(QAbstractItemView::NoSelection);
     ui.availableModelsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    // Cards page through their view atlas under the pointer
+    ui.availableModelsView->setMouseTracking(true);
 
     QSize itemSize = modelCardDelegate->sizeHint(QStyleOptionViewItem(), QModelIndex());
     ui.availableModelsView->setGridSize(QSize(0, itemSize.height()));
 
+    // Follow the viewport so the indexing queue favors what the user sees
+    QScrollBar* modelsScrollBar = ui.availableModelsView->verticalScrollBar();
+    connect(modelsScrollBar, &QScrollBar::valueChanged,
+            this, &LibraryWindow::updateVisibleModels, Qt::UniqueConnection);
+    connect(modelsScrollBar, &QScrollBar::rangeChanged,
+            this, &LibraryWindow::updateVisibleModels, Qt::UniqueConnection);
+
     // Setup file system model with checkboxes
     QString libraryPath = QString::fromStdString(library->fullPath);
     qDebug() << "Library Path in setupModelsAndViews:" << libraryPath;
@@ -388,34 +450,9 @@ void LibraryWindow::populateExplorerModel() {
         if (model->data(index, Model::IsProcessedRole).toBool() && 
             model->data(index, Model::IsIncludedRole).toBool()) {
             
-            // Get model data
-            int modelId = model->data(index, Model::IdRole).toInt();
-            QString shortName = model->data(index, Model::ShortNameRole).toString();
-            QString title = model->data(index, Model::TitleRole).toString();
-            bool isSelected = model->data(index, Model::IsSelectedRole).toBool();
-            
-            // Remove file extension from shortName if present
-            int dotIndex = shortName.lastIndexOf('.');
-            if (dotIndex > 0) {
-                shortName = shortName.left(dotIndex);
-            }
-            
             // Create item
-            QStandardItem* item = new QStandardItem(shortName);
-            item->setData(modelId, Qt::UserRole); // Store model ID
-            item->setData(title, Qt::UserRole + 1); // Store title as tooltip
-            
-            // Set tooltip with title
-            item->setToolTip(title);
-            
-            // Set background color if selected
-            if (isSelected) {
-                QColor selectedColor = QColor(180, 180, 180); // Darker gray
-                item->setBackground(selectedColor);
-            } else {
-                // Ensure unselected items have transparent background
-                item->setBackground(Qt::transparent);
-            }
+            QStandardItem* item = new QStandardItem();
+            fillExplorerItem(item, index);
             
             // Add to model
             explorerModel->appendRow(item);
@@ -426,6 +463,90 @@ void LibraryWindow::populateExplorerModel() {
     }
 }
 
+void LibraryWindow::fillExplorerItem(QStandardItem* item, const QModelIndex& index) {
+    // Get model data
+    int modelId = model->data(index, Model::IdRole).toInt();
+    QString shortName = model->data(index, Model::ShortNameRole).toString();
+    QString title = model->data(index, Model::TitleRole).toString();
+    bool isSelected = model->data(index, Model::IsSelectedRole).toBool();
+
+    // Remove file extension from shortName if present
+    int dotIndex = shortName.lastIndexOf('.');
+    if (dotIndex > 0) {
+        shortName = shortName.left(dotIndex);
+    }
+
+    item->setText(shortName);
+    item->setData(modelId, Qt::UserRole); // Store model ID
+    item->setData(title, Qt::UserRole + 1); // Store title as tooltip
+
+    // Set tooltip with title
+    item->setToolTip(title);
+
+    // Set background color if selected
+    if (isSelected) {
+        QColor selectedColor = QColor(180, 180, 180); // Darker gray
+        item->setBackground(selectedColor);
+    } else {
+        // Ensure unselected items have transparent background
+        item->setBackground(Qt::transparent);
+    }
+}
+
+void LibraryWindow::updateExplorerItems(const QList<int>& modelIds) {
+    // Library row of every model, to keep the explorer in library order
+    QHash<int, int> libraryRow;
+    QList<int> idAtRow(model->rowCount());
+    for (int i = 0; i < model->rowCount(); ++i) {
+        int id = model->data(model->index(i, 0), Model::IdRole).toInt();
+        libraryRow.insert(id, i);
+        idAtRow[i] = id;
+    }
+    // Items keep their identity as rows come and go around them
+    QHash<int, QStandardItem*> explorerItem;
+    for (int i = 0; i < explorerModel->rowCount(); ++i) {
+        QStandardItem* item = explorerModel->item(i);
+        explorerItem.insert(item->data(Qt::UserRole).toInt(), item);
+    }
+
+    for (int modelId : modelIds) {
+        int row = libraryRow.value(modelId, -1);
+        QStandardItem* existing = explorerItem.value(modelId, nullptr);
+        QModelIndex index = model->index(row, 0);
+        bool listed = row >= 0 &&
+            model->data(index, Model::IsProcessedRole).toBool() &&
+            model->data(index, Model::IsIncludedRole).toBool();
+
+        if (!listed) {
+            if (existing) {
+                allExplorerItems.removeOne(existing);
+                explorerItem.remove(modelId);
+                explorerModel->removeRow(existing->row());
+            }
+            continue;
+        }
+
+        if (existing) {
+            fillExplorerItem(existing, index);
+            continue;
+        }
+
+        // Ahead of the first listed entry further down the library
+        int insertAt = explorerModel->rowCount();
+        for (int next = row + 1; next < idAtRow.size(); ++next) {
+            if (QStandardItem* after = explorerItem.value(idAtRow[next], nullptr)) {
+                insertAt = after->row();
+                break;
+            }
+        }
+        QStandardItem* item = new QStandardItem();
+        fillExplorerItem(item, index);
+        explorerModel->insertRow(insertAt, item);
+        allExplorerItems.append(item);
+        explorerItem.insert(modelId, item);
+    }
+}
+
 void LibraryWindow::onExplorerModelClicked(const QModelIndex& index) {
     // Get the model ID from the item data
     int modelId = explorerModel->data(index, Qt::UserRole).toInt();
@@ -498,6 +619,8 @@ void LibraryWindow::setupConnections() {
 
     connect(modelCardDelegate, &ModelCardDelegate::modelViewClicked,
             this, &LibraryWindow::onModelViewClicked);
+    connect(modelCardDelegate, &ModelCardDelegate::previewViewChanged,
+            ui.availableModelsView, qOverload<const QModelIndex&>(&QListView::update));
             
     // Connect explorer view signals
     connect(ui.explorerModelsView, &QListView::clicked,
@@ -593,13 +716,13 @@ void LibraryWindow::onSettingsClicked(int modelId) {
     // Implement settings dialog or other actions here
 }
 
-void LibraryWindow::onModelProcessed(int modelId) {
-    Q_UNUSED(modelId);
-    model->refreshModelData();
-    availableModelsProxyModel->invalidate();
-    
+void LibraryWindow::onModelsProcessed(const QList<int>& modelIds) {
+    // Only the rows of the batch change; the proxy filters them again
+    // as their dataChanged arrives
+    model->refreshModels(std::vector<int>(modelIds.begin(), modelIds.end()));
+
     // Update explorer model
-    populateExplorerModel();
+    updateExplorerItems(modelIds);
 }
 
 void LibraryWindow::on_backButton_clicked() {
@@ -638,25 +761,59 @@ void LibraryWindow::reloadLibrary() {
     if (fs::exists(filePath)) {
 
         qDebug() << "reloadLibrary is called" ;
-        try {
-
-                // Reload the library
-                model->resetDatabase();
-                model->refreshModelData();
-                availableModelsProxyModel->invalidate();
-                fileSystemModel->refresh(); // Custom method to refresh the model
-                this->loadFromLibrary(library);
-
-        } catch (const fs::filesystem_error& e) {
-            std::cerr << "Error: " << e.what() << std::endl;
+        if (rescanWatcher.isRunning() || rescanApplyPending) {
+            return;
         }
+
+        // Listing and hashing the library happen off the GUI thread; the
+        // catalog is only changed once the plan comes back
+        ui.statusLabel->setText("Rescanning library...");
+        LibraryScanner scanner(model, library->fullPath);
+        rescanWatcher.setFuture(QtConcurrent::run([scanner]() { return scanner.plan(); }));
     } else {
         std::cout << "'.cadventory' does not exist." << std::endl;
     }
 }
 
+void LibraryWindow::onLibraryRescanned() {
+    // Models the plan deletes or requeues may be in the pipeline; let it
+    // wind down and apply from onIndexingComplete()
+    if (indexingThread && indexingThread->isRunning()) {
+        rescanApplyPending = true;
+        ui.statusLabel->setText("Waiting for indexing to stop...");
+        indexingWorker->stop();
+        return;
+    }
+    applyRescan();
+}
+
+void LibraryWindow::applyRescan() {
+    rescanApplyPending = false;
+    try {
+        // Reconcile the catalog with disk; only files whose content
+        // changed lose their objects/thumbnail and get reprocessed
+        LibraryScanner scanner(model, library->fullPath);
+        ScanResult scan = scanner.apply(rescanWatcher.result());
+        qDebug() << "Reload:" << scan.modified << "modified," << scan.removed
+                 << "removed," << scan.added << "new," << scan.unchanged << "unchanged";
+        ui.statusLabel->setText(QString("Library reloaded: %1 modified, %2 moved, %3 removed, %4 new")
+            .arg(scan.modified)
+            .arg(scan.moved)
+            .arg(scan.removed)
+            .arg(scan.added));
+
+        model->refreshModelData();
+        availableModelsProxyModel->invalidate();
+        fileSystemModel->refresh(); // Custom method to refresh the model
+        this->loadFromLibrary(library);
+    } catch (const fs::filesystem_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
 void LibraryWindow::onModelViewClicked(int modelId) {
     qDebug() << "Model view clicked for model ID:" << modelId;
+    library->queue->prioritize(modelId);
     ModelView* modelView = new ModelView(modelId, model, this);
 
     connect(modelView, &ModelView::tagsUpdated, this, [this]() {
@@ -670,6 +827,7 @@ void LibraryWindow::onModelViewClicked(int modelId) {
 
 void LibraryWindow::onGeometryBrowserClicked(int modelId) {
     qDebug() << "Geometry browser clicked for model ID:" << modelId;
+    library->queue->prioritize(modelId);
 
     GeometryBrowserDialog* dialog = new GeometryBrowserDialog(modelId, model, this);
     dialog->exec();
@@ -698,11 +856,38 @@ void LibraryWindow::onInclusionChanged(const QModelIndex& index, bool /*included
     populateExplorerModel();
 }
 
+void LibraryWindow::updateVisibleModels() {
+    if (!library) {
+        return;
+    }
+
+    QListView* view = ui.availableModelsView;
+    QRect viewport = view->viewport()->rect();
+    QModelIndex first = view->indexAt(viewport.topLeft());
+
+    std::vector<int> visibleIds;
+    if (first.isValid()) {
+        for (int row = first.row(); row < availableModelsProxyModel->rowCount(); ++row) {
+            QModelIndex index = availableModelsProxyModel->index(row, 0);
+            if (!view->visualRect(index).intersects(viewport)) {
+                break;
+            }
+            visibleIds.push_back(index.data(Model::IdRole).toInt());
+        }
+    }
+    library->queue->setVisible(visibleIds);
+}
+
 void LibraryWindow::onIndexingComplete() {
     qDebug() << "Indexing complete";
     indexingThread = nullptr;
     indexingWorker = nullptr;
 
+    // Restarts indexing once the catalog is reconciled
+    if (rescanApplyPending) {
+        applyRescan();
+    }
+
     // Refresh model data
     model->refreshModelData();
     availableModelsProxyModel->invalidate();
@@ -714,6 +899,14 @@ void LibraryWindow::onIndexingComplete() {
     fileSystemModel->dataChanged(fileSystemModel->index(0, 0),
                                  fileSystemModel->index(fileSystemModel->rowCount() - 1, 0),
                                  {Qt::CheckStateRole});
+
+    // Periodic background GC keeps the catalog from growing with churn
+    QSettings settings;
+    int intervalDays = settings.value("catalogGcIntervalDays", 7).toInt();
+    QDateTime lastRun = settings.value(QString("catalogGc/%1").arg(QString::fromStdString(library->fullPath))).toDateTime();
+    if (intervalDays > 0 && (!lastRun.isValid() || lastRun.daysTo(QDateTime::currentDateTime()) >= intervalDays)) {
+        compactCatalog();
+    }
 }
 
 void LibraryWindow::onDirectoryLoaded(const QString& /*path*/) {
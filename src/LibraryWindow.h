@@ -9,6 +9,7 @@
 #include <QSortFilterProxyModel>
 #include <QThread>
 #include <QStandardItemModel>
+#include <QFutureWatcher>
 
 #include "ui_librarywindow.h"
 #include "Library.h"
@@ -18,6 +19,7 @@
 #include "IndexingWorker.h"
 #include "FileSystemModelWithCheckboxes.h"
 #include "FileSystemFilterProxyModel.h"
+#include "LibraryScanner.h"
 
 class MainWindow;
 
@@ -30,6 +32,7 @@ public:
 
     void loadFromLibrary(Library* _library);
     void reloadLibrary();
+    void compactCatalog();
     void setMainWindow(MainWindow* mainWindow);
 
 
@@ -54,19 +57,30 @@ private slots:
     void onExplorerModelDoubleClicked(const QModelIndex& index);
 
     void startIndexing();
-    void onModelProcessed(int modelId);
+    void onModelsProcessed(const QList<int>& modelIds);
     void onProgressUpdated(const QString& currentObject, int percentage);
 
     // Filesystem view slots
     void onInclusionChanged(const QModelIndex& index, bool included);
     void onIndexingComplete();
     void onDirectoryLoaded(const QString& path);
+    void onCatalogCompacted();
+    void onLibraryRescanned();
+
+    // Cards on screen are processed ahead of the rest of the library
+    void updateVisibleModels();
 
 private:
     void setupModelsAndViews();
     void setupConnections();
     void setupExplorerView();
     void populateExplorerModel();
+    // Adds, updates or drops just the explorer entries of these models
+    void updateExplorerItems(const QList<int>& modelIds);
+    void fillExplorerItem(QStandardItem* item, const QModelIndex& index);
+
+    // Applies the finished rescan plan; indexing must not be running
+    void applyRescan();
 
     void processNextFile();
     void onTagsGeneratedFromBatch(const std::vector<std::string>& tags);
@@ -74,6 +88,10 @@ private:
     Library* library;
     MainWindow* mainWindow;
     QAction* reload;
+    QAction* compact;
+    QFutureWatcher<GarbageReport> gcWatcher;
+    QFutureWatcher<ScanPlan> rescanWatcher;
+    bool rescanApplyPending = false;    // plan waits for indexing to stop
     Ui::LibraryWindow ui;
     Model* model;
 
@@ -3,8 +3,10 @@
 #include "SettingWindow.h"
 #include "MainWindow.h"
 #include "LibraryWindow.h"
+#include "DuplicatesDialog.h"
 
 #include <iostream>
+#include <filesystem>
 #include <QFileDialog>
 #include <QPushButton>
 #include <QSettings>
@@ -48,8 +50,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     QAction *set = new QAction(tr("&General Settings"),this);
     QAction *reset = new QAction(tr("&Reset"),this);
+    QAction *duplicates = new QAction(tr("Find &Duplicates"),this);
 
     windowMenu->addAction(set);
+    fileMenu->addAction(duplicates);
     fileMenu->addAction(reset);
     fileMenu->addMenu(removelib);
 
@@ -72,6 +76,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     settingWindow = new SettingWindow(this);
     connect(set,&QAction::triggered,this,&MainWindow::showSettingsWindow);
     connect(reset,&QAction::triggered,this,&MainWindow::resetting);
+    connect(duplicates,&QAction::triggered,this,&MainWindow::showDuplicates);
 
 
 
@@ -104,6 +109,13 @@ void MainWindow::addLibrary(const char* label, const char* path)
 
     Library* newlib = new Library(label, path);
     libraries.push_back(newlib);
+
+    // Re-added before restart: keep the catalog after all
+    QSettings settings;
+    QStringList pending = settings.value("pendingCatalogRemovals").toStringList();
+    if (pending.removeAll(QString::fromStdString(newlib->model->getHiddenDirectoryPath())) > 0) {
+        settings.setValue("pendingCatalogRemovals", pending);
+    }
     size_t files = newlib->indexFiles();
 
     QString libCount = QString("Scanned ") + QString::number(files) + QString(" file(s) in ") + label;
@@ -265,6 +277,18 @@ size_t MainWindow::saveState()
 size_t MainWindow::loadState()
 {
     QSettings settings;
+
+    // Catalogs of libraries removed in an earlier session
+    QStringList pending = settings.value("pendingCatalogRemovals").toStringList();
+    for (const QString& catalogDir : pending) {
+        std::error_code ec;
+        std::filesystem::remove_all(catalogDir.toStdString(), ec);
+        if (ec) {
+            std::cerr << "Could not remove catalog at " << catalogDir.toStdString() << ": " << ec.message() << std::endl;
+        }
+    }
+    settings.remove("pendingCatalogRemovals");
+
     size_t size = settings.beginReadArray("libraries");
     for (size_t i = 0; i < size; ++i) {
         settings.setArrayIndex(i);
@@ -285,6 +309,21 @@ void MainWindow::clearLibraries()
     libraries.clear();
 }
 
+std::vector<DuplicateCluster> MainWindow::findDuplicates() const
+{
+    DuplicateIndex index;
+    for (Library* lib : libraries) {
+        index.addCatalog(lib->shortName, lib->model);
+    }
+    return index.allClusters();
+}
+
+void MainWindow::showDuplicates()
+{
+    DuplicatesDialog dialog(findDuplicates(), this);
+    dialog.exec();
+}
+
 void MainWindow::showSettingsWindow()
 {
     settingWindow->show();
@@ -394,6 +433,22 @@ void MainWindow::removeLibrary()
 
         saveState();
 
+        // The catalog (metadata.db, previews/) lives inside the library folder.
+        // It may still be open by a library window or its indexer, so it is
+        // deleted on the next start, before any library is opened.
+        std::string catalogDir = foundLibrary->model->getHiddenDirectoryPath();
+        QMessageBox::StandardButton purge = QMessageBox::question(this, "Remove Library",
+            "Also delete the catalog for " + lookupKey + "?\n\n" + QString::fromStdString(catalogDir) +
+            "\n\nTags and processed data for this library will be lost.",
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+
+        if (purge == QMessageBox::Yes) {
+            QSettings settings;
+            QStringList pending = settings.value("pendingCatalogRemovals").toStringList();
+            pending.append(QString::fromStdString(catalogDir));
+            settings.setValue("pendingCatalogRemovals", pending);
+        }
+
     } else {
         QMessageBox::warning(this, "Library Not Found", "Could not find the library for " + lookupKey);
     }
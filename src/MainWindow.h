@@ -14,6 +14,7 @@
 #include "SettingWindow.h"
 
 #include "Library.h"
+#include "DuplicateIndex.h"
 
 
 class SettingWindow;
@@ -33,6 +34,10 @@ public:
     size_t publicLoadState() { return loadState(); }
     void clearLibraries();
 
+    // Duplicate files and sub-assemblies across all registered libraries
+    std::vector<DuplicateCluster> findDuplicates() const;
+    void showDuplicates();
+
     void showSettingsWindow();
     void setPreviewFlag(bool state);
     bool previewFlag = true;
@@ -0,0 +1,211 @@
+#include "MemoryBudget.h"
+
+#include <QDebug>
+#include <QSettings>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// How often a waiting reservation checks whether it was cancelled
+const std::chrono::milliseconds CANCEL_POLL(100);
+
+// Without a known amount of physical memory
+const int64_t FALLBACK_BUDGET_MB = 4096;
+
+}
+
+MemoryBudget::MemoryBudget(int64_t budgetBytes)
+    : budgetBytes(budgetBytes)
+{
+    if (this->budgetBytes < 0) {
+        int64_t physical = physicalMemory();
+        int64_t defaultMb = physical > 0 ? physical / 2 / (1024 * 1024) : FALLBACK_BUDGET_MB;
+        QSettings settings;
+        this->budgetBytes = settings.value("memoryBudgetMB", static_cast<qlonglong>(defaultMb)).toLongLong() * 1024 * 1024;
+    }
+    this->budgetBytes = std::max<int64_t>(this->budgetBytes, 1);
+}
+
+MemoryBudget& MemoryBudget::shared()
+{
+    static MemoryBudget budget;
+    return budget;
+}
+
+int64_t MemoryBudget::estimate(const ModelData& modelData)
+{
+    if (modelData.peak_rss > 0) {
+        return modelData.peak_rss;
+    }
+
+    double bytes = static_cast<double>(BASE_BYTES);
+    bytes += BYTES_PER_FILE_BYTE * static_cast<double>(std::max<int64_t>(0, modelData.file_size));
+    bytes += static_cast<double>(BYTES_PER_OBJECT) * static_cast<double>(std::max<int64_t>(0, modelData.object_count));
+    bytes += BYTES_PER_MESH_BYTE * static_cast<double>(std::max<int64_t>(0, modelData.mesh_bytes));
+    return static_cast<int64_t>(bytes);
+}
+
+bool MemoryBudget::isOversize(int64_t bytes) const
+{
+    return static_cast<double>(bytes) > OVERSIZE_SHARE * static_cast<double>(budgetBytes);
+}
+
+bool MemoryBudget::acquire(int64_t bytes, const std::function<bool()>& cancelled, bool priority)
+{
+    bytes = std::max<int64_t>(0, bytes);
+    std::unique_lock<std::mutex> lock(mutex);
+    if (priority) {
+        priorityWaiting++;
+    }
+
+    // Alone, anything fits; a job larger than the budget waits for that
+    auto fits = [&]() {
+        if (!priority && priorityWaiting > 0) {
+            return false;
+        }
+        return runningJobs == 0 || reservedBytes + bytes <= budgetBytes;
+    };
+    while (!fits()) {
+        if (cancelled && cancelled()) {
+            if (priority) {
+                priorityWaiting--;
+                changed.notify_all();
+            }
+            return false;
+        }
+        changed.wait_for(lock, CANCEL_POLL);
+    }
+
+    if (priority) {
+        priorityWaiting--;
+    }
+    reservedBytes += bytes;
+    runningJobs++;
+    admitted++;
+    return true;
+}
+
+void MemoryBudget::release(int64_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reservedBytes = std::max<int64_t>(0, reservedBytes - std::max<int64_t>(0, bytes));
+        runningJobs = std::max(0, runningJobs - 1);
+    }
+    changed.notify_all();
+}
+
+int64_t MemoryBudget::reserved() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return reservedBytes;
+}
+
+int MemoryBudget::running() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return runningJobs;
+}
+
+uint64_t MemoryBudget::admissions() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return admitted;
+}
+
+int64_t MemoryBudget::physicalMemory()
+{
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        return static_cast<int64_t>(status.ullTotalPhys);
+    }
+    return 0;
+#elif defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0) {
+        return static_cast<int64_t>(pages) * pageSize;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+int64_t MemoryBudget::peakRss()
+{
+#if defined(__linux__)
+    // VmHWM follows resetPeakRss(); ru_maxrss would not
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoll(line.substr(6)) * 1024;
+        }
+    }
+    return 0;
+#elif defined(_WIN32)
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<int64_t>(usage.ru_maxrss);
+#else
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+void MemoryBudget::resetPeakRss()
+{
+#if defined(__linux__)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+#endif
+}
+
+MemoryReservation::MemoryReservation(MemoryBudget& budget, int64_t bytes, const std::function<bool()>& cancelled,
+                                     bool priority)
+    : budget(budget), bytes(bytes)
+{
+    held = budget.acquire(bytes, cancelled, priority);
+    if (held) {
+        admission = budget.admissions();
+        alone = budget.running() == 1;
+        if (alone) {
+            MemoryBudget::resetPeakRss();
+        }
+    }
+}
+
+MemoryReservation::~MemoryReservation()
+{
+    if (held) {
+        budget.release(bytes);
+    }
+}
+
+int64_t MemoryReservation::peakRssAlone() const
+{
+    if (!held || !alone || budget.admissions() != admission || budget.running() != 1) {
+        return 0;
+    }
+    return MemoryBudget::peakRss();
+}
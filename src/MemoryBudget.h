@@ -0,0 +1,123 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "Model.h"
+
+/**
+ * @brief Admits memory-hungry jobs only while they fit a budget
+ *
+ * Opening and prepping a .g file takes memory in proportion to the file,
+ * its directory and its meshes; a few multi-gigabyte databases processed
+ * at once, or one next to a gist report, push the machine into swap.
+ * Every such job reserves its estimated peak with acquire() and waits
+ * while the reservations already admitted leave too little of the
+ * budget. A job larger than the whole budget is admitted once nothing
+ * else runs.
+ *
+ * Jobs above OVERSIZE_SHARE of the budget are oversize: the indexer runs
+ * them one at a time on a serial lane of their own. Their reservations
+ * take priority, so a stream of small jobs cannot starve them.
+ *
+ * The budget is the "memoryBudgetMB" setting, by default half of the
+ * physical memory. The indexer and gist reports share one budget.
+ *
+ * Usage example:
+ *
+ * int64_t need = MemoryBudget::estimate(modelData);
+ * MemoryReservation reservation(MemoryBudget::shared(), need);
+ * if (reservation.admitted()) { ... open the file ... }
+ */
+class MemoryBudget {
+public:
+    // Estimate: a fixed base, plus per file byte, per object and per mesh byte
+    static constexpr int64_t BASE_BYTES = 64LL * 1024 * 1024;
+    static constexpr double BYTES_PER_FILE_BYTE = 3.0;
+    static constexpr int64_t BYTES_PER_OBJECT = 8 * 1024;
+    static constexpr double BYTES_PER_MESH_BYTE = 4.0;
+    static constexpr double OVERSIZE_SHARE = 0.5;
+
+    // budgetBytes < 0 reads the "memoryBudgetMB" setting
+    explicit MemoryBudget(int64_t budgetBytes = -1);
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    // The process-wide budget
+    static MemoryBudget& shared();
+
+    /*
+     * Expected peak memory of opening and rendering a model: the peak
+     * recorded the last time it was processed, otherwise a guess from
+     * the file size and the header probe's object and mesh counts.
+     */
+    static int64_t estimate(const ModelData& modelData);
+
+    bool isOversize(int64_t bytes) const;
+
+    /*
+     * Blocks until the reservation fits, then takes it. Returns false
+     * without reserving if cancelled() turns true while waiting. Waiting
+     * priority reservations hold back ordinary ones.
+     */
+    bool acquire(int64_t bytes, const std::function<bool()>& cancelled = nullptr, bool priority = false);
+    void release(int64_t bytes);
+
+    int64_t budget() const { return budgetBytes; }
+    int64_t reserved() const;
+    int running() const;
+    // Reservations admitted so far; unchanged means no job started meanwhile
+    uint64_t admissions() const;
+
+    // 0 where unknown
+    static int64_t physicalMemory();
+
+    /*
+     * Peak resident set size of this process, and restarting it from the
+     * current size (Linux only; elsewhere the peak is since start-up).
+     */
+    static int64_t peakRss();
+    static void resetPeakRss();
+
+private:
+    int64_t budgetBytes;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    int64_t reservedBytes = 0;
+    int runningJobs = 0;
+    int priorityWaiting = 0;
+    uint64_t admitted = 0;
+};
+
+/**
+ * @brief One job's reservation, released when it goes out of scope
+ *
+ * Knows whether the job ran alone from admission to the end, the only
+ * case in which the process peak RSS is the job's own.
+ */
+class MemoryReservation {
+public:
+    MemoryReservation(MemoryBudget& budget, int64_t bytes, const std::function<bool()>& cancelled = nullptr,
+                      bool priority = false);
+    ~MemoryReservation();
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    bool admitted() const { return held; }
+
+    // Peak RSS of the job if it ran alone, 0 otherwise
+    int64_t peakRssAlone() const;
+
+private:
+    MemoryBudget& budget;
+    int64_t bytes;
+    bool held = false;
+    bool alone = false;
+    uint64_t admission = 0;
+};
+
+#endif // MEMORYBUDGET_H
@@ -1,4 +1,5 @@
 #include "Model.h"
+#include "RenderCostModel.h"
 
 #include <QBuffer>
 #include <QDebug>
@@ -6,16 +7,48 @@
 #include <QImageWriter>
 #include <QPixmap>
 #include <QVariant>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <set>
 #include <sstream>
 
 namespace fs = std::filesystem;
 
+// Columns materialized into a ModelData by readModelRow(), in order;
+// without previews both PNG blobs read as NULL
+static std::string modelColumns(bool previews) {
+  const std::string thumbnail = previews ? "thumbnail" : "NULL";
+  const std::string coarse = previews ? "coarse_thumbnail" : "NULL";
+  return "id, short_name, primary_file, override_info, title, " + thumbnail +
+         ", author, file_path, library_name, is_selected, is_processed, "
+         "is_included, content_hash, file_size, file_mtime, file_inode, " +
+         coarse +
+         ", coarse_rendered_at, thumbnail_rendered_at, db_version, "
+         "object_count, crash_count, probed_at, probe_error, extracted_at, "
+         "extract_error, render_error, tagged_at, tag_error, failure_count, "
+         "retry_after, comb_count, mesh_count, mesh_bytes, render_ms, peak_rss";
+}
+static const std::string MODEL_COLUMNS = modelColumns(true);
+// The rows the list model holds; painting loads previews via getThumbnail()
+static const std::string LIST_COLUMNS = modelColumns(false);
+
+// Budget for decoded previews held for painting
+static const qsizetype IMAGE_CACHE_BYTES = 64 * 1024 * 1024;
+
+// How long a statement waits for another connection's lock (the garbage
+// collector's VACUUM) before failing
+static const int BUSY_TIMEOUT_MS = 10000;
+
+// Free pages handed back per incremental_vacuum step, each under db_mutex
+static const int VACUUM_CHUNK_PAGES = 256;
+
 Model::Model(const std::string& libraryPath, QObject* parent)
-    : QAbstractListModel(parent), db(nullptr) {
+    : QAbstractListModel(parent), db(nullptr), imageCache(IMAGE_CACHE_BYTES) {
   // Create a hidden directory inside the library path
   fs::path hiddenDir = fs::path(libraryPath) / ".cadventory";
   hiddenDirPath = hiddenDir.string();
@@ -32,6 +65,9 @@ Model::Model(const std::string& libraryPath, QObject* parent)
   } else {
     std::cout << "Opened database at " << dbPath << " successfully"
               << std::endl;
+    sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+    // Only takes effect on a new database; collectGarbage() converts old ones
+    executeSQL("PRAGMA auto_vacuum = INCREMENTAL;");
     createTables();
 
     loadModelsFromDatabase();
@@ -91,8 +127,174 @@ bool Model::createTables() {
       );
   )";
 
-  return executeSQL(sqlModels) && executeSQL(sqlObjects) &&
-         executeSQL(sqlTags) && executeSQL(sqlModelTags);
+  // One row per stored preview size of a model
+  std::string sqlThumbnails = R"(
+      CREATE TABLE IF NOT EXISTS thumbnails (
+          model_id INTEGER NOT NULL,
+          size INTEGER NOT NULL,
+          format TEXT NOT NULL,
+          data BLOB NOT NULL,
+          PRIMARY KEY (model_id, size),
+          FOREIGN KEY (model_id) REFERENCES models(id) ON DELETE CASCADE
+      );
+  )";
+
+  // Metrics stage: how many primitives of each librt type a model has
+  std::string sqlPrimitiveCounts = R"(
+      CREATE TABLE IF NOT EXISTS primitive_counts (
+          model_id INTEGER NOT NULL,
+          type TEXT NOT NULL,
+          count INTEGER NOT NULL,
+          PRIMARY KEY (model_id, type),
+          FOREIGN KEY (model_id) REFERENCES models(id) ON DELETE CASCADE
+      );
+  )";
+
+  if (!(executeSQL(sqlModels) && executeSQL(sqlObjects) &&
+        executeSQL(sqlTags) && executeSQL(sqlModelTags) &&
+        executeSQL(sqlThumbnails) && executeSQL(sqlPrimitiveCounts))) {
+    return false;
+  }
+
+  // Columns added after the first release; older catalogs are migrated
+  return addColumnIfMissing("models", "content_hash", "TEXT") &&
+         addColumnIfMissing("models", "file_size", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "file_mtime", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "file_inode", "INTEGER DEFAULT 0") &&
+         executeSQL(
+             "CREATE INDEX IF NOT EXISTS idx_models_content_hash ON "
+             "models(content_hash);") &&
+         executeSQL(
+             "CREATE INDEX IF NOT EXISTS idx_models_file_size ON "
+             "models(file_size);") &&
+         addColumnIfMissing("models", "coarse_thumbnail", "BLOB") &&
+         addColumnIfMissing("models", "coarse_rendered_at",
+                            "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "thumbnail_rendered_at",
+                            "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "db_version", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "object_count", "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "crash_count", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "probed_at", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "probe_error", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "extracted_at", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "extract_error", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "render_error", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "tagged_at", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "tag_error", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "failure_count", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "retry_after", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "comb_count", "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "mesh_count", "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "mesh_bytes", "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "render_ms", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "peak_rss", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("models", "view_atlas", "BLOB") &&
+         addColumnIfMissing("models", "primitive_count",
+                            "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "region_count", "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "tree_depth", "INTEGER DEFAULT -1") &&
+         addColumnIfMissing("models", "bbox_min_x", "REAL") &&
+         addColumnIfMissing("models", "bbox_min_y", "REAL") &&
+         addColumnIfMissing("models", "bbox_min_z", "REAL") &&
+         addColumnIfMissing("models", "bbox_max_x", "REAL") &&
+         addColumnIfMissing("models", "bbox_max_y", "REAL") &&
+         addColumnIfMissing("models", "bbox_max_z", "REAL") &&
+         addColumnIfMissing("models", "volume", "REAL") &&
+         addColumnIfMissing("models", "volume_error", "REAL") &&
+         addColumnIfMissing("models", "surface_area", "REAL") &&
+         addColumnIfMissing("models", "surface_area_error", "REAL") &&
+         addColumnIfMissing("models", "measured_at", "INTEGER DEFAULT 0") &&
+         addColumnIfMissing("objects", "structure_hash", "TEXT") &&
+         executeSQL(
+             "CREATE INDEX IF NOT EXISTS idx_objects_structure_hash ON "
+             "objects(structure_hash);") &&
+         executeSQL(
+             "CREATE INDEX IF NOT EXISTS idx_objects_model_id ON "
+             "objects(model_id);");
+}
+
+bool Model::addColumnIfMissing(const std::string& table,
+                               const std::string& column,
+                               const std::string& definition) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement("PRAGMA table_info(" + table + ");");
+  if (!stmt) return false;
+
+  bool exists = false;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* name =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (name && column == name) {
+      exists = true;
+      break;
+    }
+  }
+  sqlite3_finalize(stmt);
+
+  if (exists) return true;
+  return executeSQL("ALTER TABLE " + table + " ADD COLUMN " + column + " " +
+                    definition + ";");
+}
+
+ModelData Model::readModelRow(sqlite3_stmt* stmt) const {
+  auto text = [stmt](int col) {
+    const char* value =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    return std::string(value ? value : "");
+  };
+
+  ModelData model;
+  model.id = sqlite3_column_int(stmt, 0);
+  model.short_name = text(1);
+  model.primary_file = text(2);
+  model.override_info = text(3);
+  model.title = text(4);
+
+  const void* blob = sqlite3_column_blob(stmt, 5);
+  int blob_size = sqlite3_column_bytes(stmt, 5);
+  if (blob && blob_size > 0) {
+    model.thumbnail.assign(static_cast<const char*>(blob),
+                           static_cast<const char*>(blob) + blob_size);
+  }
+
+  model.author = text(6);
+  model.file_path = text(7);
+  model.library_name = text(8);
+  model.is_selected = sqlite3_column_int(stmt, 9) != 0;
+  model.is_processed = sqlite3_column_int(stmt, 10) != 0;
+  model.is_included = sqlite3_column_int(stmt, 11) != 0;
+  model.content_hash = text(12);
+  model.file_size = sqlite3_column_int64(stmt, 13);
+  model.file_mtime = sqlite3_column_int64(stmt, 14);
+  model.file_inode = static_cast<uint64_t>(sqlite3_column_int64(stmt, 15));
+
+  const void* coarse = sqlite3_column_blob(stmt, 16);
+  int coarse_size = sqlite3_column_bytes(stmt, 16);
+  if (coarse && coarse_size > 0) {
+    model.coarse_thumbnail.assign(static_cast<const char*>(coarse),
+                                  static_cast<const char*>(coarse) + coarse_size);
+  }
+  model.coarse_rendered_at = sqlite3_column_int64(stmt, 17);
+  model.thumbnail_rendered_at = sqlite3_column_int64(stmt, 18);
+  model.db_version = sqlite3_column_int(stmt, 19);
+  model.object_count = sqlite3_column_int64(stmt, 20);
+  model.crash_count = sqlite3_column_int(stmt, 21);
+  model.probed_at = sqlite3_column_int64(stmt, 22);
+  model.probe_error = sqlite3_column_int(stmt, 23);
+  model.extracted_at = sqlite3_column_int64(stmt, 24);
+  model.extract_error = sqlite3_column_int(stmt, 25);
+  model.render_error = sqlite3_column_int(stmt, 26);
+  model.tagged_at = sqlite3_column_int64(stmt, 27);
+  model.tag_error = sqlite3_column_int(stmt, 28);
+  model.failure_count = sqlite3_column_int(stmt, 29);
+  model.retry_after = sqlite3_column_int64(stmt, 30);
+  model.comb_count = sqlite3_column_int64(stmt, 31);
+  model.mesh_count = sqlite3_column_int64(stmt, 32);
+  model.mesh_bytes = sqlite3_column_int64(stmt, 33);
+  model.render_ms = sqlite3_column_int64(stmt, 34);
+  model.peak_rss = sqlite3_column_int64(stmt, 35);
+  return model;
 }
 
 int Model::rowCount(const QModelIndex& parent) const {
@@ -127,15 +329,21 @@ QVariant Model::data(const QModelIndex& index, int role) const {
         }
         return tagList;
 	}
-    case ThumbnailRole:
-      if (!modelData.thumbnail.empty()) {
-        QPixmap thumbnail;
-        thumbnail.loadFromData(
-            reinterpret_cast<const uchar*>(modelData.thumbnail.data()),
-            static_cast<uint>(modelData.thumbnail.size()), "PNG");
-        return thumbnail;
+    case ThumbnailRole: {
+      // Cards are drawn at about 80px; 128 stays sharp on hi-dpi screens
+      QPixmap mipmap = thumbnailPixmap(modelData.id, 128);
+      if (!mipmap.isNull()) {
+        return mipmap;
+      }
+      return QVariant();
+    }
+    case ViewAtlasRole: {
+      QPixmap atlas = viewAtlasPixmap(modelData.id);
+      if (!atlas.isNull()) {
+        return atlas;
       }
       return QVariant();
+    }
     case AuthorRole:
       return QString::fromStdString(modelData.author);
     case FilePathRole:
@@ -167,6 +375,7 @@ QHash<int, QByteArray> Model::roleNames() const {
   roles[IsSelectedRole] = "is_selected";
   roles[IsIncludedRole] = "is_included";
   roles[IsProcessedRole] = "is_processed";
+  roles[ViewAtlasRole] = "view_atlas";
   return roles;
 }
 
@@ -240,6 +449,9 @@ bool Model::insertModel(const ModelData& modelData) {
     ModelData modelDataWithId = modelData;
     modelDataWithId.id = id;
     modelDataWithId.short_name = short_name;
+    // Like LIST_COLUMNS, rows leave the previews in the catalog
+    modelDataWithId.thumbnail.clear();
+    modelDataWithId.coarse_thumbnail.clear();
 
     beginInsertRows(QModelIndex(), models.size(), models.size());
     models.push_back(modelDataWithId);
@@ -395,11 +607,16 @@ bool Model::updateModel(int id, const ModelData& modelData) {
     }
     sqlite3_finalize(stmt);
 
+    // The stored thumbnail may have changed with the rest
+    invalidateThumbnailImages(id);
+
     // Update the models vector
     for (int row = 0; row < static_cast<int>(models.size()); ++row) {
       if (models[row].id == id) {
         models[row] = modelData;
         models[row].short_name = short_name;
+        models[row].thumbnail.clear();
+        models[row].coarse_thumbnail.clear();
         QModelIndex modelIndex = index(row);
         emit dataChanged(modelIndex, modelIndex);
         break;
@@ -414,258 +631,1221 @@ bool Model::updateModel(int id, const ModelData& modelData) {
   }
 }
 
-bool Model::deleteModel(int id) {
-  // First, delete associated objects
-  if (!deleteObjectsForModel(id)) {
-    return false;
+bool Model::deleteModel(int id) {
+  // First, delete associated objects and tag links; the schema has no
+  // ON DELETE CASCADE for them
+  if (!deleteObjectsForModel(id) || !removeAllTagsFromModel(id) ||
+      !deleteThumbnailSizes(id) || !deletePrimitiveCounts(id)) {
+    return false;
+  }
+
+  std::string sql = "DELETE FROM models WHERE id = ?;";
+  sqlite3_stmt* stmt;
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_int(stmt, 1, id);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      std::cerr << "Delete model failed: " << sqlite3_errmsg(db) << std::endl;
+      sqlite3_finalize(stmt);
+      return false;
+    }
+    sqlite3_finalize(stmt);
+
+    // Remove from models vector
+    for (int row = 0; row < static_cast<int>(models.size()); ++row) {
+      if (models[row].id == id) {
+        beginRemoveRows(QModelIndex(), row, row);
+        models.erase(models.begin() + row);
+        endRemoveRows();
+        break;
+      }
+    }
+
+    return true;
+  } else {
+    std::cerr << "SQL error in deleteModel: " << sqlite3_errmsg(db)
+              << std::endl;
+    return false;
+  }
+}
+
+bool Model::modelExists(int id) {
+  std::string sql = "SELECT COUNT(*) FROM models WHERE id = ?;";
+  sqlite3_stmt* stmt;
+  int count = 0;
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_int(stmt, 1, id);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      count = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+  } else {
+    std::cerr << "SQL error in modelExists: " << sqlite3_errmsg(db)
+              << std::endl;
+  }
+
+  return count > 0;
+}
+
+ModelData Model::getModelById(int id) {
+  std::string sql = "SELECT " + MODEL_COLUMNS + " FROM models WHERE id = ?;";
+  sqlite3_stmt* stmt;
+  ModelData model;
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_int(stmt, 1, id);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      model = readModelRow(stmt);
+    }
+    sqlite3_finalize(stmt);
+  } else {
+    std::cerr << "Failed to select model: " << sqlite3_errmsg(db) << std::endl;
+  }
+
+  return model;
+}
+
+ModelData Model::getModelByFilePath(const std::string& filePath) {
+  ModelData model;
+  model.id = 0;
+  std::string sql =
+      "SELECT " + MODEL_COLUMNS + " FROM models WHERE file_path = ?;";
+  sqlite3_stmt* stmt;
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    // Use SQLITE_TRANSIENT to ensure SQLite makes its own copy of the data
+    sqlite3_bind_text(stmt, 1, filePath.c_str(), -1, SQLITE_TRANSIENT);
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      model = readModelRow(stmt);
+
+      qDebug() << "Model found with id:" << model.id
+               << "and filePath:" << QString::fromStdString(model.file_path);
+    } else {
+      qDebug() << "No model found with filePath:"
+               << QString::fromStdString(filePath);
+    }
+
+    sqlite3_finalize(stmt);
+  } else {
+    std::cerr << "Failed to select model by file path: " << sqlite3_errmsg(db)
+              << std::endl;
+  }
+
+  return model;
+}
+
+void Model::loadModelsFromDatabase() {
+  std::vector<ModelData> loadedModels;
+  std::string sql = "SELECT " + LIST_COLUMNS + " FROM models;";
+  sqlite3_stmt* stmt;
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      loadedModels.push_back(readModelRow(stmt));
+    }
+    sqlite3_finalize(stmt);
+
+    // Update the models vector
+    beginResetModel();
+    models = std::move(loadedModels);
+    endResetModel();
+
+  } else {
+    std::cerr << "Failed to select models: " << sqlite3_errmsg(db) << std::endl;
+  }
+}
+
+int Model::hashModel(const std::string& modelDir) {
+  qDebug() << "hashModel called with modelDir:"
+           << QString::fromStdString(modelDir);
+
+  uint64_t digest = 0;
+  if (!ContentHasher::hashFile(modelDir, digest)) {
+    std::cerr << "Could not open file for hashing: " << modelDir << std::endl;
+    return 0;
+  }
+
+  // Kept for callers that want a small key; fold the 64-bit digest and
+  // never return 0, which signals an unreadable file.
+  int hashValue = static_cast<int>(digest ^ (digest >> 32));
+  if (hashValue == 0) hashValue = 1;
+
+  qDebug() << "Hash value for" << QString::fromStdString(modelDir) << ":"
+           << hashValue;
+
+  return hashValue;
+}
+
+bool Model::updateFingerprint(int id, const FileFingerprint& fingerprint) {
+  std::string sql = R"(
+        UPDATE models SET content_hash = ?, file_size = ?, file_mtime = ?,
+            file_inode = ?
+        WHERE id = ?;
+    )";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return false;
+
+  if (fingerprint.valid()) {
+    sqlite3_bind_text(stmt, 1, fingerprint.content_hash.c_str(), -1,
+                      SQLITE_TRANSIENT);
+  } else {
+    sqlite3_bind_null(stmt, 1);
+  }
+  sqlite3_bind_int64(stmt, 2, fingerprint.size);
+  sqlite3_bind_int64(stmt, 3, fingerprint.mtime);
+  sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(fingerprint.inode));
+  sqlite3_bind_int(stmt, 5, id);
+
+  if (!executePreparedStatement(stmt)) return false;
+
+  return true;
+}
+
+std::vector<FileFingerprint> Model::fingerprintModels(
+    const std::vector<ModelData>& modelsToHash) {
+  std::vector<std::string> paths;
+  paths.reserve(modelsToHash.size());
+  for (const auto& modelData : modelsToHash) {
+    paths.push_back(modelData.file_path);
+  }
+
+  // Hashing runs in parallel without holding the database lock
+  std::vector<FileFingerprint> fingerprints =
+      ContentHasher::fingerprintFiles(paths);
+  storeFingerprints(modelsToHash, fingerprints);
+  return fingerprints;
+}
+
+void Model::storeFingerprints(const std::vector<ModelData>& hashedModels,
+                              const std::vector<FileFingerprint>& fingerprints) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  beginTransaction();
+  for (size_t i = 0; i < hashedModels.size() && i < fingerprints.size(); ++i) {
+    if (fingerprints[i].valid()) {
+      updateFingerprint(hashedModels[i].id, fingerprints[i]);
+    }
+  }
+  commitTransaction();
+}
+
+bool Model::storeHeader(int id, const GFileHeader& header) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // Extraction reads the title through librt and has the last word
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        UPDATE models SET db_version = ?, object_count = ?,
+            title = CASE WHEN is_processed = 0 AND ?3 <> '' THEN ?3
+                         ELSE title END,
+            probed_at = strftime('%s', 'now'), probe_error = 0,
+            comb_count = ?5, mesh_count = ?6, mesh_bytes = ?7
+        WHERE id = ?4;
+    )");
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, header.db_version);
+  sqlite3_bind_int64(stmt, 2, header.object_count);
+  sqlite3_bind_text(stmt, 3, header.title.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 4, id);
+  sqlite3_bind_int64(stmt, 5, header.comb_count);
+  sqlite3_bind_int64(stmt, 6, header.mesh_count);
+  sqlite3_bind_int64(stmt, 7, header.mesh_bytes);
+
+  if (!executePreparedStatement(stmt)) return false;
+
+  return true;
+}
+
+std::vector<GFileHeader> Model::probeModels(
+    const std::vector<ModelData>& modelsToProbe) {
+  std::vector<std::string> paths;
+  paths.reserve(modelsToProbe.size());
+  for (const auto& modelData : modelsToProbe) {
+    paths.push_back(modelData.file_path);
+  }
+
+  // Probing runs in parallel without holding the database lock
+  std::vector<GFileHeader> headers = GFileProbe::probeFiles(paths);
+  storeHeaders(modelsToProbe, headers);
+  return headers;
+}
+
+void Model::storeHeaders(const std::vector<ModelData>& probedModels,
+                         const std::vector<GFileHeader>& headers) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  beginTransaction();
+  for (size_t i = 0; i < probedModels.size() && i < headers.size(); ++i) {
+    if (headers[i].ok) {
+      storeHeader(probedModels[i].id, headers[i]);
+    } else {
+      // librt may still read what the probe could not
+      recordStage(probedModels[i].id, ProcessingStage::Probe, StageFailed);
+    }
+  }
+  commitTransaction();
+}
+
+bool Model::recordCrash(int id) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(
+      "UPDATE models SET crash_count = crash_count + 1 WHERE id = ?;");
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, id);
+  if (!executePreparedStatement(stmt)) return false;
+
+  return true;
+}
+
+bool Model::recordStage(int id, ProcessingStage stage, int error) {
+  std::string timeColumn, errorColumn;
+  switch (stage) {
+    case ProcessingStage::Probe:
+      timeColumn = "probed_at";
+      errorColumn = "probe_error";
+      break;
+    case ProcessingStage::Extract:
+      timeColumn = "extracted_at";
+      errorColumn = "extract_error";
+      break;
+    case ProcessingStage::Render:
+      // Renders are timed by storeThumbnail/storeCoarseThumbnail
+      errorColumn = "render_error";
+      break;
+    case ProcessingStage::Tag:
+      timeColumn = "tagged_at";
+      errorColumn = "tag_error";
+      break;
+  }
+
+  // Only extract and render failures keep a model from completing
+  const bool backOff = error != StageOk &&
+                       (stage == ProcessingStage::Extract ||
+                        stage == ProcessingStage::Render);
+  // A render is the last stage to fail; once it succeeds the model is clear
+  const bool cleared = error == StageOk && stage == ProcessingStage::Render;
+
+  std::string sql = "UPDATE models SET " + errorColumn + " = ?1";
+  if (error == StageOk && !timeColumn.empty()) {
+    sql += ", " + timeColumn + " = strftime('%s', 'now')";
+  }
+  if (cleared) {
+    sql += ", failure_count = 0, retry_after = 0";
+  }
+  if (backOff) {
+    // Shift first, then cap; failure_count is the count before this one
+    sql +=
+        ", retry_after = strftime('%s', 'now') + "
+        "min(?2 << min(failure_count, 20), ?3), "
+        "failure_count = failure_count + 1";
+  }
+  sql += " WHERE id = ?4;";
+
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // A render that ran out of time is retried with a longer limit; it only
+  // counts toward quarantine once it timed out at the top of that ladder
+  bool quarantineTimeout = error == StageTimedOut;
+  if (quarantineTimeout && stage == ProcessingStage::Render) {
+    int64_t failures = 0;
+    sqlite3_stmt* count =
+        prepareStatement("SELECT failure_count FROM models WHERE id = ?;");
+    if (count) {
+      sqlite3_bind_int(count, 1, id);
+      if (sqlite3_step(count) == SQLITE_ROW) {
+        failures = sqlite3_column_int64(count, 0);
+      }
+      sqlite3_finalize(count);
+    }
+    quarantineTimeout = failures >= RenderCostModel::MAX_RETRY_DOUBLINGS;
+  }
+
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, error);
+  if (backOff) {
+    sqlite3_bind_int64(stmt, 2, RETRY_BASE_SECONDS);
+    sqlite3_bind_int64(stmt, 3, RETRY_MAX_SECONDS);
+  }
+  sqlite3_bind_int(stmt, 4, id);
+  if (!executePreparedStatement(stmt)) return false;
+
+  if (error == StageCrashed || quarantineTimeout) {
+    return recordCrash(id);
+  }
+  return true;
+}
+
+bool Model::markModelForReprocessing(int id) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  beginTransaction();
+
+  // Extracted objects and the thumbnail describe the old contents; user
+  // tags and the inclusion/selection state are kept.
+  bool ok = deleteObjectsForModel(id) && deleteThumbnailSizes(id) &&
+            deletePrimitiveCounts(id);
+  if (ok) {
+    sqlite3_stmt* stmt = prepareStatement(
+        "UPDATE models SET is_processed = 0, thumbnail = NULL, "
+        "coarse_thumbnail = NULL, coarse_rendered_at = 0, "
+        "thumbnail_rendered_at = 0, crash_count = 0, extracted_at = 0, "
+        "extract_error = 0, render_error = 0, failure_count = 0, "
+        "retry_after = 0, render_ms = 0, peak_rss = 0, view_atlas = NULL, "
+        "primitive_count = -1, region_count = -1, tree_depth = -1, "
+        "bbox_min_x = NULL, bbox_min_y = NULL, bbox_min_z = NULL, "
+        "bbox_max_x = NULL, bbox_max_y = NULL, bbox_max_z = NULL, "
+        "volume = NULL, volume_error = NULL, surface_area = NULL, "
+        "surface_area_error = NULL, measured_at = 0 WHERE id = ?;");
+    ok = stmt != nullptr;
+    if (ok) {
+      sqlite3_bind_int(stmt, 1, id);
+      ok = executePreparedStatement(stmt);
+    }
+  }
+
+  if (!ok) {
+    executeSQL("ROLLBACK;");
+    return false;
+  }
+  commitTransaction();
+
+  for (int row = 0; row < static_cast<int>(models.size()); ++row) {
+    if (models[row].id == id) {
+      models[row].is_processed = false;
+      models[row].thumbnail.clear();
+      models[row].coarse_thumbnail.clear();
+      models[row].coarse_rendered_at = 0;
+      models[row].thumbnail_rendered_at = 0;
+      models[row].crash_count = 0;
+      models[row].extracted_at = 0;
+      models[row].extract_error = StageOk;
+      models[row].render_error = StageOk;
+      models[row].failure_count = 0;
+      models[row].retry_after = 0;
+      models[row].render_ms = 0;
+      models[row].peak_rss = 0;
+      QModelIndex modelIndex = index(row);
+      emit dataChanged(modelIndex, modelIndex);
+      break;
+    }
+  }
+  return true;
+}
+
+bool Model::recordRenderTime(int id, int64_t renderMs) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt =
+      prepareStatement("UPDATE models SET render_ms = ? WHERE id = ?;");
+  if (!stmt) return false;
+
+  sqlite3_bind_int64(stmt, 1, renderMs);
+  sqlite3_bind_int(stmt, 2, id);
+  if (!executePreparedStatement(stmt)) return false;
+
+  return true;
+}
+
+bool Model::recordPeakRss(int id, int64_t bytes) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(
+      "UPDATE models SET peak_rss = MAX(peak_rss, ?) WHERE id = ?;");
+  if (!stmt) return false;
+
+  sqlite3_bind_int64(stmt, 1, bytes);
+  sqlite3_bind_int(stmt, 2, id);
+  if (!executePreparedStatement(stmt)) return false;
+
+  return true;
+}
+
+std::vector<ModelData> Model::getRenderTimings(int limit) {
+  std::vector<ModelData> timings;
+
+  // Recent renders first: they reflect this machine and its settings
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        SELECT id, file_size, object_count, comb_count, mesh_count,
+               mesh_bytes, render_ms, render_error
+        FROM models WHERE render_ms > 0
+        ORDER BY thumbnail_rendered_at DESC LIMIT ?;
+    )");
+  if (!stmt) return timings;
+
+  sqlite3_bind_int(stmt, 1, limit);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ModelData modelData{};
+    modelData.id = sqlite3_column_int(stmt, 0);
+    modelData.file_size = sqlite3_column_int64(stmt, 1);
+    modelData.object_count = sqlite3_column_int64(stmt, 2);
+    modelData.comb_count = sqlite3_column_int64(stmt, 3);
+    modelData.mesh_count = sqlite3_column_int64(stmt, 4);
+    modelData.mesh_bytes = sqlite3_column_int64(stmt, 5);
+    modelData.render_ms = sqlite3_column_int64(stmt, 6);
+    modelData.render_error = sqlite3_column_int(stmt, 7);
+    timings.push_back(std::move(modelData));
+  }
+  sqlite3_finalize(stmt);
+  return timings;
+}
+
+bool Model::relocateModel(int id, const std::string& newFilePath) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  if (filePathExists(newFilePath)) {
+    std::cerr << "Another model with file_path " << newFilePath
+              << " already exists." << std::endl;
+    return false;
+  }
+
+  ModelData existing = getModelById(id);
+  std::string oldName = fs::path(existing.file_path).filename().string();
+  std::string newName = fs::path(newFilePath).filename().string();
+
+  // Follow a rename only if the short name was never customized
+  std::string short_name = existing.short_name;
+  if (short_name == oldName && newName != oldName) {
+    short_name = newName;
+    int suffix = 1;
+    while (shortNameExists(short_name)) {
+      short_name = newName + "_" + std::to_string(suffix++);
+    }
+  }
+
+  sqlite3_stmt* stmt = prepareStatement(
+      "UPDATE models SET file_path = ?, short_name = ? WHERE id = ?;");
+  if (!stmt) return false;
+  sqlite3_bind_text(stmt, 1, newFilePath.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, short_name.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 3, id);
+  if (!executePreparedStatement(stmt)) return false;
+
+  for (int row = 0; row < static_cast<int>(models.size()); ++row) {
+    if (models[row].id == id) {
+      models[row].file_path = newFilePath;
+      models[row].short_name = short_name;
+      QModelIndex modelIndex = index(row);
+      emit dataChanged(modelIndex, modelIndex);
+      break;
+    }
+  }
+  return true;
+}
+
+std::vector<ModelData> Model::getModelsByFileSize(int64_t fileSize) {
+  std::vector<ModelData> matches;
+  std::string sql =
+      "SELECT " + MODEL_COLUMNS + " FROM models WHERE file_size = ?;";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return matches;
+
+  sqlite3_bind_int64(stmt, 1, fileSize);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    matches.push_back(readModelRow(stmt));
+  }
+  sqlite3_finalize(stmt);
+  return matches;
+}
+
+ModelData Model::findProcessedDuplicate(const std::string& contentHash,
+                                        int excludeId) {
+  ModelData duplicate;
+  duplicate.id = 0;
+  if (contentHash.empty()) return duplicate;
+
+  std::string sql = "SELECT " + MODEL_COLUMNS +
+                    " FROM models WHERE content_hash = ? AND id != ? AND "
+                    "is_processed = 1 ORDER BY thumbnail IS NULL LIMIT 1;";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return duplicate;
+
+  sqlite3_bind_text(stmt, 1, contentHash.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, excludeId);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    duplicate = readModelRow(stmt);
+  }
+  sqlite3_finalize(stmt);
+  return duplicate;
+}
+
+bool Model::copyExtraction(int sourceModelId, int targetModelId) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // Objects are stored, and read back in id order, parents-first
+  std::vector<ObjectData> sourceObjects = getObjectsForModel(sourceModelId);
+
+  beginTransaction();
+  bool ok = deleteObjectsForModel(targetModelId);
+
+  // Parent ids become indices into sourceObjects
+  std::map<int, int> sourceIndex;
+  for (size_t i = 0; i < sourceObjects.size(); ++i) {
+    sourceIndex[sourceObjects[i].object_id] = static_cast<int>(i);
+  }
+  for (auto& obj : sourceObjects) {
+    auto parent = sourceIndex.find(obj.parent_object_id);
+    obj.parent_object_id = parent != sourceIndex.end() ? parent->second : -1;
+  }
+  ok = ok && insertObjectTree(targetModelId, sourceObjects);
+
+  if (ok) {
+    sqlite3_stmt* stmt = prepareStatement(R"(
+        UPDATE models SET
+            title = (SELECT title FROM models WHERE id = ?1),
+            thumbnail = (SELECT thumbnail FROM models WHERE id = ?1),
+            coarse_thumbnail =
+                (SELECT coarse_thumbnail FROM models WHERE id = ?1),
+            coarse_rendered_at =
+                (SELECT coarse_rendered_at FROM models WHERE id = ?1),
+            thumbnail_rendered_at =
+                (SELECT thumbnail_rendered_at FROM models WHERE id = ?1),
+            view_atlas = (SELECT view_atlas FROM models WHERE id = ?1),
+            (primitive_count, region_count, comb_count, tree_depth,
+             bbox_min_x, bbox_min_y, bbox_min_z,
+             bbox_max_x, bbox_max_y, bbox_max_z,
+             volume, volume_error, surface_area, surface_area_error,
+             measured_at) =
+                (SELECT primitive_count, region_count, comb_count, tree_depth,
+                        bbox_min_x, bbox_min_y, bbox_min_z,
+                        bbox_max_x, bbox_max_y, bbox_max_z,
+                        volume, volume_error, surface_area,
+                        surface_area_error, measured_at
+                 FROM models WHERE id = ?1),
+            extracted_at = strftime('%s', 'now'), extract_error = 0,
+            failure_count = 0, retry_after = 0,
+            is_processed = 1
+        WHERE id = ?2;
+    )");
+    ok = stmt != nullptr;
+    if (ok) {
+      sqlite3_bind_int(stmt, 1, sourceModelId);
+      sqlite3_bind_int(stmt, 2, targetModelId);
+      ok = executePreparedStatement(stmt);
+    }
+  }
+
+  if (ok) {
+    ok = deleteThumbnailSizes(targetModelId);
+  }
+  if (ok) {
+    sqlite3_stmt* stmt = prepareStatement(R"(
+        INSERT INTO thumbnails (model_id, size, format, data)
+        SELECT ?2, size, format, data FROM thumbnails WHERE model_id = ?1;
+    )");
+    ok = stmt != nullptr;
+    if (ok) {
+      sqlite3_bind_int(stmt, 1, sourceModelId);
+      sqlite3_bind_int(stmt, 2, targetModelId);
+      ok = executePreparedStatement(stmt);
+    }
+  }
+
+  if (ok) {
+    ok = deletePrimitiveCounts(targetModelId);
+  }
+  if (ok) {
+    sqlite3_stmt* stmt = prepareStatement(R"(
+        INSERT INTO primitive_counts (model_id, type, count)
+        SELECT ?2, type, count FROM primitive_counts WHERE model_id = ?1;
+    )");
+    ok = stmt != nullptr;
+    if (ok) {
+      sqlite3_bind_int(stmt, 1, sourceModelId);
+      sqlite3_bind_int(stmt, 2, targetModelId);
+      ok = executePreparedStatement(stmt);
+    }
+  }
+
+  if (!ok) {
+    std::cerr << "Failed to copy extraction from model " << sourceModelId
+              << " to " << targetModelId << std::endl;
+    executeSQL("ROLLBACK;");
+    return false;
+  }
+  commitTransaction();
+  return true;
+}
+
+bool Model::storeExtraction(int modelId, const std::string& title,
+                            const std::vector<ObjectData>& objects) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  beginTransaction();
+  bool ok =
+      deleteObjectsForModel(modelId) && insertObjectTree(modelId, objects);
+
+  if (ok) {
+    // Checkpoint: a later render failure or stop resumes from here
+    sqlite3_stmt* stmt = prepareStatement(
+        "UPDATE models SET title = ?, extracted_at = strftime('%s', 'now'), "
+        "extract_error = 0, failure_count = 0, retry_after = 0 "
+        "WHERE id = ?;");
+    ok = stmt != nullptr;
+    if (ok) {
+      sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_int(stmt, 2, modelId);
+      ok = executePreparedStatement(stmt);
+    }
+  }
+
+  if (!ok) {
+    std::cerr << "Failed to store extraction for model " << modelId
+              << std::endl;
+    executeSQL("ROLLBACK;");
+    return false;
+  }
+  commitTransaction();
+
+  return true;
+}
+
+bool Model::insertObjectTree(int modelId,
+                             const std::vector<ObjectData>& objects) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // One statement for the whole tree; large models have 100k+ objects
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        INSERT INTO objects (model_id, name, parent_object_id, is_selected,
+                             structure_hash)
+        VALUES (?, ?, ?, ?, ?);
+    )");
+  if (!stmt) return false;
+
+  std::vector<int> rowIds(objects.size(), -1);
+  bool ok = true;
+  for (size_t i = 0; ok && i < objects.size(); ++i) {
+    const ObjectData& obj = objects[i];
+    sqlite3_bind_int(stmt, 1, modelId);
+    sqlite3_bind_text(stmt, 2, obj.name.c_str(), -1, SQLITE_STATIC);
+    if (obj.parent_object_id >= 0 &&
+        obj.parent_object_id < static_cast<int>(i)) {
+      sqlite3_bind_int(stmt, 3, rowIds[obj.parent_object_id]);
+    } else {
+      sqlite3_bind_null(stmt, 3);
+    }
+    sqlite3_bind_int(stmt, 4, obj.is_selected ? 1 : 0);
+    if (!obj.structure_hash.empty()) {
+      sqlite3_bind_text(stmt, 5, obj.structure_hash.c_str(), -1,
+                        SQLITE_STATIC);
+    } else {
+      sqlite3_bind_null(stmt, 5);
+    }
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      std::cerr << "Insert object failed: " << sqlite3_errmsg(db)
+                << std::endl;
+      ok = false;
+      break;
+    }
+    rowIds[i] = static_cast<int>(sqlite3_last_insert_rowid(db));
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+  }
+
+  sqlite3_finalize(stmt);
+  return ok;
+}
+
+bool Model::storeThumbnail(int modelId, const std::vector<char>& thumbnail) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // Only a finished full render is stored; failed ones stay pending
+  sqlite3_stmt* stmt = prepareStatement(
+      "UPDATE models SET thumbnail = ?, is_processed = 1, "
+      "thumbnail_rendered_at = strftime('%s', 'now') WHERE id = ?;");
+  if (!stmt) return false;
+
+  if (!thumbnail.empty()) {
+    sqlite3_bind_blob(stmt, 1, thumbnail.data(),
+                      static_cast<int>(thumbnail.size()), SQLITE_TRANSIENT);
+  } else {
+    sqlite3_bind_null(stmt, 1);
+  }
+  sqlite3_bind_int(stmt, 2, modelId);
+  if (!executePreparedStatement(stmt)) {
+    return false;
+  }
+
+  invalidateThumbnailImages(modelId);
+  return true;
+}
+
+bool Model::storeCoarseThumbnail(int modelId,
+                                 const std::vector<char>& thumbnail) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+
+  // A coarse preview is enough for the model to count as processed
+  sqlite3_stmt* stmt = prepareStatement(
+      "UPDATE models SET coarse_thumbnail = ?, is_processed = 1, "
+      "coarse_rendered_at = strftime('%s', 'now') WHERE id = ?;");
+  if (!stmt) return false;
+
+  if (!thumbnail.empty()) {
+    sqlite3_bind_blob(stmt, 1, thumbnail.data(),
+                      static_cast<int>(thumbnail.size()), SQLITE_TRANSIENT);
+  } else {
+    sqlite3_bind_null(stmt, 1);
+  }
+  sqlite3_bind_int(stmt, 2, modelId);
+  if (!executePreparedStatement(stmt)) {
+    return false;
+  }
+
+  invalidateThumbnailImages(modelId);
+  return true;
+}
+
+std::vector<ModelData> Model::getModelsPendingFullRender() {
+  std::vector<ModelData> pending;
+  // Failed full renders wait out their backoff, as unprocessed models do
+  std::string sql = "SELECT " + MODEL_COLUMNS +
+                    " FROM models WHERE is_included = 1 AND is_processed = 1"
+                    " AND coarse_thumbnail IS NOT NULL"
+                    " AND thumbnail_rendered_at = 0 AND crash_count < ?"
+                    " AND retry_after <= strftime('%s', 'now');";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return pending;
+  sqlite3_bind_int(stmt, 1, QUARANTINE_CRASHES);
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    pending.push_back(readModelRow(stmt));
+  }
+  sqlite3_finalize(stmt);
+  return pending;
+}
+
+bool Model::storeThumbnailSizes(int modelId,
+                                const std::vector<ThumbnailImage>& images) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  beginTransaction();
+
+  bool ok = deleteThumbnailSizes(modelId);
+  for (size_t i = 0; ok && i < images.size(); ++i) {
+    const ThumbnailImage& image = images[i];
+    sqlite3_stmt* stmt = prepareStatement(
+        "INSERT OR REPLACE INTO thumbnails (model_id, size, format, data) "
+        "VALUES (?, ?, ?, ?);");
+    ok = stmt != nullptr && !image.data.empty();
+    if (ok) {
+      sqlite3_bind_int(stmt, 1, modelId);
+      sqlite3_bind_int(stmt, 2, image.size);
+      sqlite3_bind_text(stmt, 3, image.format.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_blob(stmt, 4, image.data.data(),
+                        static_cast<int>(image.data.size()), SQLITE_TRANSIENT);
+      ok = executePreparedStatement(stmt);
+    } else if (stmt) {
+      sqlite3_finalize(stmt);
+    }
+  }
+
+  if (!ok) {
+    std::cerr << "Failed to store thumbnails for model " << modelId
+              << std::endl;
+    executeSQL("ROLLBACK;");
+    return false;
+  }
+  commitTransaction();
+
+  invalidateThumbnailImages(modelId);
+  return true;
+}
+
+bool Model::deleteThumbnailSizes(int modelId) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt =
+      prepareStatement("DELETE FROM thumbnails WHERE model_id = ?;");
+  if (!stmt) return false;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  if (!executePreparedStatement(stmt)) return false;
+  invalidateThumbnailImages(modelId);
+  return true;
+}
+
+std::vector<int> Model::getThumbnailSizes(int modelId) const {
+  std::vector<int> sizes;
+  sqlite3_stmt* stmt = prepareStatement(
+      "SELECT size FROM thumbnails WHERE model_id = ? ORDER BY size;");
+  if (!stmt) return sizes;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    sizes.push_back(sqlite3_column_int(stmt, 0));
+  }
+  sqlite3_finalize(stmt);
+  return sizes;
+}
+
+ThumbnailImage Model::getThumbnail(int modelId, int minSize) const {
+  ThumbnailImage image;
+
+  // Large enough sizes sort first, smallest of them leading; otherwise the
+  // largest available size wins
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        SELECT size, format, data FROM thumbnails WHERE model_id = ?1
+        ORDER BY size >= ?2 DESC,
+                 CASE WHEN size >= ?2 THEN size ELSE -size END
+        LIMIT 1;
+    )");
+  if (!stmt) return image;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  sqlite3_bind_int(stmt, 2, minSize);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    image.size = sqlite3_column_int(stmt, 0);
+    const char* format =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    image.format = format ? format : "";
+    const void* blob = sqlite3_column_blob(stmt, 2);
+    int blobSize = sqlite3_column_bytes(stmt, 2);
+    if (blob && blobSize > 0) {
+      image.data.assign(static_cast<const char*>(blob),
+                        static_cast<const char*>(blob) + blobSize);
+    }
+  }
+  sqlite3_finalize(stmt);
+  if (!image.data.empty()) return image;
+
+  // Catalogs from before mipmaps, or the coarse preview until the full
+  // render replaces it
+  stmt = prepareStatement(R"(
+        SELECT CASE WHEN length(thumbnail) > 0 THEN thumbnail
+                    ELSE coarse_thumbnail END
+        FROM models WHERE id = ?;
+    )");
+  if (!stmt) return image;
+
+  sqlite3_bind_int(stmt, 1, modelId);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    const void* blob = sqlite3_column_blob(stmt, 0);
+    int blobSize = sqlite3_column_bytes(stmt, 0);
+    if (blob && blobSize > 0) {
+      image.format = "png";
+      image.data.assign(static_cast<const char*>(blob),
+                        static_cast<const char*>(blob) + blobSize);
+    }
+  }
+  sqlite3_finalize(stmt);
+  return image;
+}
+
+QPixmap Model::thumbnailPixmap(int modelId, int minSize) const {
+  auto key = std::make_pair(modelId, minSize);
+  {
+    std::lock_guard<std::mutex> lock(imageCacheMutex);
+    if (const QImage* cached = imageCache.object(key)) {
+      return QPixmap::fromImage(*cached);
+    }
   }
 
-  std::string sql = "DELETE FROM models WHERE id = ?;";
-  sqlite3_stmt* stmt;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
-
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    sqlite3_bind_int(stmt, 1, id);
+  ThumbnailImage stored = getThumbnail(modelId, minSize);
+  if (stored.data.empty()) {
+    return QPixmap();
+  }
+  QImage image = QImage::fromData(
+      reinterpret_cast<const uchar*>(stored.data.data()),
+      static_cast<int>(stored.data.size()), stored.format.c_str());
+  if (image.isNull()) {
+    return QPixmap();
+  }
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-      std::cerr << "Delete model failed: " << sqlite3_errmsg(db) << std::endl;
-      sqlite3_finalize(stmt);
-      return false;
-    }
-    sqlite3_finalize(stmt);
+  cacheImage(key, image);
+  return QPixmap::fromImage(image);
+}
 
-    // Remove from models vector
-    for (int row = 0; row < static_cast<int>(models.size()); ++row) {
-      if (models[row].id == id) {
-        beginRemoveRows(QModelIndex(), row, row);
-        models.erase(models.begin() + row);
-        endRemoveRows();
-        break;
-      }
-    }
+bool Model::storeViewAtlas(int modelId, const ThumbnailImage& atlas) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt =
+      prepareStatement("UPDATE models SET view_atlas = ? WHERE id = ?;");
+  if (!stmt) return false;
 
-    return true;
+  if (!atlas.data.empty()) {
+    sqlite3_bind_blob(stmt, 1, atlas.data.data(),
+                      static_cast<int>(atlas.data.size()), SQLITE_TRANSIENT);
   } else {
-    std::cerr << "SQL error in deleteModel: " << sqlite3_errmsg(db)
-              << std::endl;
-    return false;
+    sqlite3_bind_null(stmt, 1);
   }
+  sqlite3_bind_int(stmt, 2, modelId);
+  if (!executePreparedStatement(stmt)) return false;
+  invalidateThumbnailImages(modelId);
+  return true;
 }
 
-bool Model::modelExists(int id) {
-  std::string sql = "SELECT COUNT(*) FROM models WHERE id = ?;";
-  sqlite3_stmt* stmt;
-  int count = 0;
-  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+std::vector<char> Model::getViewAtlas(int modelId) const {
+  std::vector<char> atlas;
+  sqlite3_stmt* stmt =
+      prepareStatement("SELECT view_atlas FROM models WHERE id = ?;");
+  if (!stmt) return atlas;
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    sqlite3_bind_int(stmt, 1, id);
+  sqlite3_bind_int(stmt, 1, modelId);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    const void* blob = sqlite3_column_blob(stmt, 0);
+    int blobSize = sqlite3_column_bytes(stmt, 0);
+    if (blob && blobSize > 0) {
+      atlas.assign(static_cast<const char*>(blob),
+                   static_cast<const char*>(blob) + blobSize);
+    }
+  }
+  sqlite3_finalize(stmt);
+  return atlas;
+}
 
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-      count = sqlite3_column_int(stmt, 0);
+QPixmap Model::viewAtlasPixmap(int modelId) const {
+  auto key = std::make_pair(modelId, VIEW_ATLAS_SIZE);
+  {
+    std::lock_guard<std::mutex> lock(imageCacheMutex);
+    if (const QImage* cached = imageCache.object(key)) {
+      return cached->isNull() ? QPixmap() : QPixmap::fromImage(*cached);
     }
-    sqlite3_finalize(stmt);
-  } else {
-    std::cerr << "SQL error in modelExists: " << sqlite3_errmsg(db)
-              << std::endl;
   }
 
-  return count > 0;
+  // Also memoizes a missing atlas as a null image, so cards without one
+  // do not query the database on every paint
+  std::vector<char> stored = getViewAtlas(modelId);
+  QImage image;
+  if (!stored.empty()) {
+    image = QImage::fromData(reinterpret_cast<const uchar*>(stored.data()),
+                             static_cast<int>(stored.size()));
+  }
+
+  cacheImage(key, image);
+  return image.isNull() ? QPixmap() : QPixmap::fromImage(image);
 }
 
-ModelData Model::getModelById(int id) {
-  std::string sql = R"(
-        SELECT id, short_name, primary_file, override_info, title, thumbnail, author, file_path, library_name, is_selected, is_processed, is_included
-        FROM models WHERE id = ?;
-    )";
-  sqlite3_stmt* stmt;
-  ModelData model;
+bool Model::storeMetrics(int modelId, const GeometryMetrics& metrics) {
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
-
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    sqlite3_bind_int(stmt, 1, id);
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-      model.id = sqlite3_column_int(stmt, 0);
-      model.short_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      model.primary_file =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      model.override_info =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      model.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-
-      const void* blob = sqlite3_column_blob(stmt, 5);
-      int blob_size = sqlite3_column_bytes(stmt, 5);
-      if (blob && blob_size > 0) {
-        model.thumbnail.assign(static_cast<const char*>(blob),
-                               static_cast<const char*>(blob) + blob_size);
+  beginTransaction();
+
+  // Unsampled values stay NULL, so range queries skip them; a comb count
+  // of -1 keeps the one the probe stored
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        UPDATE models SET primitive_count = ?1, region_count = ?2,
+            comb_count = CASE WHEN ?3 < 0 THEN comb_count ELSE ?3 END,
+            tree_depth = ?4,
+            bbox_min_x = ?5, bbox_min_y = ?6, bbox_min_z = ?7,
+            bbox_max_x = ?8, bbox_max_y = ?9, bbox_max_z = ?10,
+            volume = ?11, volume_error = ?12,
+            surface_area = ?13, surface_area_error = ?14,
+            measured_at = strftime('%s', 'now')
+        WHERE id = ?15;
+    )");
+  bool ok = stmt != nullptr;
+  if (ok) {
+    sqlite3_bind_int(stmt, 1, metrics.primitive_count);
+    sqlite3_bind_int(stmt, 2, metrics.region_count);
+    sqlite3_bind_int(stmt, 3, metrics.comb_count);
+    sqlite3_bind_int(stmt, 4, metrics.tree_depth);
+    const double sampled[] = {
+        metrics.bbox_min[0], metrics.bbox_min[1], metrics.bbox_min[2],
+        metrics.bbox_max[0], metrics.bbox_max[1], metrics.bbox_max[2],
+        metrics.volume,      metrics.volume_error, metrics.surface_area,
+        metrics.surface_area_error};
+    for (int i = 0; i < 10; ++i) {
+      if (metrics.sampled) {
+        sqlite3_bind_double(stmt, 5 + i, sampled[i]);
+      } else {
+        sqlite3_bind_null(stmt, 5 + i);
       }
+    }
+    sqlite3_bind_int(stmt, 15, modelId);
+    ok = executePreparedStatement(stmt);
+  }
 
-      model.author =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      model.file_path =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-      model.library_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-      model.is_selected = sqlite3_column_int(stmt, 9) != 0;
-      model.is_processed = sqlite3_column_int(stmt, 10) != 0;
-      model.is_included = sqlite3_column_int(stmt, 11) != 0;
+  ok = ok && deletePrimitiveCounts(modelId);
+  if (ok && !metrics.primitive_types.empty()) {
+    stmt = prepareStatement(
+        "INSERT INTO primitive_counts (model_id, type, count) "
+        "VALUES (?, ?, ?);");
+    ok = stmt != nullptr;
+    for (auto it = metrics.primitive_types.begin();
+         ok && it != metrics.primitive_types.end(); ++it) {
+      sqlite3_bind_int(stmt, 1, modelId);
+      sqlite3_bind_text(stmt, 2, it->first.c_str(), -1, SQLITE_STATIC);
+      sqlite3_bind_int(stmt, 3, it->second);
+      if (sqlite3_step(stmt) != SQLITE_DONE) {
+        std::cerr << "Insert primitive count failed: " << sqlite3_errmsg(db)
+                  << std::endl;
+        ok = false;
+      }
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
     }
     sqlite3_finalize(stmt);
-  } else {
-    std::cerr << "Failed to select model: " << sqlite3_errmsg(db) << std::endl;
   }
 
-  return model;
+  if (!ok) {
+    std::cerr << "Failed to store metrics for model " << modelId << std::endl;
+    executeSQL("ROLLBACK;");
+    return false;
+  }
+  commitTransaction();
+
+  return true;
 }
 
-ModelData Model::getModelByFilePath(const std::string& filePath) {
-  ModelData model;
-  model.id = 0;
-  std::string sql = R"(
-        SELECT id, short_name, primary_file, override_info, title, thumbnail,
-               author, file_path, library_name, is_selected, is_processed, is_included
-        FROM models WHERE file_path = ?;
-    )";
-  sqlite3_stmt* stmt;
+bool Model::storeMeasurements(int modelId, const GeometryMetrics& metrics) {
+  if (!metrics.sampled) {
+    return false;
+  }
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        UPDATE models SET
+            bbox_min_x = ?1, bbox_min_y = ?2, bbox_min_z = ?3,
+            bbox_max_x = ?4, bbox_max_y = ?5, bbox_max_z = ?6,
+            volume = ?7, volume_error = ?8,
+            surface_area = ?9, surface_area_error = ?10,
+            measured_at = strftime('%s', 'now')
+        WHERE id = ?11;
+    )");
+  if (!stmt) {
+    return false;
+  }
+  const double sampled[] = {
+      metrics.bbox_min[0], metrics.bbox_min[1], metrics.bbox_min[2],
+      metrics.bbox_max[0], metrics.bbox_max[1], metrics.bbox_max[2],
+      metrics.volume,      metrics.volume_error, metrics.surface_area,
+      metrics.surface_area_error};
+  for (int i = 0; i < 10; ++i) {
+    sqlite3_bind_double(stmt, 1 + i, sampled[i]);
+  }
+  sqlite3_bind_int(stmt, 11, modelId);
+  if (!executePreparedStatement(stmt)) {
+    std::cerr << "Failed to store measurements for model " << modelId
+              << std::endl;
+    return false;
+  }
+  return true;
+}
 
-  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-    // Use SQLITE_TRANSIENT to ensure SQLite makes its own copy of the data
-    sqlite3_bind_text(stmt, 1, filePath.c_str(), -1, SQLITE_TRANSIENT);
-
-    // Debugging statements
-    // qDebug() << "Executing SQL:" << QString::fromStdString(sql);
-    // qDebug() << "With filePath:" << QString::fromStdString(filePath);
-
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-      model.id = sqlite3_column_int(stmt, 0);
-
-      const char* text;
-
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      model.short_name = text ? text : "";
-
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      model.primary_file = text ? text : "";
-
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      model.override_info = text ? text : "";
-
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-      model.title = text ? text : "";
+GeometryMetrics Model::getMetrics(int modelId) const {
+  GeometryMetrics metrics;
+  sqlite3_stmt* stmt = prepareStatement(R"(
+        SELECT primitive_count, region_count, comb_count, tree_depth,
+               bbox_min_x, bbox_min_y, bbox_min_z,
+               bbox_max_x, bbox_max_y, bbox_max_z,
+               volume, volume_error, surface_area, surface_area_error
+        FROM models WHERE id = ?;
+    )");
+  if (!stmt) return metrics;
 
-      const void* blob = sqlite3_column_blob(stmt, 5);
-      int blob_size = sqlite3_column_bytes(stmt, 5);
-      if (blob && blob_size > 0) {
-        model.thumbnail.assign(static_cast<const char*>(blob),
-                               static_cast<const char*>(blob) + blob_size);
-      } else {
-        model.thumbnail.clear();
+  sqlite3_bind_int(stmt, 1, modelId);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    metrics.primitive_count = sqlite3_column_int(stmt, 0);
+    metrics.region_count = sqlite3_column_int(stmt, 1);
+    metrics.comb_count = sqlite3_column_int(stmt, 2);
+    metrics.tree_depth = sqlite3_column_int(stmt, 3);
+    metrics.sampled = sqlite3_column_type(stmt, 10) != SQLITE_NULL;
+    if (metrics.sampled) {
+      for (int axis = 0; axis < 3; ++axis) {
+        metrics.bbox_min[axis] = sqlite3_column_double(stmt, 4 + axis);
+        metrics.bbox_max[axis] = sqlite3_column_double(stmt, 7 + axis);
       }
+      metrics.volume = sqlite3_column_double(stmt, 10);
+      metrics.volume_error = sqlite3_column_double(stmt, 11);
+      metrics.surface_area = sqlite3_column_double(stmt, 12);
+      metrics.surface_area_error = sqlite3_column_double(stmt, 13);
+    }
+  }
+  sqlite3_finalize(stmt);
 
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      model.author = text ? text : "";
-
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-      model.file_path = text ? text : "";
+  stmt = prepareStatement(
+      "SELECT type, count FROM primitive_counts WHERE model_id = ?;");
+  if (!stmt) return metrics;
+  sqlite3_bind_int(stmt, 1, modelId);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char* type =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    metrics.primitive_types[type ? type : ""] = sqlite3_column_int(stmt, 1);
+  }
+  sqlite3_finalize(stmt);
+  return metrics;
+}
 
-      text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-      model.library_name = text ? text : "";
+bool Model::deletePrimitiveCounts(int modelId) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt =
+      prepareStatement("DELETE FROM primitive_counts WHERE model_id = ?;");
+  if (!stmt) return false;
 
-      model.is_selected = sqlite3_column_int(stmt, 9) != 0;
-      model.is_processed = sqlite3_column_int(stmt, 10) != 0;
-      model.is_included = sqlite3_column_int(stmt, 11) != 0;
+  sqlite3_bind_int(stmt, 1, modelId);
+  return executePreparedStatement(stmt);
+}
 
-      qDebug() << "Model found with id:" << model.id
-               << "and filePath:" << QString::fromStdString(model.file_path);
-    } else {
-      qDebug() << "No model found with filePath:"
-               << QString::fromStdString(filePath);
+void Model::invalidateThumbnailImages(int modelId) {
+  std::lock_guard<std::mutex> lock(imageCacheMutex);
+  for (const auto& key : imageCache.keys()) {
+    if (key.first == modelId) {
+      imageCache.remove(key);
     }
-
-    sqlite3_finalize(stmt);
-  } else {
-    std::cerr << "Failed to select model by file path: " << sqlite3_errmsg(db)
-              << std::endl;
   }
+}
 
-  return model;
+void Model::cacheImage(const std::pair<int, int>& key,
+                       const QImage& image) const {
+  // A null image still costs its entry; the atlas memoizes misses
+  const qsizetype cost = std::max<qsizetype>(image.sizeInBytes(), 64);
+  std::lock_guard<std::mutex> lock(imageCacheMutex);
+  imageCache.insert(key, new QImage(image), cost);
 }
 
-void Model::loadModelsFromDatabase() {
-  std::vector<ModelData> loadedModels;
+std::vector<ObjectData> Model::getStructureHashedObjects() {
+  std::vector<ObjectData> objects;
   std::string sql = R"(
-        SELECT id, short_name, primary_file, override_info, title, thumbnail, author, file_path, library_name, is_selected, is_processed, is_included
-        FROM models;
+        SELECT object_id, model_id, name, parent_object_id, is_selected,
+               structure_hash
+        FROM objects
+        WHERE structure_hash IS NOT NULL
+        ORDER BY structure_hash;
     )";
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  sqlite3_stmt* stmt = prepareStatement(sql);
+  if (!stmt) return objects;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ObjectData obj;
+    obj.object_id = sqlite3_column_int(stmt, 0);
+    obj.model_id = sqlite3_column_int(stmt, 1);
+    obj.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+    obj.parent_object_id = sqlite3_column_type(stmt, 3) != SQLITE_NULL
+                               ? sqlite3_column_int(stmt, 3)
+                               : -1;
+    obj.is_selected = sqlite3_column_int(stmt, 4) != 0;
+    obj.structure_hash =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+    objects.push_back(obj);
+  }
+  sqlite3_finalize(stmt);
+  return objects;
+}
+
+std::vector<ModelData> Model::getAllModels() {
+  std::vector<ModelData> allModels;
+  std::string sql = "SELECT " + MODEL_COLUMNS + " FROM models;";
   sqlite3_stmt* stmt;
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
   if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-      ModelData model;
-      model.id = sqlite3_column_int(stmt, 0);
-      model.short_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      model.primary_file =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      model.override_info =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      model.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-
-      const void* blob = sqlite3_column_blob(stmt, 5);
-      int blob_size = sqlite3_column_bytes(stmt, 5);
-      if (blob && blob_size > 0) {
-        model.thumbnail.assign(static_cast<const char*>(blob),
-                               static_cast<const char*>(blob) + blob_size);
-      }
-
-      model.author =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      model.file_path =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-      model.library_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-      model.is_selected = sqlite3_column_int(stmt, 9) != 0;
-      model.is_processed = sqlite3_column_int(stmt, 10) != 0;
-      model.is_included = sqlite3_column_int(stmt, 11) != 0;
-
-      loadedModels.push_back(model);
+      allModels.push_back(readModelRow(stmt));
     }
     sqlite3_finalize(stmt);
-
-    // Update the models vector
-    beginResetModel();
-    models = std::move(loadedModels);
-    endResetModel();
-
   } else {
-    std::cerr << "Failed to select models: " << sqlite3_errmsg(db) << std::endl;
-  }
-}
-
-int Model::hashModel(const std::string& modelDir) {
-  qDebug() << "hashModel called with modelDir:"
-           << QString::fromStdString(modelDir);
-
-  std::ifstream file(modelDir, std::ios::binary);
-  if (!file.is_open()) {
-    std::cerr << "Could not open file for hashing: " << modelDir << std::endl;
-    return 0;
+    std::cerr << "Failed to select all models: " << sqlite3_errmsg(db)
+              << std::endl;
   }
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string fileContents = buffer.str();
-
-  std::hash<std::string> hasher;
-  int hashValue = static_cast<int>(hasher(fileContents));
-
-  qDebug() << "Hash value for" << QString::fromStdString(modelDir) << ":"
-           << hashValue;
-
-  return hashValue;
+  return allModels;
 }
 
 void Model::printModel(const ModelData& modelData) {
@@ -699,6 +1879,65 @@ bool Model::executeSQL(const std::string& sql) {
 
 void Model::refreshModelData() { loadModelsFromDatabase(); }
 
+void Model::refreshModels(const std::vector<int>& ids) {
+  if (ids.empty()) {
+    return;
+  }
+  // Well within SQLite's host parameter limit; bigger sets reload anyway
+  if (ids.size() > 500) {
+    loadModelsFromDatabase();
+    return;
+  }
+
+  std::string sql = "SELECT " + LIST_COLUMNS + " FROM models WHERE id IN (";
+  for (size_t i = 0; i < ids.size(); ++i) {
+    sql += (i == 0) ? "?" : ",?";
+  }
+  sql += ");";
+
+  std::vector<ModelData> loaded;
+  {
+    sqlite3_stmt* stmt;
+    std::lock_guard<std::recursive_mutex> lock(db_mutex);
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      std::cerr << "Failed to select models: " << sqlite3_errmsg(db)
+                << std::endl;
+      return;
+    }
+    for (size_t i = 0; i < ids.size(); ++i) {
+      sqlite3_bind_int(stmt, static_cast<int>(i) + 1, ids[i]);
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      loaded.push_back(readModelRow(stmt));
+    }
+    sqlite3_finalize(stmt);
+  }
+
+  std::set<int> distinct(ids.begin(), ids.end());
+  if (loaded.size() != distinct.size()) {
+    loadModelsFromDatabase();
+    return;
+  }
+
+  std::map<int, int> rowOf;
+  for (int row = 0; row < static_cast<int>(models.size()); ++row) {
+    rowOf[models[row].id] = row;
+  }
+  for (const auto& modelData : loaded) {
+    if (rowOf.find(modelData.id) == rowOf.end()) {
+      loadModelsFromDatabase();
+      return;
+    }
+  }
+
+  for (auto& modelData : loaded) {
+    int row = rowOf[modelData.id];
+    models[row] = std::move(modelData);
+    QModelIndex modelIndex = index(row);
+    emit dataChanged(modelIndex, modelIndex);
+  }
+}
+
 bool Model::setData(const QModelIndex& index, const QVariant& value, int role) {
   if (!index.isValid() || index.row() < 0 ||
       index.row() >= static_cast<int>(models.size()))
@@ -772,8 +2011,9 @@ Qt::ItemFlags Model::flags(const QModelIndex& index) const {
 // Object Operations
 int Model::insertObject(const ObjectData& obj) {
   std::string sql = R"(
-        INSERT INTO objects (model_id, name, parent_object_id, is_selected)
-        VALUES (?, ?, ?, ?);
+        INSERT INTO objects (model_id, name, parent_object_id, is_selected,
+                             structure_hash)
+        VALUES (?, ?, ?, ?, ?);
     )";
 
   sqlite3_stmt* stmt;
@@ -796,6 +2036,12 @@ int Model::insertObject(const ObjectData& obj) {
 
   sqlite3_bind_int(stmt, 4, obj.is_selected ? 1 : 0);
 
+  if (!obj.structure_hash.empty()) {
+    sqlite3_bind_text(stmt, 5, obj.structure_hash.c_str(), -1, SQLITE_STATIC);
+  } else {
+    sqlite3_bind_null(stmt, 5);
+  }
+
   if (sqlite3_step(stmt) != SQLITE_DONE) {
     std::cerr << "Insert object failed: " << sqlite3_errmsg(db) << std::endl;
     sqlite3_finalize(stmt);
@@ -832,9 +2078,11 @@ bool Model::deleteObjectsForModel(int model_id) {
 std::vector<ObjectData> Model::getObjectsForModel(int model_id) {
   std::vector<ObjectData> objects;
   std::string sql = R"(
-        SELECT object_id, model_id, name, parent_object_id, is_selected
+        SELECT object_id, model_id, name, parent_object_id, is_selected,
+               structure_hash
         FROM objects
-        WHERE model_id = ?;
+        WHERE model_id = ?
+        ORDER BY object_id;
     )";
 
   sqlite3_stmt* stmt;
@@ -856,6 +2104,10 @@ std::vector<ObjectData> Model::getObjectsForModel(int model_id) {
       }
 
       obj.is_selected = sqlite3_column_int(stmt, 4) != 0;
+
+      const char* hash =
+          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+      obj.structure_hash = hash ? hash : "";
       objects.push_back(obj);
     }
     sqlite3_finalize(stmt);
@@ -1062,9 +2314,14 @@ bool Model::updateObjectParentId(int object_id, int parent_object_id) {
 bool Model::deleteTables() {
   std::string sqlDeleteModels = "DROP TABLE IF EXISTS models;";
   std::string sqlDeleteObjects = "DROP TABLE IF EXISTS objects;";
+  std::string sqlDeleteThumbnails = "DROP TABLE IF EXISTS thumbnails;";
+  std::string sqlDeletePrimitiveCounts =
+      "DROP TABLE IF EXISTS primitive_counts;";
 
   // Execute SQL commands to delete tables
-  return executeSQL(sqlDeleteModels) && executeSQL(sqlDeleteObjects);
+  return executeSQL(sqlDeleteModels) && executeSQL(sqlDeleteObjects) &&
+         executeSQL(sqlDeleteThumbnails) &&
+         executeSQL(sqlDeletePrimitiveCounts);
 }
 
 void Model::resetDatabase() {
@@ -1076,6 +2333,134 @@ void Model::resetDatabase() {
   }
 }
 
+int64_t Model::pragmaValue(const std::string& pragma) {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  int64_t value = 0;
+  sqlite3_stmt* stmt = prepareStatement("PRAGMA " + pragma + ";");
+  if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+    value = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+  return value;
+}
+
+int64_t Model::databaseSize() {
+  std::lock_guard<std::recursive_mutex> lock(db_mutex);
+  int64_t pageCount = 0;
+  int64_t pageSize = 0;
+
+  sqlite3_stmt* stmt = prepareStatement("PRAGMA page_count;");
+  if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+    pageCount = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+
+  stmt = prepareStatement("PRAGMA page_size;");
+  if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+    pageSize = sqlite3_column_int64(stmt, 0);
+  }
+  sqlite3_finalize(stmt);
+
+  return pageCount * pageSize;
+}
+
+GarbageReport Model::collectGarbage() {
+  GarbageReport report;
+
+  // Tags are the user's vocabulary and stay even when no model uses them;
+  // only rows pointing at nothing are removed
+  {
+    std::lock_guard<std::recursive_mutex> lock(db_mutex);
+    report.database_bytes_before = databaseSize();
+
+    auto deleteRows = [this](const std::string& sql) {
+      if (!executeSQL(sql)) return 0;
+      return sqlite3_changes(db);
+    };
+
+    beginTransaction();
+    report.orphan_objects = deleteRows(
+        "DELETE FROM objects WHERE model_id NOT IN (SELECT id FROM models);");
+    report.orphan_model_tags = deleteRows(
+        "DELETE FROM model_tags WHERE model_id NOT IN (SELECT id FROM models) "
+        "OR tag_id NOT IN (SELECT id FROM tags);");
+    report.orphan_thumbnails = deleteRows(
+        "DELETE FROM thumbnails WHERE model_id NOT IN (SELECT id FROM models);");
+    report.orphan_primitive_counts = deleteRows(
+        "DELETE FROM primitive_counts WHERE model_id NOT IN "
+        "(SELECT id FROM models);");
+    commitTransaction();
+  }
+
+  // Previews are temporary render outputs; anything left behind is from an
+  // interrupted render. Recent files may still be in use by a running one.
+  fs::path previews = fs::path(hiddenDirPath) / "previews";
+  std::error_code ec;
+  if (fs::is_directory(previews, ec)) {
+    auto cutoff = fs::file_time_type::clock::now() - std::chrono::minutes(10);
+    for (const auto& entry : fs::directory_iterator(previews, ec)) {
+      if (!entry.is_regular_file(ec) || entry.last_write_time(ec) > cutoff) {
+        continue;
+      }
+      auto size = entry.file_size(ec);
+      if (fs::remove(entry.path(), ec)) {
+        report.stale_previews++;
+        report.preview_bytes += static_cast<int64_t>(size);
+      }
+    }
+  }
+
+  // db_mutex is never held across the vacuum, so UI queries go on
+  // meanwhile. Catalogs created before auto_vacuum was enabled need one
+  // full VACUUM to switch modes; it runs on a connection of its own, where
+  // readers can proceed and writers wait on the busy timeout.
+  if (pragmaValue("auto_vacuum") != 2) {
+    sqlite3* vacuumDb = nullptr;
+    if (sqlite3_open(dbPath.c_str(), &vacuumDb) == SQLITE_OK) {
+      sqlite3_busy_timeout(vacuumDb, BUSY_TIMEOUT_MS);
+      char* errMsg = nullptr;
+      if (sqlite3_exec(vacuumDb, "PRAGMA auto_vacuum = INCREMENTAL; VACUUM;",
+                       nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Catalog VACUUM failed: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+      }
+    } else {
+      std::cerr << "Can't open database for VACUUM at " << dbPath
+                << std::endl;
+    }
+    sqlite3_close(vacuumDb);
+  } else {
+    // Free pages go back a chunk at a time, each under the lock briefly
+    int64_t freePages = pragmaValue("freelist_count");
+    while (freePages > 0) {
+      std::lock_guard<std::recursive_mutex> lock(db_mutex);
+      if (!executeSQL("PRAGMA incremental_vacuum(" +
+                      std::to_string(VACUUM_CHUNK_PAGES) + ");")) {
+        break;
+      }
+      int64_t left = pragmaValue("freelist_count");
+      if (left >= freePages) break;
+      freePages = left;
+    }
+  }
+
+  {
+    // Keep planner statistics current as the catalog churns
+    std::lock_guard<std::recursive_mutex> lock(db_mutex);
+    executeSQL("PRAGMA optimize;");
+    report.database_bytes_after = databaseSize();
+  }
+
+  std::cout << "Catalog GC: " << report.orphan_objects << " objects, "
+            << report.orphan_model_tags << " tag links, "
+            << report.orphan_thumbnails
+            << " thumbnails, " << report.orphan_primitive_counts
+            << " primitive counts, " << report.stale_previews
+            << " previews removed; " << report.bytesReclaimed()
+            << " bytes reclaimed" << std::endl;
+  return report;
+}
+
 // Tag Operations
 bool Model::addTagToModel(int modelId, const std::string& tagName) {
   // Insert the tag if it doesn't already exist
@@ -1274,45 +2659,14 @@ bool Model::executePreparedStatement(sqlite3_stmt* stmt) {
 
 std::vector<ModelData> Model::getIncludedModels() {
   std::vector<ModelData> includedModels;
-  std::string sql = R"(
-        SELECT id, short_name, primary_file, override_info, title, thumbnail,
-               author, file_path, library_name, is_selected, is_processed, is_included
-        FROM models
-        WHERE is_included = 1;
-    )";
+  std::string sql =
+      "SELECT " + MODEL_COLUMNS + " FROM models WHERE is_included = 1;";
   sqlite3_stmt* stmt;
   std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
   if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-      ModelData model;
-      model.id = sqlite3_column_int(stmt, 0);
-      model.short_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-      model.primary_file =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-      model.override_info =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-      model.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-
-      const void* blob = sqlite3_column_blob(stmt, 5);
-      int blob_size = sqlite3_column_bytes(stmt, 5);
-      if (blob && blob_size > 0) {
-        model.thumbnail.assign(static_cast<const char*>(blob),
-                               static_cast<const char*>(blob) + blob_size);
-      }
-
-      model.author =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-      model.file_path =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-      model.library_name =
-          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-      model.is_selected = sqlite3_column_int(stmt, 9) != 0;
-      model.is_processed = sqlite3_column_int(stmt, 10) != 0;
-      model.is_included = sqlite3_column_int(stmt, 11) != 0;
-
-      includedModels.push_back(model);
+      includedModels.push_back(readModelRow(stmt));
     }
     sqlite3_finalize(stmt);
   } else {
@@ -1347,41 +2701,19 @@ bool Model::isFileIncluded(const std::string& filePath) {
 std::vector<ModelData> Model::getIncludedNotProcessedModels() {
     std::vector<ModelData> notProcessedModels;
 
-    const char* sql = R"(
-        SELECT id, short_name, primary_file, override_info, title,
-               thumbnail, author, file_path, library_name, is_selected,
-               is_processed, is_included
-        FROM models
-        WHERE is_included = 1 AND is_processed = 0;
-    )";
+    // Quarantined files are left alone, failing ones until their backoff ends
+    std::string sql = "SELECT " + MODEL_COLUMNS +
+                      " FROM models WHERE is_included = 1 AND is_processed = 0"
+                      " AND crash_count < ?"
+                      " AND retry_after <= strftime('%s', 'now');";
 
     sqlite3_stmt* stmt;
     std::lock_guard<std::recursive_mutex> lock(db_mutex);
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, QUARANTINE_CRASHES);
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            ModelData modelData;
-            modelData.id = sqlite3_column_int(stmt, 0);
-            modelData.short_name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            modelData.primary_file = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-            modelData.override_info = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-            modelData.title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-
-            const void* thumbnailBlob = sqlite3_column_blob(stmt, 5);
-            int thumbnailSize = sqlite3_column_bytes(stmt, 5);
-            if (thumbnailBlob && thumbnailSize > 0) {
-                const char* blobPtr = static_cast<const char*>(thumbnailBlob);
-                modelData.thumbnail.assign(blobPtr, blobPtr + thumbnailSize);
-            }
-
-            modelData.author = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
-            modelData.file_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
-            modelData.library_name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
-            modelData.is_selected = sqlite3_column_int(stmt, 9) == 1;
-            modelData.is_processed = sqlite3_column_int(stmt, 10) == 1;
-            modelData.is_included = sqlite3_column_int(stmt, 11) == 1;
-
-            notProcessedModels.push_back(modelData);
+            notProcessedModels.push_back(readModelRow(stmt));
         }
 
         sqlite3_finalize(stmt);
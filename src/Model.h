@@ -12,7 +12,28 @@
 #include <sqlite3.h>
 #include <QMetaType>
 
+#include "ContentHasher.h"
+#include "GFileProbe.h"
+#include "GeometryMetrics.h"
+#include "ThumbnailRenderer.h"
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <map>
+
 // ModelData structure
+// Indexing stages; each records when it last succeeded and its last error
+enum class ProcessingStage { Probe, Extract, Render, Tag };
+
+// Stored in the per-stage error columns
+enum StageError {
+  StageOk = 0,
+  StageFailed = 1,     // the stage ran but produced nothing usable
+  StageCrashed = 2,    // the helper process died
+  StageTimedOut = 3
+};
+
 struct ModelData {
   int id;
   std::string short_name;
@@ -27,11 +48,72 @@ struct ModelData {
   bool is_processed;
   bool is_included;
   std::vector<std::string> tags;
+
+  // Fingerprint of the file when it was last hashed
+  std::string content_hash;
+  int64_t file_size = 0;
+  int64_t file_mtime = 0;
+  uint64_t file_inode = 0;
+
+  // Progressive previews: a quick low-resolution pass, refined later.
+  // Timestamps are seconds since the epoch, 0 when the pass has not run.
+  std::vector<char> coarse_thumbnail;
+  int64_t coarse_rendered_at = 0;
+  int64_t thumbnail_rendered_at = 0;
+
+  // From the header probe; 0 and -1 until the file was probed
+  int db_version = 0;
+  int64_t object_count = -1;
+  int64_t comb_count = -1;
+  int64_t mesh_count = -1;
+  int64_t mesh_bytes = -1;
+
+  // Helper-process crashes and timeouts while indexing this file
+  int crash_count = 0;
+
+  // Per-stage progress: when each stage last succeeded (seconds since the
+  // epoch, 0 if not yet) and its last StageError. Renders are timed by
+  // the rendered_at columns above.
+  int64_t probed_at = 0;
+  int probe_error = StageOk;
+  int64_t extracted_at = 0;
+  int extract_error = StageOk;
+  int render_error = StageOk;
+  int64_t tagged_at = 0;
+  int tag_error = StageOk;
+
+  // Failed attempts in a row; the indexer waits until retry_after
+  int failure_count = 0;
+  int64_t retry_after = 0;
+
+  // Wall time of the last full render, or the time it was given before
+  // it timed out (see render_error); 0 if never rendered in full
+  int64_t render_ms = 0;
+
+  // Highest resident memory a job on this file was seen to need, in
+  // bytes; 0 if never measured (see MemoryBudget)
+  int64_t peak_rss = 0;
 };
 
 // Declare ModelData as a Qt metatype
 Q_DECLARE_METATYPE(ModelData)
 
+// Outcome of a catalog garbage collection pass
+struct GarbageReport {
+  int orphan_objects = 0;
+  int orphan_model_tags = 0;
+  int orphan_thumbnails = 0;
+  int orphan_primitive_counts = 0;
+  int stale_previews = 0;
+  int64_t preview_bytes = 0;
+  int64_t database_bytes_before = 0;
+  int64_t database_bytes_after = 0;
+
+  int64_t bytesReclaimed() const {
+    return preview_bytes + (database_bytes_before - database_bytes_after);
+  }
+};
+
 // ObjectData structure
 struct ObjectData {
   int object_id;
@@ -39,6 +121,9 @@ struct ObjectData {
   std::string name;
   int parent_object_id;
   bool is_selected;
+
+  // Name-independent Merkle hash of a combination's tree, empty otherwise
+  std::string structure_hash;
 };
 
 class Model : public QAbstractListModel {
@@ -58,7 +143,8 @@ public:
         IsSelectedRole,
         IsIncludedRole,
         IsProcessedRole,
-		TagsRole
+		TagsRole,
+        ViewAtlasRole       // QPixmap of square views side by side, null if none
     };
 
     explicit Model(const std::string& libraryPath, QObject* parent = nullptr);
@@ -81,12 +167,113 @@ public:
     bool deleteTables();
     void resetDatabase();
 
+    /*
+     * Removes orphaned rows and preview files, then gives free pages back
+     * without holding the catalog lock through the vacuum. Tags are kept,
+     * used or not.
+     */
+    GarbageReport collectGarbage();
+    int64_t databaseSize();
+
     // Getters
     ModelData getModelById(int id);
 
     // Utility methods
     int hashModel(const std::string& modelDir);
+
+    // Content fingerprints (size, mtime, 64-bit content hash)
+    bool updateFingerprint(int id, const FileFingerprint& fingerprint);
+    std::vector<FileFingerprint> fingerprintModels(const std::vector<ModelData>& modelsToHash);
+    // The valid ones of fingerprints, computed elsewhere, in one transaction
+    void storeFingerprints(const std::vector<ModelData>& hashedModels,
+                           const std::vector<FileFingerprint>& fingerprints);
+
+    // Header probe results; the title only replaces that of unprocessed models
+    bool storeHeader(int id, const GFileHeader& header);
+    std::vector<GFileHeader> probeModels(const std::vector<ModelData>& modelsToProbe);
+    // Probe results computed elsewhere, failures included, in one transaction
+    void storeHeaders(const std::vector<ModelData>& probedModels,
+                      const std::vector<GFileHeader>& headers);
+
+    // Drop extracted objects and thumbnail so the indexer picks the model up again
+    bool markModelForReprocessing(int id);
+
+    // Files that crashed or hung this many helper processes are quarantined:
+    // the indexer skips them until their contents change
+    static const int QUARANTINE_CRASHES = 3;
+    bool recordCrash(int id);
+
+    /*
+     * Records the outcome of one stage. A failed extract or render backs
+     * the model off for RETRY_BASE_SECONDS * 2^(failures - 1), at most
+     * RETRY_MAX_SECONDS. Crashes and extraction timeouts also count toward
+     * quarantine; render timeouts only once the render was given the
+     * longest limit (RenderCostModel::MAX_RETRY_DOUBLINGS failures before).
+     * A successful render clears the failures. Successful extractions are
+     * recorded by storeExtraction itself.
+     */
+    static const int RETRY_BASE_SECONDS = 60;
+    static const int RETRY_MAX_SECONDS = 24 * 60 * 60;
+    bool recordStage(int id, ProcessingStage stage, int error);
+
+    /*
+     * Geometry metrics, in queryable models columns (bbox_min_x ..
+     * bbox_max_z, volume, surface_area, region_count, ...) and the
+     * primitive_counts table. Unsampled values are stored as NULL.
+     */
+    bool storeMetrics(int modelId, const GeometryMetrics& metrics);
+    // Only the sampled columns, as the full render measures them; counts stay
+    bool storeMeasurements(int modelId, const GeometryMetrics& metrics);
+    GeometryMetrics getMetrics(int modelId) const;
+
+    // Render times feed RenderCostModel; getRenderTimings returns only
+    // the id, size, primitive mix and timing of the latest limit renders
+    bool recordRenderTime(int id, int64_t renderMs);
+    std::vector<ModelData> getRenderTimings(int limit = 1000);
+    // Keeps the highest peak seen since the model was last reprocessed
+    bool recordPeakRss(int id, int64_t bytes);
+
+    // Point an existing model at a new location, keeping all of its data
+    bool relocateModel(int id, const std::string& newFilePath);
+    std::vector<ModelData> getModelsByFileSize(int64_t fileSize);
+
+    // Duplicate handling: exact copies reuse one extraction and thumbnail
+    ModelData findProcessedDuplicate(const std::string& contentHash, int excludeId);
+    bool copyExtraction(int sourceModelId, int targetModelId);
+    std::vector<ObjectData> getStructureHashedObjects();
+
+    // Indexing results. parent_object_id in objects is an index into the
+    // vector (-1 for top level); parents must come before their children.
+    // Called from the indexer's writer thread, so they only write the
+    // catalog; refreshModels() on the GUI thread brings the rows up to date.
+    bool storeExtraction(int modelId, const std::string& title,
+                         const std::vector<ObjectData>& objects);
+    bool storeThumbnail(int modelId, const std::vector<char>& thumbnail);
+    bool storeCoarseThumbnail(int modelId, const std::vector<char>& thumbnail);
+
+    // Included models showing a coarse preview whose full render has not
+    // succeeded yet, leaving out those in backoff or quarantine
+    std::vector<ModelData> getModelsPendingFullRender();
+
+    // Preview mipmaps (thumbnails table); storing replaces every size
+    bool storeThumbnailSizes(int modelId, const std::vector<ThumbnailImage>& images);
+    std::vector<int> getThumbnailSizes(int modelId) const;
+    // Smallest stored size of at least minSize, else the largest. Without
+    // mipmaps, the full or else coarse PNG as size 0; no data if none.
+    ThumbnailImage getThumbnail(int modelId, int minSize) const;
+    // Decoded getThumbnail(), memoized for painting
+    QPixmap thumbnailPixmap(int modelId, int minSize) const;
+
+    // "multiViewPreviews" atlas (see ThumbnailRenderer::packAtlas); empty
+    // until a full render with the setting on. Reprocessing drops it.
+    bool storeViewAtlas(int modelId, const ThumbnailImage& atlas);
+    std::vector<char> getViewAtlas(int modelId) const;
+    // Decoded getViewAtlas(), memoized like thumbnailPixmap
+    QPixmap viewAtlasPixmap(int modelId) const;
     void refreshModelData();
+    // Rereads just these models and updates their rows in place; models
+    // this list does not hold yet, or no longer exist, reload it all
+    void refreshModels(const std::vector<int>& ids);
     void printModel(const ModelData& modelData);
 
     std::string getHiddenDirectoryPath() const;
@@ -114,6 +301,7 @@ public:
 
     ModelData getModelByFilePath(const std::string& filePath);
     std::vector<ModelData> getIncludedModels();
+    std::vector<ModelData> getAllModels();
 
     void beginTransaction();
     void commitTransaction();
@@ -140,7 +328,12 @@ public:
 private:
     // Database related
     bool createTables();
+    bool addColumnIfMissing(const std::string& table, const std::string& column,
+                            const std::string& definition);
+    ModelData readModelRow(sqlite3_stmt* stmt) const;
     bool executeSQL(const std::string& sql);
+    // First column of "PRAGMA pragma;", 0 if it returns nothing
+    int64_t pragmaValue(const std::string& pragma);
     bool shortNameExists(const std::string& short_name);
     bool filePathExists(const std::string& file_path);
     sqlite3* db;
@@ -148,6 +341,24 @@ private:
     std::recursive_mutex db_mutex;
     std::string hiddenDirPath;
     std::vector<ModelData> models;
+
+    // Plain DELETE, safe inside a caller's transaction
+    bool deleteThumbnailSizes(int modelId);
+    bool deletePrimitiveCounts(int modelId);
+
+    // Inserts objects whose parent_object_id is an index into objects
+    // (parents first), reusing one statement; runs in the caller's
+    // transaction
+    bool insertObjectTree(int modelId, const std::vector<ObjectData>& objects);
+
+    // Decoded mipmaps by (model id, requested size), least recently used
+    // dropped past IMAGE_CACHE_BYTES; QImage so that the indexing thread
+    // may drop entries. The view atlas is kept under VIEW_ATLAS_SIZE.
+    static const int VIEW_ATLAS_SIZE = -1;
+    void invalidateThumbnailImages(int modelId);
+    void cacheImage(const std::pair<int, int>& key, const QImage& image) const;
+    mutable std::mutex imageCacheMutex;
+    mutable QCache<std::pair<int, int>, QImage> imageCache;
 };
 
 #endif  // MODEL_H
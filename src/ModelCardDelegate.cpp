@@ -5,6 +5,7 @@
 #include <QMouseEvent>
 #include <QStyle>
 
+#include <algorithm>
 #include <iostream>
 
 ModelCardDelegate::ModelCardDelegate(QObject* parent)
@@ -43,8 +44,16 @@ void ModelCardDelegate::paint(QPainter* painter, const QStyleOptionViewItem& opt
     QRect iconR = iconRect(option);
 
 
-    // draw thumbnail or placeholder
-    if (!thumbnail.isNull()) {
+    // Hovered card with more views: show the one under the pointer
+    QPixmap atlas;
+    if ((option.state & QStyle::State_MouseOver) && hoveredIndex == index && hoveredView > 0) {
+        atlas = index.data(Model::ViewAtlasRole).value<QPixmap>();
+    }
+    const int tileSize = atlas.height();
+    if (!atlas.isNull() && tileSize > 0 && hoveredView < atlas.width() / tileSize) {
+        QPixmap tile = atlas.copy(hoveredView * tileSize, 0, tileSize, tileSize);
+        painter->drawPixmap(previewR, tile.scaled(previewR.size(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+    } else if (!thumbnail.isNull()) {
         painter->drawPixmap(previewR, thumbnail.scaled(previewR.size(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
     } else {
         // placeholder if no thumbnail
@@ -87,6 +96,10 @@ QSize ModelCardDelegate::sizeHint(const QStyleOptionViewItem& option,
 
 bool ModelCardDelegate::editorEvent(QEvent* event, QAbstractItemModel* model,
                                     const QStyleOptionViewItem& option, const QModelIndex& index) {
+    if (event->type() == QEvent::MouseMove) {
+        updateHoveredView(option, index, static_cast<QMouseEvent*>(event)->pos());
+    }
+
     if (event->type() == QEvent::MouseButtonRelease || event->type() == QEvent::MouseButtonPress) {
         QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
         QPoint pos = mouseEvent->pos();
@@ -105,6 +118,29 @@ bool ModelCardDelegate::editorEvent(QEvent* event, QAbstractItemModel* model,
     return QStyledItemDelegate::editorEvent(event, model, option, index);
 }
 
+void ModelCardDelegate::updateHoveredView(const QStyleOptionViewItem& option, const QModelIndex& index,
+                                          const QPoint& pos) {
+    QRect previewR = previewRect(option);
+    int view = 0;
+    if (previewR.contains(pos)) {
+        QPixmap atlas = index.data(Model::ViewAtlasRole).value<QPixmap>();
+        int views = atlas.isNull() || atlas.height() == 0 ? 0 : atlas.width() / atlas.height();
+        if (views > 1) {
+            view = std::clamp((pos.x() - previewR.left()) * views / previewR.width(), 0, views - 1);
+        }
+    }
+
+    if (hoveredIndex == index && view == hoveredView) {
+        return;
+    }
+    QModelIndex previous = hoveredIndex;
+    hoveredIndex = index;
+    hoveredView = view;
+    if (previous.isValid() && previous != index) {
+        emit previewViewChanged(previous);
+    }
+    emit previewViewChanged(index);
+}
 
 // Helper methods to calculate component rectangles
 QRect ModelCardDelegate::previewRect(const QStyleOptionViewItem& option) const {
@@ -2,6 +2,7 @@
 #define MODELCARDDELEGATE_H
 
 #include <QStyledItemDelegate>
+#include <QPersistentModelIndex>
 #include <QPixmap>
 
 class ModelCardDelegate : public QStyledItemDelegate {
@@ -23,11 +24,22 @@ public:
 signals:
     void geometryBrowserClicked(int modelId);
     void modelViewClicked(int modelId);
+    // The card needs repainting: the pointer moved to another of its views
+    void previewViewChanged(const QModelIndex& index);
 
 private:
     QRect previewRect(const QStyleOptionViewItem& option) const;
     QRect textRect(const QStyleOptionViewItem& option) const;
 
+    /*
+     * Cards of models with a multi-view atlas show the view under the
+     * pointer: the preview is split into one vertical band per view. Needs
+     * mouse tracking on the view.
+     */
+    void updateHoveredView(const QStyleOptionViewItem& option, const QModelIndex& index, const QPoint& pos);
+    QPersistentModelIndex hoveredIndex;
+    int hoveredView = 0;
+
 };
 
 #endif // MODELCARDDELEGATE_H
@@ -1,12 +1,14 @@
 #include "ModelParser.h"
+#include "ContentHasher.h"
+#include "Model.h"
+#include <brlcad/raytrace.h>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
-#include <array>
-#include <memory>
 #include <algorithm>
-#include <sstream>
-#include "executeCommand.h"
+#include <cstring>
+#include <deque>
+#include <unordered_map>
 
 #ifdef _WIN32
 #define _CRT_SECURE_NO_WARNINGS  
@@ -17,58 +19,191 @@ ModelParser::ModelParser() {
     // Constructor implementation (if needed)
 }
 
+std::string convertToUnixPath(const std::string& windowsPath) {
+    std::string unixPath = windowsPath;
+    std::replace(unixPath.begin(), unixPath.end(), '\\', '/'); 
+    if (unixPath.find("C:/") == 0) {
+        unixPath.replace(0, 2, "/mnt/c");
+    }
+    return unixPath;
+}
+
 /**
-* @brief Fetches object files from a BRL-CAD model file
-* 
-* @param path Path to the BRL-CAD model file
-* @return A vector of object file names
+* @brief Reads title and object paths from the catalog
+*
+* Only used when the model was processed and the file has not changed
+* since (same size and modification time as when it was fingerprinted).
 */
-std::vector<std::string> fetchObjectFiles(const std::string& path) {
-    std::vector<std::string> objectFiles;
+bool ModelParser::readFromCatalog(const std::string& filepath, Model* model, ModelMetadata& metadata) {
+    if (!model) {
+        return false;
+    }
 
-    for (int i = 1; i < 10; i++) {
-        std::string command = "mged -c \"" + path + "\" search / -depth " + std::to_string(i);
-        std::string output = executeCommandNoWindow(command);
+    ModelData modelData = model->getModelByFilePath(filepath);
+    if (modelData.id == 0 || !modelData.is_processed) {
+        return false;
+    }
 
-        // Ensure output lines are properly split
-        std::istringstream objStream(output);
-        std::string obj;
+    int64_t size = 0;
+    int64_t mtime = 0;
+    if (!ContentHasher::statFile(filepath, size, mtime) ||
+        size != modelData.file_size || mtime != modelData.file_mtime) {
+        return false;
+    }
 
-        while (std::getline(objStream, obj)) {
-            // Trim whitespace
-            obj.erase(0, obj.find_first_not_of(" \t\r\n"));
-            obj.erase(obj.find_last_not_of(" \t\r\n") + 1);
+    metadata.title = modelData.title;
+
+    // Objects come back parents-first, so each path extends its parent's
+    std::vector<ObjectData> objects = model->getObjectsForModel(modelData.id);
+    std::unordered_map<int, std::pair<std::string, int>> paths;
+    std::vector<std::vector<std::string>> byDepth(MAX_OBJECT_DEPTH);
+    for (const auto& obj : objects) {
+        std::string path = "/" + obj.name;
+        int depth = 1;
+        auto parent = paths.find(obj.parent_object_id);
+        if (parent != paths.end()) {
+            path = parent->second.first + path;
+            depth = parent->second.second + 1;
+        }
+        if (depth > MAX_OBJECT_DEPTH) {
+            continue;
+        }
+        paths[obj.object_id] = { path, depth };
+        byDepth[depth - 1].push_back(path);
+    }
 
-            // Skip empty lines
-            if (!obj.empty()) {
-                objectFiles.push_back(obj);
-            }
+    // Same order as searching one depth at a time
+    for (auto& level : byDepth) {
+        for (auto& path : level) {
+            metadata.objectFiles.push_back(std::move(path));
         }
     }
+    return true;
+}
 
-    // Debugging: Final check on the collected object files
-    if (objectFiles.empty()) {
-        std::cerr << "ERROR: Object files vector is still empty after parsing!" << std::endl;
+/**
+* @brief Opens the .g file once and reads title and object paths
+*/
+bool ModelParser::readFromDatabase(const std::string& filepath, ModelMetadata& metadata) {
+    struct db_i* dbip = db_open(filepath.c_str(), DB_OPEN_READONLY);
+    if (dbip == DBI_NULL) {
+        std::cerr << "ERROR: Unable to open BRL-CAD database: " << filepath << std::endl;
+        return false;
+    }
+    if (db_dirbuild(dbip) < 0) {
+        std::cerr << "ERROR: Unable to read directory of BRL-CAD database: " << filepath << std::endl;
+        db_close(dbip);
+        return false;
     }
 
-    return objectFiles;
+    metadata.title = dbip->dbi_title ? dbip->dbi_title : "";
+    metadata.objectFiles = listObjectPaths(dbip);
+
+    db_close(dbip);
+    return true;
 }
 
+namespace {
+
+void listCombMembers(const union tree* tree, std::vector<std::string>& members) {
+    if (!tree) return;
+
+    switch (tree->tr_op) {
+    case OP_UNION:
+    case OP_INTERSECT:
+    case OP_SUBTRACT:
+    case OP_XOR:
+        listCombMembers(tree->tr_b.tb_left, members);
+        listCombMembers(tree->tr_b.tb_right, members);
+        break;
+    case OP_NOT:
+    case OP_GUARD:
+    case OP_XNOP:
+        listCombMembers(tree->tr_b.tb_left, members);
+        break;
+    case OP_DB_LEAF:
+        if (tree->tr_l.tl_name) {
+            members.push_back(tree->tr_l.tl_name);
+        }
+        break;
+    default:
+        break;
+    }
+}
 
-std::string fetchTitle(const std::string& path) {
-    return executeCommandNoWindow("mged -c \"" + path + "\" title 2>&1");
 }
 
-std::string convertToUnixPath(const std::string& windowsPath) {
-    std::string unixPath = windowsPath;
-    std::replace(unixPath.begin(), unixPath.end(), '\\', '/'); 
-    if (unixPath.find("C:/") == 0) {
-        unixPath.replace(0, 2, "/mnt/c");
+/**
+* @brief Lists object paths breadth-first from the top-level objects
+*
+* Each combination is read once, however many assemblies share it.
+*/
+std::vector<std::string> ModelParser::listObjectPaths(struct db_i* dbip) {
+    std::vector<std::string> objectFiles;
+
+    // Own resource: tagging may run while the indexer uses librt
+    struct resource resource;
+    std::memset(&resource, 0, sizeof(resource));
+    rt_init_resource(&resource, 0, nullptr);
+
+    std::unordered_map<struct directory*, std::vector<struct directory*>> members;
+    auto combMembers = [&](struct directory* dp) -> const std::vector<struct directory*>& {
+        auto cached = members.find(dp);
+        if (cached != members.end()) {
+            return cached->second;
+        }
+        std::vector<struct directory*>& children = members[dp];
+        struct rt_db_internal intern;
+        if (rt_db_get_internal(&intern, dp, dbip, nullptr, &resource) < 0) {
+            return children;
+        }
+        std::vector<std::string> names;
+        listCombMembers(static_cast<struct rt_comb_internal*>(intern.idb_ptr)->tree, names);
+        rt_db_free_internal(&intern);
+        for (const auto& name : names) {
+            struct directory* child = db_lookup(dbip, name.c_str(), LOOKUP_QUIET);
+            if (child) {
+                children.push_back(child);
+            }
+        }
+        return children;
+    };
+
+    struct PendingPath {
+        struct directory* dp;
+        std::string path;
+        int depth;
+    };
+    std::deque<PendingPath> pending;
+
+    struct directory** tops = nullptr;
+    size_t topCount = db_ls(dbip, DB_LS_TOPS, nullptr, &tops);
+    for (size_t i = 0; i < topCount; ++i) {
+        pending.push_back({ tops[i], std::string("/") + tops[i]->d_namep, 1 });
     }
-    return unixPath;
+    if (tops) {
+        bu_free(tops, "ModelParser tops");
+    }
+
+    // The depth limit also ends reference cycles
+    while (!pending.empty()) {
+        PendingPath next = std::move(pending.front());
+        pending.pop_front();
+        objectFiles.push_back(next.path);
+
+        if (next.depth >= MAX_OBJECT_DEPTH || !(next.dp->d_flags & RT_DIR_COMB)) {
+            continue;
+        }
+        for (struct directory* child : combMembers(next.dp)) {
+            pending.push_back({ child, next.path + "/" + child->d_namep, next.depth + 1 });
+        }
+    }
+
+    rt_clean_resource_basic(nullptr, &resource);
+    return objectFiles;
 }
 
-ModelMetadata ModelParser::parseModel(std::string filepath) {
+ModelMetadata ModelParser::parseModel(std::string filepath, Model* model) {
     ModelMetadata metadata;
 
     std::string fixedPath;
@@ -89,10 +224,17 @@ ModelMetadata ModelParser::parseModel(std::string filepath) {
 
     metadata.filepath = filepath;
 
-    metadata.title = fetchTitle(filepath);
-    metadata.title.erase(metadata.title.find_last_not_of("\n\r") + 1);
+    // The catalog already holds what indexing extracted; the file is only
+    // opened when it is not cataloged or changed since
+    if (!readFromCatalog(filepath, model, metadata) &&
+        !readFromDatabase(fixedPath, metadata)) {
+        return metadata;
+    }
 
-    metadata.objectFiles = fetchObjectFiles(filepath);
+    // Debugging: Final check on the collected object files
+    if (metadata.objectFiles.empty()) {
+        std::cerr << "ERROR: Object files vector is still empty after parsing!" << std::endl;
+    }
 
     return metadata;
-}
\ No newline at end of file
+}
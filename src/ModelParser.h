@@ -5,11 +5,18 @@
 #include <vector>
 #include "ModelMetadata.h" 
 
+class Model;
+struct db_i;
+
 /**
  * @brief Parses BRL-CAD model files to extract metadata
  *
  * Extracts title, object names, and structural information from
  * BRL-CAD .g files to provide context for the AI tagging system.
+ *
+ * When the file is in a catalog whose extraction is current, the
+ * metadata is read from there; otherwise the .g file is opened once
+ * in-process and walked.
  */
 class ModelParser {
 public:
@@ -19,10 +26,19 @@ public:
     /**
 	* @brief Parses a BRL-CAD model file to extract metadata
     * 
+    * @param model Catalog to read the metadata from, if it has the file
 	* @return ModelMetadata object containing the parsed information
 	* @see ModelMetadata.cpp/.h
     */
-    ModelMetadata parseModel(std::string filepath);
+    ModelMetadata parseModel(std::string filepath, Model* model = nullptr);
+
+    // Object paths such as "/all.g/body.c" go at most this deep
+    static const int MAX_OBJECT_DEPTH = 9;
+
+private:
+    bool readFromCatalog(const std::string& filepath, Model* model, ModelMetadata& metadata);
+    bool readFromDatabase(const std::string& filepath, ModelMetadata& metadata);
+    std::vector<std::string> listObjectPaths(struct db_i* dbip);
 };
 
-#endif // MODELPARSER_H
\ No newline at end of file
+#endif // MODELPARSER_H
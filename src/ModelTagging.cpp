@@ -122,13 +122,13 @@ ModelTagging::~ModelTagging(){
     }
 }
 
-void ModelTagging::generateTags(const std::string& filepath) {
+void ModelTagging::generateTags(const std::string& filepath, Model* model) {
 	m_generationCanceled = false; // Reset the cancellation 
     m_accumulatedOutput.clear();
 
     logToFile("generateTags() called with: " + filepath);
 
-    auto blockingTask = [this, filepath]() -> bool {
+    auto blockingTask = [this, filepath, model]() -> bool {
         // Check if Ollama is available.
         if (!checkOllamaAvailability()) {
             std::cerr << "ERROR: Ollama is not available." << std::endl;
@@ -144,7 +144,7 @@ void ModelTagging::generateTags(const std::string& filepath) {
 
         // Parse metadata.
         logToFile("Ollama and model available. Parsing metadata...");
-        ModelMetadata metadata = parser.parseModel(filepath);
+        ModelMetadata metadata = parser.parseModel(filepath, model);
         logToFile("Metadata parsed. Title: " + metadata.title + ", Object count: " + std::to_string(metadata.objectFiles.size()));
 
         // Build the prompt.
@@ -40,9 +40,10 @@ public:
      * to generate descriptive tags based on model structure and metadata.
      *
      * @param filepath Path to the 3D model file to analyze
+     * @param model Catalog holding the file, read instead of the file when current
      * @return true if tag generation was successful, false otherwise
      */
-    void generateTags(const std::string& filepath);
+    void generateTags(const std::string& filepath, Model* model = nullptr);
 
 	/**
 	 * @brief Cancels the ongoing tag generation process
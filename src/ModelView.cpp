@@ -3,6 +3,7 @@
 #include <qboxlayout.h>
 
 #include <QFileDialog>
+#include <algorithm>
 #include <iostream>
 
 #include "Model.h"
@@ -46,18 +47,51 @@ ModelView::ModelView(int modelId, Model* model, QWidget* parent)
           this, &ModelView::onOkClicked);
   connect(ui.generateTagsButton, &QPushButton::clicked, this, &ModelView::onGenerateTagsClicked);
   connect(ui.cancelTagButton, &QPushButton::clicked, this, &ModelView::onCancelTagGenerationClicked);
+  connect(ui.nextViewButton, &QPushButton::clicked, this,
+          &ModelView::onNextViewClicked);
 
 }
 
 void ModelView::loadPreviewImage() {
-  QPixmap thumbnail;
-  thumbnail.loadFromData(
-      reinterpret_cast<const uchar*>(currModel.thumbnail.data()),
-      currModel.thumbnail.size());
+  // Smallest stored size that fills the label
+  QSize labelSize = ui.previewLabel->size() * devicePixelRatio();
+  QPixmap thumbnail = model->thumbnailPixmap(
+      modelId, std::max(labelSize.width(), labelSize.height()));
+
+  if (thumbnail.isNull()) {
+    // The full render may still be pending; the coarse pass is better than nothing
+    const std::vector<char>& png = !currModel.thumbnail.empty()
+                                       ? currModel.thumbnail
+                                       : currModel.coarse_thumbnail;
+    thumbnail.loadFromData(
+        reinterpret_cast<const uchar*>(png.data()),
+        png.size());
+  }
   thumbnail = thumbnail.scaled(ui.previewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
   ui.previewLabel->setPixmap(thumbnail);
+
+  // Further views were traced with the thumbnail; paging through them
+  // only crops the atlas
+  viewAtlas = model->viewAtlasPixmap(modelId);
+  viewCount = viewAtlas.isNull() || viewAtlas.height() == 0
+                  ? 0
+                  : viewAtlas.width() / viewAtlas.height();
+  ui.nextViewButton->setVisible(viewCount > 1);
+}
+
+void ModelView::showView(int view) {
+  if (viewCount <= 1) return;
+
+  currentView = view % viewCount;
+  int tileSize = viewAtlas.height();
+  QPixmap tile = viewAtlas.copy(currentView * tileSize, 0, tileSize, tileSize);
+  ui.previewLabel->setPixmap(tile.scaled(ui.previewLabel->size(),
+                                         Qt::KeepAspectRatio,
+                                         Qt::SmoothTransformation));
 }
 
+void ModelView::onNextViewClicked() { showView(currentView + 1); }
+
 void ModelView::populateProperties() {
   ui.keysList->clear();
   ui.valuesList->clear();
@@ -80,6 +114,34 @@ void ModelView::populateProperties() {
       valueItem->setForeground(Qt::blue);
     }
   }
+
+  // Read-only rows from the metrics stage
+  GeometryMetrics metrics = model->getMetrics(modelId);
+  auto addMetric = [this](const QString& key, const QString& value) {
+    QListWidgetItem* keyItem = new QListWidgetItem(key, ui.keysList);
+    QListWidgetItem* valueItem = new QListWidgetItem(value, ui.valuesList);
+    keyItem->setFlags(keyItem->flags() & ~Qt::ItemIsEditable);
+    valueItem->setFlags(valueItem->flags() & ~Qt::ItemIsEditable);
+  };
+  if (metrics.primitive_count >= 0) {
+    addMetric("primitives", QString::number(metrics.primitive_count));
+    addMetric("regions", QString::number(metrics.region_count));
+    addMetric("tree depth", QString::number(metrics.tree_depth));
+  }
+  if (metrics.sampled) {
+    addMetric("size (mm)",
+              QString("%1 x %2 x %3")
+                  .arg(metrics.bbox_max[0] - metrics.bbox_min[0], 0, 'g', 4)
+                  .arg(metrics.bbox_max[1] - metrics.bbox_min[1], 0, 'g', 4)
+                  .arg(metrics.bbox_max[2] - metrics.bbox_min[2], 0, 'g', 4));
+    addMetric("volume (mm^3)", QString("%1 +/- %2")
+                                  .arg(metrics.volume, 0, 'g', 4)
+                                  .arg(metrics.volume_error, 0, 'g', 2));
+    addMetric("surface area (mm^2)",
+              QString("%1 +/- %2")
+                  .arg(metrics.surface_area, 0, 'g', 4)
+                  .arg(metrics.surface_area_error, 0, 'g', 2));
+  }
 }
 
 void ModelView::onPropertyChanged(QListWidgetItem* item) {
@@ -222,6 +284,7 @@ void ModelView::onGenerateTagsClicked() {
                 }
             }
 
+            model->recordStage(modelId, ProcessingStage::Tag, tags.empty() ? StageFailed : StageOk);
             ui.tagStatusLabel->setText("Tags generated!");
             ui.generateTagsButton->setEnabled(true);
 			ui.generateTagsButton->setVisible(true);
@@ -231,7 +294,7 @@ void ModelView::onGenerateTagsClicked() {
             disconnect(modelTagging, &ModelTagging::tagsGenerated, this, nullptr);
         });
 
-    modelTagging->generateTags(filepath.toStdString());
+    modelTagging->generateTags(filepath.toStdString(), model);
 }
 
 
@@ -32,10 +32,12 @@ signals:
   void onOkClicked();
   void onGenerateTagsClicked();
   void onCancelTagGenerationClicked();
+  void onNextViewClicked();
 
  private:
   QFutureWatcher<std::vector<std::string>>* tagWatcher = nullptr;
   void loadPreviewImage();
+  void showView(int view);
   void populateProperties();
   void populateTags();
   void addTagItem(const QString& tagText);
@@ -47,6 +49,11 @@ signals:
   QMap<QString, QString> properties;
   QStringList tags;
   GeometryBrowserDialog* geometryBrowser;
+
+  // Multi-view atlas, if the model has one; view 0 is the thumbnail's view
+  QPixmap viewAtlas;
+  int viewCount = 0;
+  int currentView = 0;
 };
 
 #endif  // modelview_H
@@ -1,4 +1,9 @@
 #include "ProcessGFiles.h"
+#include "BackgroundMode.h"
+#include "ContentHasher.h"
+#include "RenderCostModel.h"
+#include "ThumbnailCache.h"
+#include "ThumbnailRenderer.h"
 #include <brlcad/ged.h>
 #include <QDebug>
 #include <iostream>
@@ -6,10 +11,14 @@
 #include <QSettings>
 #include <QFile>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
 #include "config.h"
 #include <string>
 #include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <functional>
 
 // Helper function to truncate a path if it exceeds maxLen (default 50 characters).
 // It keeps the first part and the last part of the path and places "..." in between.
@@ -24,99 +33,305 @@ static std::string truncatePath(const std::string& path, size_t maxLen = 20) {
 }
 
 ProcessGFiles::ProcessGFiles(Model* model)
-    : model(model)
+    : model(model), resp(&rt_uniresource)
 {
 }
 
+ProcessGFiles::ProcessGFiles(Model* model, int workerIndex)
+    : model(model), resp(&workerResource)
+{
+    std::memset(&workerResource, 0, sizeof(workerResource));
+    rt_init_resource(&workerResource, workerIndex, nullptr);
+}
+
+ProcessGFiles::~ProcessGFiles()
+{
+    if (resp == &workerResource) {
+        rt_clean_resource_basic(nullptr, &workerResource);
+    }
+}
+
 void ProcessGFiles::processGFile(const ModelData& modelData)
 {
+    // Serial form of the indexing pipeline: extract, store, render, store
+    ExtractionResult extraction = extract(modelData);
+    if (!persistExtraction(extraction)) {
+        return;
+    }
+    if (extraction.duplicateOf != 0) {
+        return;
+    }
+    RenderCostModel costs;
+    costs.calibrate(model->getRenderTimings());
+    extraction.renderCost = costs.estimate(extraction.modelData);
+    persistRender(render(extraction));
+}
+
+ExtractionResult ProcessGFiles::extract(const ModelData& modelData)
+{
+    ExtractionResult result;
+    result.modelData = modelData;
+
     // Use truncated path for debug output only.
     std::string displayPath = truncatePath(modelData.file_path);
-    qDebug() << "[ProcessGFiles::processGFile] Processing model with ID:" << modelData.id
+    qDebug() << "[ProcessGFiles::extract] Processing model with ID:" << modelData.id
         << "and file path:" << QString::fromStdString(displayPath);
 
     // Ensure file path is not empty
     if (modelData.file_path.empty()) {
-        qDebug() << "[ProcessGFiles::processGFile] No file path provided. Aborting.";
-        return;
+        qDebug() << "[ProcessGFiles::extract] No file path provided. Aborting.";
+        return result;
+    }
+
+    // An exact copy that was already processed supplies everything
+    if (reuseDuplicate(modelData, result) || resumeExtraction(modelData, result)) {
+        return result;
     }
 
     // Open the BRL-CAD database using the full path.
     const char* db_filename = modelData.file_path.c_str();
+    StageClock clock;
     struct ged* gedp = ged_open("db", db_filename, 0);
+    result.openTime = clock.elapsed();
     if (gedp == GED_NULL) {
-        qDebug() << "[ProcessGFiles::processGFile] Error: Unable to open BRL-CAD database at path:"
+        qDebug() << "[ProcessGFiles::extract] Error: Unable to open BRL-CAD database at path:"
             << QString::fromStdString(displayPath);
-        return;
+        return result;
     }
 
-    // Make a copy of modelData to modify
-    ModelData updatedModelData = modelData;
-    updatedModelData.is_processed = true;
+    hierarchy.clear();
+    nodesInProgress.clear();
+    clock.restart();
 
-    extractTitle(updatedModelData, gedp);
-    qDebug() << "[ProcessGFiles::processGFile] Title extracted:" << QString::fromStdString(updatedModelData.title);
+    extractTitle(result.modelData, gedp);
+    qDebug() << "[ProcessGFiles::extract] Title extracted:" << QString::fromStdString(result.modelData.title);
 
-    // Update the model in the database with the extracted title.
-    if (!model->updateModel(updatedModelData.id, updatedModelData)) {
-        qDebug() << "[ProcessGFiles::processGFile] Error: Could not update model in database for ID:"
-            << updatedModelData.id;
-        ged_close(gedp);
-        return;
+    extractObjects(result, gedp);
+
+    // Pick the object to render: the selected one, otherwise everything
+    for (const auto& obj : result.objects) {
+        if (obj.is_selected) {
+            result.thumbnailObject = obj.name;
+            break;
+        }
+    }
+    if (result.thumbnailObject.empty() && !result.objects.empty()) {
+        result.thumbnailObject = "all";
+        qDebug() << "[ProcessGFiles::extract] No specific object selected. Defaulting to 'all'.";
+    }
+
+    extractMetrics(result, gedp);
+    result.extractTime = clock.elapsed();
+    ged_close(gedp);
+
+    result.ok = true;
+    return result;
+}
+
+bool ProcessGFiles::reuseDuplicate(const ModelData& modelData, ExtractionResult& result)
+{
+    if (!model || modelData.content_hash.empty()) {
+        return false;
+    }
+
+    ModelData duplicate = model->findProcessedDuplicate(modelData.content_hash, modelData.id);
+    if (duplicate.id == 0) {
+        return false;
+    }
+    qDebug() << "[ProcessGFiles::reuseDuplicate] Model ID:" << modelData.id
+        << "is an exact copy of model ID:" << duplicate.id << "- reusing its extraction and thumbnail";
+    result.modelData = modelData;
+    result.duplicateOf = duplicate.id;
+    result.ok = true;
+    return true;
+}
+
+bool ProcessGFiles::resumeExtraction(const ModelData& modelData, ExtractionResult& result)
+{
+    if (!model || modelData.extracted_at == 0) {
+        return false;
+    }
+
+    // Same choice extract makes: the selected object, otherwise everything
+    result.modelData = modelData;
+    std::vector<ObjectData> selected = model->getSelectedObjectsForModel(modelData.id);
+    if (!selected.empty()) {
+        result.thumbnailObject = selected.front().name;
+    }
+    else if (!model->getObjectsForModel(modelData.id).empty()) {
+        result.thumbnailObject = "all";
+    }
+    qDebug() << "[ProcessGFiles::resumeExtraction] Model ID:" << modelData.id
+        << "was extracted by an earlier run; resuming at the render";
+    result.resumed = true;
+    result.ok = true;
+    return true;
+}
+
+bool ProcessGFiles::persistExtraction(const ExtractionResult& extraction)
+{
+    const int modelId = extraction.modelData.id;
+
+    // Failed jobs too: running out of memory is one way to fail
+    if (extraction.peakRss > 0) {
+        model->recordPeakRss(modelId, extraction.peakRss);
+    }
+
+    // Recorded so the model backs off instead of failing on every run
+    if (!extraction.ok) {
+        model->recordStage(modelId, ProcessingStage::Extract,
+                           extraction.error != StageOk ? extraction.error : StageFailed);
+        return false;
+    }
+
+    if (extraction.duplicateOf != 0) {
+        return model->copyExtraction(extraction.duplicateOf, modelId);
+    }
+
+    if (!extraction.resumed && !model->storeExtraction(modelId, extraction.modelData.title, extraction.objects)) {
+        qDebug() << "[ProcessGFiles::persistExtraction] Error: Could not store extraction for model ID:" << modelId;
+        return false;
+    }
+    if (!extraction.resumed && !model->storeMetrics(modelId, extraction.metrics)) {
+        qDebug() << "[ProcessGFiles::persistExtraction] Error storing geometry metrics for model ID:" << modelId;
     }
-    extractObjects(updatedModelData, gedp);
 
-    std::vector<ObjectData> allObjects = model->getObjectsForModel(updatedModelData.id);
-    if (allObjects.empty()) {
-        qDebug() << "[ProcessGFiles::processGFile] No objects found for model ID:" << updatedModelData.id
+    // Nothing to render: the model is complete now
+    if (extraction.thumbnailObject.empty()) {
+        qDebug() << "[ProcessGFiles::persistExtraction] No objects found for model ID:" << modelId
             << ". Skipping thumbnail generation.";
-        ged_close(gedp);
-        return;
+        RenderResult none;
+        none.modelId = modelId;
+        none.ok = true;
+        return persistRender(none);
     }
+    return true;
+}
 
-    qDebug() << "[ProcessGFiles::processGFile] Attempting thumbnail generation for model ID:" << updatedModelData.id;
+RenderResult ProcessGFiles::render(const ExtractionResult& extraction, bool coarse)
+{
+    StageClock clock;
+    RenderResult result;
+    result.modelId = extraction.modelData.id;
+    result.coarse = coarse;
+
+    if (extraction.thumbnailObject.empty()) {
+        return result;
+    }
 
-    std::vector<ObjectData> selectedObjects = model->getSelectedObjectsForModel(updatedModelData.id);
+    qDebug() << "[ProcessGFiles::render] Attempting thumbnail generation for model ID:" << result.modelId;
 
-    std::string objectNameForThumbnail;
-    if (!selectedObjects.empty()) {
-        const ObjectData& selectedObject = selectedObjects.front();
-        objectNameForThumbnail = selectedObject.name;
-        qDebug() << "[ProcessGFiles::processGFile] Found selected object. Using object named:"
-            << QString::fromStdString(objectNameForThumbnail) << "for thumbnail.";
+    // Coarse pass: small, one ray per pixel and flat colors, so a preview
+    // shows up quickly even for models whose full render takes long
+    ThumbnailOptions options;
+    if (coarse) {
+        options.size = 64;
+        options.hypersample = 0;
+        options.shaded = false;
     }
-    else {
-        if (!allObjects.empty()) {
-            objectNameForThumbnail = "all";
-            qDebug() << "[ProcessGFiles::processGFile] No specific object selected. Defaulting to 'all'.";
-        }
-        else {
-            qDebug() << "[ProcessGFiles::processGFile] No objects available for thumbnail generation.";
-            ged_close(gedp);
-            return;
+
+    // Big models get more time than small ones, retries more than the last attempt
+    const int timeLimitMs = RenderCostModel::timeLimitMs(extraction.modelData, extraction.renderCost, coarse);
+
+    ModelData modelData = extraction.modelData;
+    QSettings settings;
+
+    // Full renders also sample the geometry, on the session they trace with
+    GeometryMetrics* metrics = nullptr;
+    if (!coarse && settings.value("measureGeometry", true).toBool()) {
+        metrics = &result.metrics;
+    }
+    bool viewsRendered = false;
+    if (!coarse && settings.value("multiViewPreviews", false).toBool()) {
+        // Extra views cost only their rays; the first view stays the thumbnail
+        std::vector<std::vector<char>> pngs;
+        viewsRendered = generateViews(modelData, extraction.thumbnailObject, ThumbnailRenderer::viewSet(options),
+                                      timeLimitMs, result.renderMs, pngs, metrics);
+        if (viewsRendered) {
+            result.viewAtlas = ThumbnailRenderer::packAtlas(pngs);
+            modelData.thumbnail = std::move(pngs.front());
         }
     }
 
-    bool thumbnailGenerated = generateThumbnail(updatedModelData, objectNameForThumbnail);
-
-    if (!thumbnailGenerated) {
-        qDebug() << "[ProcessGFiles::processGFile] Thumbnail generation failed for model ID:" << updatedModelData.id;
+    if (viewsRendered) {
+        result.ok = true;
+    }
+    else if (timeLimitMs > 0 && result.renderMs >= timeLimitMs) {
+        result.ok = false;
     }
     else {
-        qDebug() << "[ProcessGFiles::processGFile] Thumbnail generated successfully for model ID:" << updatedModelData.id
-            << ". Updating model data in the database.";
-        if (!model->updateModel(updatedModelData.id, updatedModelData)) {
-            qDebug() << "[ProcessGFiles::processGFile] Error updating model thumbnail in database for ID:"
-                << updatedModelData.id;
-        }
-        else {
-            qDebug() << "[ProcessGFiles::processGFile] Successfully updated model thumbnail for model ID:" << updatedModelData.id;
+        // Time a failed view set took still counts against the limit
+        int64_t viewsMs = result.renderMs;
+        int remainingMs = timeLimitMs > 0 ? timeLimitMs - static_cast<int>(viewsMs) : 0;
+        result.ok = generateThumbnail(modelData, extraction.thumbnailObject, options, remainingMs, result.renderMs,
+                                      metrics);
+        result.renderMs += viewsMs;
+    }
+    if (result.ok) {
+        result.thumbnail = std::move(modelData.thumbnail);
+        // Encoded here, off the writer thread
+        result.sizes = ThumbnailRenderer::mipmaps(result.thumbnail);
+    }
+    else {
+        qDebug() << "[ProcessGFiles::render] Thumbnail generation failed for model ID:" << result.modelId;
+        if (timeLimitMs > 0 && result.renderMs >= timeLimitMs) {
+            result.error = StageTimedOut;
         }
     }
+    result.renderTime = clock.elapsedWall();
+    return result;
+}
+
+bool ProcessGFiles::persistRender(const RenderResult& render)
+{
+    // Sizes first, so views refreshed by the update below find them. A
+    // failed render leaves whatever preview sizes exist in place.
+    if (!render.sizes.empty() && !model->storeThumbnailSizes(render.modelId, render.sizes)) {
+        qDebug() << "[ProcessGFiles::persistRender] Error storing thumbnail sizes for ID:" << render.modelId;
+    }
 
-    ged_close(gedp);
-    // Use the truncated version for the final debug output.
-    qDebug() << "[ProcessGFiles::processGFile] Completed processing for path:" << QString::fromStdString(truncatePath(updatedModelData.file_path));
+    if (!render.ok) {
+        model->recordStage(render.modelId, ProcessingStage::Render,
+                           render.error != StageOk ? render.error : StageFailed);
+    }
+    else if (!render.coarse) {
+        model->recordStage(render.modelId, ProcessingStage::Render, StageOk);
+    }
+
+    // Full render times calibrate RenderCostModel; a timeout records how
+    // long the render was given, so the retry gets more (see timeLimitMs)
+    if (!render.coarse && render.renderMs > 0 && (render.ok || render.error == StageTimedOut)) {
+        model->recordRenderTime(render.modelId, render.renderMs);
+    }
+
+    if (render.peakRss > 0) {
+        model->recordPeakRss(render.modelId, render.peakRss);
+    }
+
+    if (!render.viewAtlas.data.empty() && !model->storeViewAtlas(render.modelId, render.viewAtlas)) {
+        qDebug() << "[ProcessGFiles::persistRender] Error storing the view atlas for ID:" << render.modelId;
+    }
+
+    if (render.metrics.sampled && !model->storeMeasurements(render.modelId, render.metrics)) {
+        qDebug() << "[ProcessGFiles::persistRender] Error storing measurements for ID:" << render.modelId;
+    }
+
+    // A failed render leaves the model pending: recordStage above backed it
+    // off, and it is rendered again once retry_after passes
+    if (!render.ok) {
+        qDebug() << "[ProcessGFiles::persistRender] Render failed for model ID:" << render.modelId
+            << "; it will be retried";
+        return false;
+    }
+    bool stored = render.coarse ? model->storeCoarseThumbnail(render.modelId, render.thumbnail)
+                                : model->storeThumbnail(render.modelId, render.thumbnail);
+    if (!stored) {
+        qDebug() << "[ProcessGFiles::persistRender] Error updating model thumbnail in database for ID:"
+            << render.modelId;
+        return false;
+    }
+    qDebug() << "[ProcessGFiles::persistRender] Completed processing for model ID:" << render.modelId;
+    return true;
 }
 
 void ProcessGFiles::extractTitle(ModelData& modelData, struct ged* gedp)
@@ -132,8 +347,9 @@ void ProcessGFiles::extractTitle(ModelData& modelData, struct ged* gedp)
     }
 }
 
-void ProcessGFiles::extractObjects(ModelData& modelData, struct ged* gedp)
+void ProcessGFiles::extractObjects(ExtractionResult& result, struct ged* gedp)
 {
+    const ModelData& modelData = result.modelData;
     qDebug() << "[ProcessGFiles::extractObjects] Started for model ID:" << modelData.id;
 
     if (!gedp || !gedp->dbip) {
@@ -181,181 +397,359 @@ void ProcessGFiles::extractObjects(ModelData& modelData, struct ged* gedp)
 
     qDebug() << "[ProcessGFiles::extractObjects] Selected object for thumbnail:" << QString::fromStdString(selected_object_name);
 
-    // Iterate over the directory entries for top-level objects
-    for (size_t i = 0; i < dir_count; ++i) {
-        std::string object_name(dir[i]->d_namep);
-        qDebug() << "[ProcessGFiles::extractObjects] Found top-level object name:" << QString::fromStdString(object_name);
-
-        // Create ObjectData for the top-level object
-        ObjectData topLevelObjData;
-
-        topLevelObjData.model_id = modelData.id;
-        topLevelObjData.name = object_name;
-        topLevelObjData.parent_object_id = -1; // -1 indicates no parent
-        topLevelObjData.is_selected = (object_name == selected_object_name);
-
-        qDebug() << "[ProcessGFiles::extractObjects] Inserting top-level object - "
-            << "Model ID:" << topLevelObjData.model_id
-            << ", Name:" << QString::fromStdString(topLevelObjData.name)
-            << ", Parent Object ID:" << topLevelObjData.parent_object_id
-            << ", is_selected:" << topLevelObjData.is_selected;
-
-        int insertedTopLevelObjectId = model->insertObject(topLevelObjData);
-        if (insertedTopLevelObjectId == -1) {
-            qDebug() << "[ProcessGFiles::extractObjects] Failed to insert top-level object:"
-                << QString::fromStdString(topLevelObjData.name)
-                << "for model ID:" << topLevelObjData.model_id;
-            continue;
+    // Walk the whole forest in preorder, so every parent precedes its
+    // children, the order Model::storeExtraction inserts in. The stack
+    // keeps deep assemblies off the call stack.
+    QSettings settings;
+    const size_t nodeLimit = static_cast<size_t>(std::max(1, settings.value("hierarchyNodeLimit", 250000).toInt()));
+
+    struct PendingObject {
+        struct directory* dp;
+        int parentIndex;
+    };
+    std::vector<PendingObject> pending;
+    for (size_t i = dir_count; i-- > 0;) {
+        pending.push_back({ dir[i], -1 });
+    }
+    bu_free(dir, "free directory list");
+
+    bool truncated = false;
+    while (!pending.empty()) {
+        if (result.objects.size() >= nodeLimit) {
+            truncated = true;
+            break;
         }
-        else {
-            topLevelObjData.object_id = insertedTopLevelObjectId;
-            qDebug() << "[ProcessGFiles::extractObjects] Successfully inserted top-level object:"
-                << QString::fromStdString(topLevelObjData.name)
-                << "with ID:" << insertedTopLevelObjectId << "for model ID:" << topLevelObjData.model_id;
+        PendingObject next = pending.back();
+        pending.pop_back();
+
+        // The parent is referenced by index until the persist stage assigns
+        // database ids
+        ObjectData objData;
+        objData.object_id = 0;
+        objData.model_id = modelData.id;
+        objData.name = next.dp->d_namep;
+        objData.parent_object_id = next.parentIndex;
+        objData.is_selected = (next.parentIndex == -1 && objData.name == selected_object_name);
+
+        int index = static_cast<int>(result.objects.size());
+        if (next.dp->d_flags & RT_DIR_COMB) {
+            const HierarchyNode& node = hierarchyNode(gedp->dbip, next.dp);
+            objData.structure_hash = ContentHasher::toHex(node.hash);
+            for (auto child = node.children.rbegin(); child != node.children.rend(); ++child) {
+                pending.push_back({ *child, index });
+            }
         }
+        result.objects.push_back(std::move(objData));
+    }
 
-        // If this top-level object is a combination, retrieve and insert its children
-        if (dir[i]->d_flags & RT_DIR_COMB) {
-            qDebug() << "[ProcessGFiles::extractObjects] Object" << QString::fromStdString(object_name) << "is a combination. Retrieving children.";
-            insertChildObjects(modelData, gedp, topLevelObjData, selected_object_name);
+    if (truncated) {
+        qDebug() << "[ProcessGFiles::extractObjects] Hierarchy of model ID:" << modelData.id
+            << "exceeds" << nodeLimit << "objects; the rest is not listed.";
+    }
+    qDebug() << "[ProcessGFiles::extractObjects] Completed for model ID:" << modelData.id
+        << "with" << result.objects.size() << "objects from" << hierarchy.size() << "distinct entries";
+}
+
+void ProcessGFiles::extractMetrics(ExtractionResult& result, struct ged* gedp)
+{
+    if (!gedp || !gedp->dbip) {
+        return;
+    }
+    struct db_i* dbip = gedp->dbip;
+    GeometryMetrics& metrics = result.metrics;
+
+    metrics.primitive_count = 0;
+    metrics.region_count = 0;
+    metrics.comb_count = 0;
+    metrics.primitive_types.clear();
+    struct directory* dp;
+    FOR_ALL_DIRECTORY_START(dp, dbip) {
+        if (dp->d_flags & RT_DIR_COMB) {
+            metrics.comb_count++;
+            if (dp->d_flags & RT_DIR_REGION) {
+                metrics.region_count++;
+            }
+        }
+        else if (dp->d_flags & RT_DIR_SOLID) {
+            metrics.primitive_count++;
+            const int type = dp->d_minor_type;
+            const char* label = (type > 0 && type < ID_MAXIMUM) ? OBJ[type].ft_label : nullptr;
+            metrics.primitive_types[label ? label : "unknown"]++;
+        }
+    } FOR_ALL_DIRECTORY_END;
+
+    // Longest path from a top-level object down to a leaf; the hierarchy
+    // walk already cut reference cycles
+    std::unordered_map<struct directory*, int> depths;
+    std::function<int(struct directory*)> depthOf = [&](struct directory* node) {
+        auto known = depths.find(node);
+        if (known != depths.end()) {
+            return known->second;
         }
-        else {
-            qDebug() << "[ProcessGFiles::extractObjects] Object" << QString::fromStdString(object_name) << "is a primitive. No child objects to insert.";
+        int depth = 1;
+        auto entry = hierarchy.find(node);
+        if (entry != hierarchy.end()) {
+            for (struct directory* child : entry->second.children) {
+                depth = std::max(depth, 1 + depthOf(child));
+            }
         }
+        depths[node] = depth;
+        return depth;
+    };
+    struct directory** tops = nullptr;
+    size_t topCount = db_ls(dbip, DB_LS_TOPS, nullptr, &tops);
+    metrics.tree_depth = 0;
+    for (size_t i = 0; i < topCount; ++i) {
+        metrics.tree_depth = std::max(metrics.tree_depth, depthOf(tops[i]));
+    }
+    if (tops) {
+        bu_free(tops, "free directory list");
     }
 
-    // Free the directory list for top-level objects
-    bu_free(dir, "free directory list");
-    qDebug() << "[ProcessGFiles::extractObjects] Completed for model ID:" << modelData.id;
+    qDebug() << "[ProcessGFiles::extractMetrics] Model ID:" << result.modelData.id << "has"
+        << metrics.primitive_count << "primitives," << metrics.region_count << "regions,"
+        << metrics.comb_count << "combinations, tree depth" << metrics.tree_depth;
 }
 
-void ProcessGFiles::insertChildObjects(ModelData& modelData, struct ged* gedp, const ObjectData& parentObjData, const std::string& selected_object_name)
+/*
+ * Leaves hash their exported body (no name, no attributes); combinations
+ * hash their boolean tree with each leaf replaced by the child's hash and
+ * placement matrix. Two sub-assemblies built from identical geometry in
+ * the same arrangement therefore hash alike whatever they are called.
+ *
+ * The same read of a combination also yields its member list, so the
+ * hierarchy walk and the hashes cost one rt_db_get_internal per object.
+ */
+const ProcessGFiles::HierarchyNode& ProcessGFiles::hierarchyNode(struct db_i* dbip, struct directory* dp, int depth)
 {
-    qDebug() << "[ProcessGFiles::insertChildObjects] Started for parent object ID:" << parentObjData.object_id << "Name:" << QString::fromStdString(parentObjData.name);
+    // Far deeper than real assemblies; bounds the recursion below
+    static const int MAX_DEPTH = 512;
+    static const HierarchyNode emptyNode;
 
-    struct directory* parent_dir = db_lookup(gedp->dbip, parentObjData.name.c_str(), LOOKUP_QUIET);
-    if (!parent_dir) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Parent object" << QString::fromStdString(parentObjData.name) << "not found in database.";
-        return;
+    auto cached = hierarchy.find(dp);
+    if (cached != hierarchy.end()) {
+        return cached->second;
     }
 
-    if (!(parent_dir->d_flags & RT_DIR_COMB)) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Parent object" << QString::fromStdString(parentObjData.name) << "is not a combination. No children to insert.";
-        return;
+    // A reference cycle cannot be hashed or listed; the back edge is cut
+    if (depth > MAX_DEPTH || !nodesInProgress.insert(dp).second) {
+        return emptyNode;
     }
 
+    HierarchyNode node;
+    ContentHasher hasher;
     struct rt_db_internal intern;
-    struct rt_comb_internal* comb;
-    if (rt_db_get_internal(&intern, parent_dir, gedp->dbip, nullptr, &rt_uniresource) < 0) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Error retrieving internal representation for object" << QString::fromStdString(parentObjData.name);
-        return;
+    if (rt_db_get_internal(&intern, dp, dbip, nullptr, resp) < 0) {
+        qDebug() << "[ProcessGFiles::hierarchyNode] Error retrieving internal representation for object" << dp->d_namep;
+        nodesInProgress.erase(dp);
+        return hierarchy.emplace(dp, node).first->second;
+    }
+
+    int32_t type = intern.idb_minor_type;
+    hasher.update(&type, sizeof(type));
+
+    if (dp->d_flags & RT_DIR_COMB) {
+        struct rt_comb_internal* comb = static_cast<struct rt_comb_internal*>(intern.idb_ptr);
+        char region = comb->region_flag ? 1 : 0;
+        hasher.update(&region, sizeof(region));
+
+        std::function<void(const union tree*)> walkTree = [&](const union tree* tree) {
+            if (!tree) {
+                return;
+            }
+            int32_t op = tree->tr_op;
+            hasher.update(&op, sizeof(op));
+
+            switch (tree->tr_op) {
+            case OP_UNION:
+            case OP_INTERSECT:
+            case OP_SUBTRACT:
+            case OP_XOR:
+                walkTree(tree->tr_b.tb_left);
+                walkTree(tree->tr_b.tb_right);
+                break;
+            case OP_NOT:
+            case OP_GUARD:
+            case OP_XNOP:
+                walkTree(tree->tr_b.tb_left);
+                break;
+            case OP_DB_LEAF: {
+                uint64_t childHash = 0;
+                struct directory* child = db_lookup(dbip, tree->tr_l.tl_name, LOOKUP_QUIET);
+                if (child) {
+                    bool backEdge = nodesInProgress.count(child) != 0;
+                    childHash = hierarchyNode(dbip, child, depth + 1).hash;
+                    if (!backEdge) {
+                        node.children.push_back(child);
+                    }
+                }
+                else {
+                    qDebug() << "[ProcessGFiles::hierarchyNode] Member" << tree->tr_l.tl_name
+                        << "of" << dp->d_namep << "not found in database.";
+                }
+                hasher.update(&childHash, sizeof(childHash));
+                if (tree->tr_l.tl_mat) {
+                    hasher.update(tree->tr_l.tl_mat, sizeof(mat_t));
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        };
+        walkTree(comb->tree);
+    }
+    else {
+        struct bu_external ext;
+        BU_EXTERNAL_INIT(&ext);
+        if (intern.idb_meth && intern.idb_meth->ft_export5 &&
+            intern.idb_meth->ft_export5(&ext, &intern, 1.0, dbip, resp) == 0) {
+            hasher.update(ext.ext_buf, ext.ext_nbytes);
+        }
+        bu_free_external(&ext);
     }
 
-    comb = static_cast<struct rt_comb_internal*>(intern.idb_ptr);
+    rt_db_free_internal(&intern);
 
-    if (!comb->tree) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Combination" << QString::fromStdString(parentObjData.name) << "has no children.";
-        rt_db_free_internal(&intern);
-        return;
-    }
+    node.hash = hasher.digest();
+    nodesInProgress.erase(dp);
+    return hierarchy.emplace(dp, std::move(node)).first->second;
+}
 
-    // Retrieve child objects
-    std::vector<std::string> children;
-    db_tree_list_comb_children(comb->tree, children);
+bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& selected_object_name,
+                                     const ThumbnailOptions& options, int timeLimitMs, int64_t& renderMs,
+                                     GeometryMetrics* metrics)
+{
+    qDebug() << "[ProcessGFiles::generateThumbnail] Started for model ID:" << modelData.id
+        << "with selected object:" << QString::fromStdString(selected_object_name)
+        << "and time limit:" << timeLimitMs / 1000 << "seconds";
+    renderMs = 0;
 
-    qDebug() << "[ProcessGFiles::insertChildObjects] Number of children found for object" << QString::fromStdString(parentObjData.name) << ":" << children.size();
+    if (selected_object_name.empty()) {
+        qDebug() << "[ProcessGFiles::generateThumbnail] No valid object selected for raytrace in file:"
+            << QString::fromStdString(truncatePath(modelData.file_path));
+        return false;
+    }
 
-    // Insert each child object into the database
-    for (const auto& child_name : children) {
-        qDebug() << "[ProcessGFiles::insertChildObjects] Processing child object name:" << QString::fromStdString(child_name);
+    if (modelData.file_path.empty()) {
+        qDebug() << "[ProcessGFiles::generateThumbnail] No file path available in modelData for generating thumbnail.";
+        return false;
+    }
 
-        // Lookup the child's directory entry
-        struct directory* child_dir = db_lookup(gedp->dbip, child_name.c_str(), LOOKUP_QUIET);
-        if (!child_dir) {
-            qDebug() << "[ProcessGFiles::insertChildObjects] Child object" << QString::fromStdString(child_name) << "not found in database.";
-            continue;
+    // In-process render; each render worker gets an equal share of the cores
+    QSettings settings;
+    int renderWorkers = std::max(1, settings.value("renderThreads", std::max(1, QThread::idealThreadCount() / 2)).toInt());
+    ThumbnailRenderer renderer(std::max(1, QThread::idealThreadCount() / renderWorkers));
+
+    // Same file content, object and view were rendered before (possibly in
+    // another library or before a catalog reset)
+    ThumbnailCache cache;
+    std::string cacheKey = ThumbnailCache::key(modelData.content_hash, selected_object_name, options);
+    if (cache.lookup(cacheKey, modelData.thumbnail)) {
+        qDebug() << "[ProcessGFiles::generateThumbnail] Thumbnail cache hit for model with ID:" << modelData.id;
+        // Nothing was traced, so sampling needs a prep of its own
+        if (metrics) {
+            renderer.measureFile(modelData.file_path, selected_object_name, *metrics, MEASURE_TIME_LIMIT_MS);
         }
+        return true;
+    }
 
-        // Create ObjectData for the child
-        ObjectData childObjData;
-        childObjData.model_id = modelData.id;
-        childObjData.name = child_name;
-        childObjData.parent_object_id = parentObjData.object_id; // The parent's object ID
-        childObjData.is_selected = (child_name == selected_object_name);
-
-        qDebug() << "[ProcessGFiles::insertChildObjects] Inserting child object -"
-            << "Model ID:" << childObjData.model_id
-            << ", Name:" << QString::fromStdString(childObjData.name)
-            << ", Parent Object ID:" << childObjData.parent_object_id
-            << ", is_selected:" << childObjData.is_selected;
-
-        int childInsertedObjectId = model->insertObject(childObjData);
-        if (childInsertedObjectId == -1) {
-            qDebug() << "[ProcessGFiles::insertChildObjects] Failed to insert child object:"
-                << QString::fromStdString(childObjData.name)
-                << "for parent object ID:" << parentObjData.object_id << "model ID:" << childObjData.model_id;
-        }
-        else {
-            childObjData.object_id = childInsertedObjectId;
-            qDebug() << "[ProcessGFiles::insertChildObjects] Successfully inserted child object:"
-                << QString::fromStdString(childObjData.name)
-                << "with ID:" << childInsertedObjectId << "for parent object ID:" << parentObjData.object_id << "model ID:" << childObjData.model_id;
-        }
+    std::vector<char> png;
+    QElapsedTimer timer;
+    timer.start();
+    bool rendered = renderer.renderFile(modelData.file_path, selected_object_name, options, png, timeLimitMs,
+                                        metrics, MEASURE_TIME_LIMIT_MS);
+    renderMs = timer.elapsed() - renderer.measureMs();
+    if (rendered) {
+        modelData.thumbnail = std::move(png);
+        cache.store(cacheKey, modelData.thumbnail);
+        qDebug() << "[ProcessGFiles::generateThumbnail] Thumbnail rendered in-process for model with ID:" << modelData.id;
+        return true;
     }
 
-    rt_db_free_internal(&intern);
+    // A render that ran out of time would only time out again in rt
+    int remainingMs = timeLimitMs > 0 ? timeLimitMs - static_cast<int>(renderMs) : -1;
+    if (timeLimitMs > 0 && remainingMs <= 0) {
+        qDebug() << "[ProcessGFiles::generateThumbnail] Command timed out after" << timeLimitMs / 1000 << "seconds.";
+        return false;
+    }
 
-    qDebug() << "[ProcessGFiles::insertChildObjects] Completed for parent object ID:" << parentObjData.object_id << "Name:" << QString::fromStdString(parentObjData.name);
+    qDebug() << "[ProcessGFiles::generateThumbnail] In-process render failed, falling back to rt for model ID:" << modelData.id;
+    bool fallback = generateThumbnailWithRt(modelData, selected_object_name, options, remainingMs);
+    renderMs = timer.elapsed() - renderer.measureMs();
+    if (!fallback) {
+        return false;
+    }
+    cache.store(cacheKey, modelData.thumbnail);
+    return true;
 }
 
+bool ProcessGFiles::generateViews(const ModelData& modelData, const std::string& selected_object_name,
+                                 const std::vector<ThumbnailOptions>& views, int timeLimitMs, int64_t& renderMs,
+                                 std::vector<std::vector<char>>& pngs, GeometryMetrics* metrics)
+{
+    renderMs = 0;
+    pngs.assign(views.size(), std::vector<char>());
+    if (selected_object_name.empty() || modelData.file_path.empty() || views.empty()) {
+        return false;
+    }
 
-void db_tree_list_comb_children(const union tree* tree, std::vector<std::string>& children) {
-    if (!tree) return;
-
-    switch (tree->tr_op) {
-    case OP_UNION:
-    case OP_INTERSECT:
-    case OP_SUBTRACT:
-    case OP_XOR:
-        db_tree_list_comb_children(tree->tr_b.tb_left, children);
-        db_tree_list_comb_children(tree->tr_b.tb_right, children);
-        break;
-    case OP_DB_LEAF:
-        if (tree->tr_l.tl_name) {
-            children.push_back(tree->tr_l.tl_name);
+    // Only views the cache does not have are traced
+    ThumbnailCache cache;
+    std::vector<ThumbnailOptions> missing;
+    std::vector<size_t> missingIndex;
+    for (size_t i = 0; i < views.size(); ++i) {
+        std::string cacheKey = ThumbnailCache::key(modelData.content_hash, selected_object_name, views[i]);
+        if (!cache.lookup(cacheKey, pngs[i])) {
+            missing.push_back(views[i]);
+            missingIndex.push_back(i);
         }
-        break;
-    default:
-        break;
     }
-}
-
-
-
-
-
-bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& selected_object_name)
-{
-    qDebug() << "[ProcessGFiles::generateThumbnail] Started for model ID:" << modelData.id
-        << "with selected object:" << QString::fromStdString(selected_object_name);
 
     QSettings settings;
-    int timeLimitMs = settings.value("previewTimer", 30).toInt() * 1000;
-
-    if (selected_object_name.empty()) {
-        qDebug() << "[ProcessGFiles::generateThumbnail] No valid object selected for raytrace in file:"
-            << QString::fromStdString(truncatePath(modelData.file_path));
+    int renderWorkers = std::max(1, settings.value("renderThreads", std::max(1, QThread::idealThreadCount() / 2)).toInt());
+    ThumbnailRenderer renderer(std::max(1, QThread::idealThreadCount() / renderWorkers));
+    if (missing.empty()) {
+        qDebug() << "[ProcessGFiles::generateViews] Thumbnail cache hit for all views of model with ID:" << modelData.id;
+        if (metrics) {
+            renderer.measureFile(modelData.file_path, selected_object_name, *metrics, MEASURE_TIME_LIMIT_MS);
+        }
+        return true;
+    }
+
+    std::vector<std::vector<char>> rendered;
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = renderer.renderFileViews(modelData.file_path, selected_object_name, missing, rendered, timeLimitMs,
+                                       metrics, MEASURE_TIME_LIMIT_MS);
+    renderMs = timer.elapsed() - renderer.measureMs();
+    if (!ok) {
+        qDebug() << "[ProcessGFiles::generateViews] Rendering" << missing.size() << "views failed for model ID:"
+            << modelData.id;
+        pngs.clear();
         return false;
     }
 
-    if (modelData.file_path.empty()) {
-        qDebug() << "[ProcessGFiles::generateThumbnail] No file path available in modelData for generating thumbnail.";
-        return false;
+    for (size_t i = 0; i < missing.size(); ++i) {
+        pngs[missingIndex[i]] = std::move(rendered[i]);
+        cache.store(ThumbnailCache::key(modelData.content_hash, selected_object_name, missing[i]),
+                    pngs[missingIndex[i]]);
     }
+    qDebug() << "[ProcessGFiles::generateViews] Rendered" << missing.size() << "of" << views.size()
+        << "views in-process for model with ID:" << modelData.id;
+    return true;
+}
 
-    QString previewsFolder = QString::fromStdString(model->getHiddenDirectoryPath() + "/previews");
+bool ProcessGFiles::generateThumbnailWithRt(ModelData& modelData, const std::string& selected_object_name,
+                                           const ThumbnailOptions& options, int timeLimitMs)
+{
+    // Helper processes have no catalog; their rt output goes to the temp directory
+    QString previewsFolder = model ? QString::fromStdString(model->getHiddenDirectoryPath() + "/previews")
+                                   : QDir::tempPath() + "/cadventory-previews";
     QString modelShortName = QString::fromStdString(std::filesystem::path(modelData.file_path).stem().string());
-    QString pngFilePath = previewsFolder + "/" + modelShortName + ".png";
+    // Model id keeps concurrent renders of same-named files apart
+    QString pngFilePath = previewsFolder + "/" + modelShortName + "_" + QString::number(modelData.id)
+        + "_" + QString::number(options.size) + ".png";
     QDir().mkpath(QFileInfo(pngFilePath).absolutePath());
 
     // Use the RT_EXECUTABLE_PATH from configuration
@@ -363,8 +757,13 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
 
     // Build the arguments list for rt.exe
     QStringList arguments;
-    arguments << "-s512"
-        << "-o" << pngFilePath
+    arguments << "-s" + QString::number(options.size)
+        << "-a" + QString::number(options.azimuth)
+        << "-e" + QString::number(options.elevation);
+    if (options.hypersample > 0) {
+        arguments << "-H" + QString::number(options.hypersample);
+    }
+    arguments << "-o" << pngFilePath
         << QString::fromStdString(modelData.file_path)
         << QString::fromStdString(selected_object_name);
 
@@ -373,22 +772,17 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
     QProcess process;
     process.setProcessChannelMode(QProcess::MergedChannels);
 
-#ifdef Q_OS_WIN
-    // On Windows, execute the executable directly.
+    // Run rt directly; paths with spaces or shell characters stay intact
     process.setProgram(rtExecutable);
     process.setArguments(arguments);
-#else
-    // On Unix-like systems, if needed, you can execute via the shell.
-    QString rtCommand = rtExecutable + " " + arguments.join(" ");
-    process.setProgram("/bin/sh");
-    process.setArguments({ "-c", rtCommand });
-#endif
+    BackgroundMode::prepareChild(process);
 
     process.start();
     if (!process.waitForStarted()) {
         qDebug() << "[ProcessGFiles::generateThumbnail] Failed to start the process for command:" << rtExecutable << arguments;
         return false;
     }
+    TrackedChild tracked(process.processId());
 
     bool finishedInTime = process.waitForFinished(timeLimitMs);
     if (!finishedInTime) {
@@ -436,20 +830,6 @@ bool ProcessGFiles::generateThumbnail(ModelData& modelData, const std::string& s
     return true;
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
 std::tuple<bool, std::string, std::string> ProcessGFiles::generateGistReport(const std::string& inputFilePath, const std::string& outputFilePath, const std::string& primary_obj, const std::string& label)
 {
     std::string gistCommand;
@@ -485,6 +865,7 @@ std::tuple<bool, std::string, std::string> ProcessGFiles::generateGistReport(con
     process.setProgram(gistExecutable);
     process.setArguments(arguments);
     process.setProcessChannelMode(QProcess::MergedChannels);
+    BackgroundMode::prepareChild(process);
 
     process.start();
     if (!process.waitForStarted()) {
@@ -492,6 +873,7 @@ std::tuple<bool, std::string, std::string> ProcessGFiles::generateGistReport(con
         qDebug() << "[ProcessGFiles::generateGistReport]" << QString::fromStdString(errorMessage);
         return { false, errorMessage, gistCommand };
     }
+    TrackedChild tracked(process.processId());
 
     bool finishedInTime = process.waitForFinished(timeLimitMs);
 
@@ -2,31 +2,133 @@
 #define PROCESSGFILES_H
 
 #include <filesystem>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "GeometryMetrics.h"
 #include "Model.h"
+#include "StageTime.h"
+#include "ThumbnailRenderer.h"
 #include <brlcad/rt/geom.h>
 
+/**
+ * @brief Everything read from a .g file, not yet written to the catalog
+ *
+ * parent_object_id of each object is an index into objects (-1 for
+ * top-level objects) until Model::storeExtraction assigns row ids.
+ */
+struct ExtractionResult {
+    ModelData modelData;
+    bool ok = false;
+    int error = StageOk;            // StageError when not ok
+    int duplicateOf = 0;            // processed exact copy to take data from
+    bool resumed = false;           // objects already stored by an earlier run
+    std::vector<ObjectData> objects;
+    std::string thumbnailObject;    // empty when there is nothing to render
+    double renderCost = 0.0;        // RenderCostModel estimate in seconds, 0 if unknown
+    GeometryMetrics metrics;        // counts only; unset for duplicates and resumed models
+    StageTime openTime;             // ged_open; zero if the file was not opened
+    StageTime extractTime;          // title, objects and counts, read after the open
+    int64_t peakRss = 0;            // bytes the job peaked at, 0 if not measured
+};
+
+struct RenderResult {
+    int modelId = 0;
+    bool ok = false;
+    int error = StageOk;            // StageError when not ok
+    bool coarse = false;            // quick low-resolution pass
+    int64_t renderMs = 0;           // time spent rendering; 0 on a cache hit
+    std::vector<char> thumbnail;
+    std::vector<ThumbnailImage> sizes;  // mipmaps encoded from thumbnail
+    ThumbnailImage viewAtlas;       // "multiViewPreviews" set, full renders only
+    GeometryMetrics metrics;        // sampled fields only, full renders only
+    StageTime renderTime;           // wall time only; tracing is multithreaded
+    int64_t peakRss = 0;            // bytes the job peaked at, 0 if not measured
+};
+
 class ProcessGFiles {
 public:
     explicit ProcessGFiles(Model* model);
+
+    /*
+     * Parallel indexing runs one instance per thread; librt memory
+     * resources are not thread safe, so each worker gets its own.
+     * workerIndex must be unique among concurrently running instances.
+     * model may be null in a helper process: extract and render work
+     * without a catalog, only the persist methods need one.
+     */
+    ProcessGFiles(Model* model, int workerIndex);
+    ~ProcessGFiles();
+    ProcessGFiles(const ProcessGFiles&) = delete;
+    ProcessGFiles& operator=(const ProcessGFiles&) = delete;
+
     void processGFile(const ModelData& modelData);
+
+    /*
+     * The stages processGFile runs in order. extract and render only read
+     * the .g file, so the indexer runs them on worker threads and funnels
+     * the results to one thread that calls the persist methods.
+     */
+    ExtractionResult extract(const ModelData& modelData);
+    // Fills result from an already processed exact copy, if there is one
+    bool reuseDuplicate(const ModelData& modelData, ExtractionResult& result);
+    // Picks up a model whose objects an interrupted run already stored
+    bool resumeExtraction(const ModelData& modelData, ExtractionResult& result);
+    bool persistExtraction(const ExtractionResult& extraction);
+    RenderResult render(const ExtractionResult& extraction, bool coarse = false);
+    bool persistRender(const RenderResult& render);
+
     std::tuple<bool, std::string, std::string> generateGistReport(const std::string& inputFilePath, const std::string& outputFilePath, const std::string& primary_obj, const std::string& label);
 
 private:
     void extractTitle(ModelData& modelData, struct ged* gedp);
-    void extractObjects(ModelData& modelData, struct ged* gedp);
-    void insertChildObjects(ModelData& modelData, struct ged* gedp, const ObjectData& parentObjData, const std::string& selected_object_name);
+    void extractObjects(ExtractionResult& result, struct ged* gedp);
+
+    /*
+     * Counts and tree depth from the directory and the hierarchy, run on
+     * the open database after extractObjects. Extent, volume and surface
+     * area need a prepped raytrace, so full renders sample them on their
+     * own session within MEASURE_TIME_LIMIT_MS (a cache hit preps just for
+     * that). The "measureGeometry" setting turns sampling off.
+     */
+    static const int MEASURE_TIME_LIMIT_MS = 30000;
+    void extractMetrics(ExtractionResult& result, struct ged* gedp);
 
-    // Thumbnail generation and command utility methods
-    bool generateThumbnail(ModelData& modelData, const std::string& selected_object_name);
+    /*
+     * One object of the database as the hierarchy walk sees it. Every
+     * object is read once per file; a subtree shared by several
+     * assemblies is reused from here rather than read again.
+     */
+    struct HierarchyNode {
+        uint64_t hash = 0;                      // name-independent Merkle hash
+        std::vector<struct directory*> children; // comb members in tree order
+    };
+
+    // Reads dp once and memoizes its hash and children
+    const HierarchyNode& hierarchyNode(struct db_i* dbip, struct directory* dp, int depth = 0);
+
+    // Thumbnail generation and command utility methods; timeLimitMs 0 means
+    // no limit. Given metrics, they are sampled too; renderMs leaves that out.
+    bool generateThumbnail(ModelData& modelData, const std::string& selected_object_name,
+                           const ThumbnailOptions& options, int timeLimitMs, int64_t& renderMs,
+                           GeometryMetrics* metrics = nullptr);
+    // Every view from one prep, each looked up in and added to the cache
+    // on its own; no rt fallback
+    bool generateViews(const ModelData& modelData, const std::string& selected_object_name,
+                       const std::vector<ThumbnailOptions>& views, int timeLimitMs, int64_t& renderMs,
+                       std::vector<std::vector<char>>& pngs, GeometryMetrics* metrics = nullptr);
+    // Fallback: spawn rt and read back its PNG
+    bool generateThumbnailWithRt(ModelData& modelData, const std::string& selected_object_name,
+                                 const ThumbnailOptions& options, int timeLimitMs);
 
 
     Model* model;
+    struct resource workerResource;
+    struct resource* resp;
+    std::unordered_map<struct directory*, HierarchyNode> hierarchy;
+    std::unordered_set<struct directory*> nodesInProgress;
 };
 
-void db_tree_list_comb_children(const union tree *tree, std::vector<std::string>& children);
-
 #endif  // PROCESSGFILES_H
@@ -0,0 +1,167 @@
+#include "ProcessingQueue.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Below the gap between NewlyIncluded and Visible
+const double MAX_COST_POINTS = 99.0;
+
+double costPoints(double costSeconds)
+{
+    return std::min(MAX_COST_POINTS,
+                    ProcessingQueue::COST_POINTS_PER_DOUBLING * std::log2(1.0 + std::max(0.0, costSeconds)));
+}
+
+}
+
+ProcessingQueue::ProcessingQueue(double agingRate)
+    : created(std::chrono::steady_clock::now()), agingRate(std::max(0.0, agingRate))
+{
+}
+
+double ProcessingQueue::elapsedSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+}
+
+int ProcessingQueue::effectivePriority(const Entry& entry) const
+{
+    int priority = entry.priority;
+    if (visible.count(entry.modelData.id)) {
+        priority = std::max(priority, static_cast<int>(Visible));
+    }
+    return priority;
+}
+
+void ProcessingQueue::reorder(Entry& entry)
+{
+    order.erase(entry.key);
+    entry.key.score = effectivePriority(entry) - agingRate * entry.enqueuedAt - entry.costPoints;
+    entry.key.sequence = entry.sequence;
+    entry.key.modelId = entry.modelData.id;
+    order.insert(entry.key);
+}
+
+bool ProcessingQueue::enqueue(const ModelData& modelData, int priority, double costSeconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const double points = costPoints(costSeconds);
+
+    auto existing = entries.find(modelData.id);
+    if (existing != entries.end()) {
+        Entry& entry = existing->second;
+        entry.modelData = modelData;
+        if (priority > entry.priority || points != entry.costPoints) {
+            entry.priority = std::max(entry.priority, priority);
+            entry.costPoints = points;
+            reorder(entry);
+        }
+        return false;
+    }
+
+    Entry entry;
+    entry.modelData = modelData;
+    entry.priority = priority;
+    entry.costPoints = points;
+    auto pending = pendingBoosts.find(modelData.id);
+    if (pending != pendingBoosts.end()) {
+        entry.priority = std::max(entry.priority, pending->second);
+        pendingBoosts.erase(pending);
+    }
+    entry.enqueuedAt = elapsedSeconds();
+    entry.sequence = nextSequence++;
+    // Not in the order set yet; reorder's erase is a no-op
+    entry.key = Key{ 0.0, entry.sequence, modelData.id };
+
+    Entry& stored = entries.emplace(modelData.id, std::move(entry)).first->second;
+    reorder(stored);
+    return true;
+}
+
+bool ProcessingQueue::pop(ModelData& modelData)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (order.empty()) {
+        return false;
+    }
+
+    auto first = order.begin();
+    auto entry = entries.find(first->modelId);
+    order.erase(first);
+    modelData = std::move(entry->second.modelData);
+    entries.erase(entry);
+    return true;
+}
+
+std::vector<ModelData> ProcessingQueue::peek(size_t count) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ModelData> upcoming;
+    for (auto key = order.begin(); key != order.end() && upcoming.size() < count; ++key) {
+        upcoming.push_back(entries.at(key->modelId).modelData);
+    }
+    return upcoming;
+}
+
+void ProcessingQueue::boost(int modelId, int priority)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto entry = entries.find(modelId);
+    if (entry == entries.end()) {
+        int& pending = pendingBoosts[modelId];
+        pending = std::max(pending, priority);
+        return;
+    }
+    if (priority > entry->second.priority) {
+        entry->second.priority = priority;
+        reorder(entry->second);
+    }
+}
+
+void ProcessingQueue::setVisible(const std::vector<int>& modelIds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_set<int> changed = visible;
+    visible = std::unordered_set<int>(modelIds.begin(), modelIds.end());
+    changed.insert(modelIds.begin(), modelIds.end());
+
+    for (int modelId : changed) {
+        auto entry = entries.find(modelId);
+        if (entry != entries.end()) {
+            reorder(entry->second);
+        }
+    }
+}
+
+void ProcessingQueue::setAgingRate(double pointsPerSecond)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    agingRate = std::max(0.0, pointsPerSecond);
+    for (auto& [modelId, entry] : entries) {
+        reorder(entry);
+    }
+}
+
+bool ProcessingQueue::contains(int modelId) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.count(modelId) != 0;
+}
+
+size_t ProcessingQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void ProcessingQueue::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    order.clear();
+    pendingBoosts.clear();
+}
@@ -0,0 +1,109 @@
+#ifndef PROCESSINGQUEUE_H
+#define PROCESSINGQUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Model.h"
+
+/**
+ * @brief Models waiting to be indexed, ordered by what the user cares about
+ *
+ * Each waiting model has a priority: background work, a newly included
+ * file, a card in the visible part of the library, or an explicit request
+ * to process it next. Waiting also counts: every second in the queue adds
+ * agingRate points, so background models still make it through while
+ * the user keeps boosting others.
+ *
+ * Among models of equal standing the cheapest goes first: every doubling
+ * of the expected processing time (see RenderCostModel) costs
+ * COST_POINTS_PER_DOUBLING points, never as much as a step between
+ * priorities. Shortest jobs fill the library quickly while aging keeps
+ * the long ones from starving.
+ *
+ * The ordering key is priority - agingRate * enqueue time - cost, which
+ * does not change while a model waits, so every operation is O(log n).
+ * Boosts for models not queued yet are kept and applied when they arrive.
+ *
+ * Usage example:
+ *
+ * queue.enqueue(modelData, ProcessingQueue::Background, costs.estimate(modelData));
+ * queue.prioritize(openedModelId);   // from the UI thread
+ * while (queue.pop(next)) { ... }    // from the indexing workers
+ */
+class ProcessingQueue {
+public:
+    enum Priority {
+        Background = 0,
+        NewlyIncluded = 100,
+        Visible = 200,
+        Next = 1000000      // ahead of anything aging can reach
+    };
+
+    static constexpr double COST_POINTS_PER_DOUBLING = 8.0;
+
+    explicit ProcessingQueue(double agingRate = 1.0);
+    ProcessingQueue(const ProcessingQueue&) = delete;
+    ProcessingQueue& operator=(const ProcessingQueue&) = delete;
+
+    // Adds a model, or refreshes the data of one already waiting; true if
+    // added. costSeconds is the expected processing time.
+    bool enqueue(const ModelData& modelData, int priority = Background, double costSeconds = 0.0);
+    bool pop(ModelData& modelData);
+    // The next count models pop() would return, still queued
+    std::vector<ModelData> peek(size_t count) const;
+
+    // Raises a model's priority, never lowers it
+    void boost(int modelId, int priority);
+    // "Process this one next"
+    void prioritize(int modelId) { boost(modelId, Next); }
+    // Replaces the set of models shown on screen
+    void setVisible(const std::vector<int>& modelIds);
+
+    // Priority points gained per second of waiting
+    void setAgingRate(double pointsPerSecond);
+
+    bool contains(int modelId) const;
+    size_t size() const;
+    void clear();
+
+private:
+    struct Key {
+        double score;
+        uint64_t sequence;
+        int modelId;
+        bool operator<(const Key& other) const {
+            if (score != other.score) return score > other.score;
+            return sequence < other.sequence;
+        }
+    };
+
+    struct Entry {
+        ModelData modelData;
+        int priority = Background;
+        double enqueuedAt = 0.0;    // seconds since the queue was created
+        double costPoints = 0.0;
+        uint64_t sequence = 0;
+        Key key;
+    };
+
+    int effectivePriority(const Entry& entry) const;
+    void reorder(Entry& entry);
+    double elapsedSeconds() const;
+
+    mutable std::mutex mutex;
+    const std::chrono::steady_clock::time_point created;
+    double agingRate;
+    uint64_t nextSequence = 0;
+    std::unordered_map<int, Entry> entries;
+    std::set<Key> order;
+    std::unordered_map<int, int> pendingBoosts;
+    std::unordered_set<int> visible;
+};
+
+#endif // PROCESSINGQUEUE_H
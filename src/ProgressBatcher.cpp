@@ -0,0 +1,71 @@
+#include "ProgressBatcher.h"
+
+#include <algorithm>
+
+ProgressBatcher::ProgressBatcher(std::chrono::milliseconds interval, size_t maxItems)
+    : interval(interval), maxItems(std::max<size_t>(1, maxItems))
+{
+}
+
+bool ProgressBatcher::progress(const std::string& status, int percentage)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    waiting.hasProgress = true;
+    waiting.status = status;
+    waiting.percentage = percentage;
+    return dueLocked(std::chrono::steady_clock::now());
+}
+
+bool ProgressBatcher::processed(int modelId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::find(waiting.modelIds.begin(), waiting.modelIds.end(), modelId) == waiting.modelIds.end()) {
+        waiting.modelIds.push_back(modelId);
+    }
+    return dueLocked(std::chrono::steady_clock::now());
+}
+
+bool ProgressBatcher::takeDue(Batch& batch)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = std::chrono::steady_clock::now();
+    if (!dueLocked(now)) {
+        return false;
+    }
+    takeLocked(batch, now);
+    return true;
+}
+
+bool ProgressBatcher::take(Batch& batch)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (waiting.modelIds.empty() && !waiting.hasProgress) {
+        return false;
+    }
+    takeLocked(batch, std::chrono::steady_clock::now());
+    return true;
+}
+
+size_t ProgressBatcher::batches() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return taken;
+}
+
+bool ProgressBatcher::dueLocked(std::chrono::steady_clock::time_point now) const
+{
+    if (waiting.modelIds.empty() && !waiting.hasProgress) {
+        return false;
+    }
+    // The first news after a quiet spell goes out at once
+    return !takenOnce || waiting.modelIds.size() >= maxItems || now - lastTaken >= interval;
+}
+
+void ProgressBatcher::takeLocked(Batch& batch, std::chrono::steady_clock::time_point now)
+{
+    batch = std::move(waiting);
+    waiting = Batch();
+    lastTaken = now;
+    takenOnce = true;
+    taken++;
+}
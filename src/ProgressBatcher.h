@@ -0,0 +1,72 @@
+#ifndef PROGRESSBATCHER_H
+#define PROGRESSBATCHER_H
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Collects per-file indexing progress into batches for the UI
+ *
+ * Every queued signal costs the UI thread a redraw, and a fast indexer
+ * finishing hundreds of small files a second would wait on it. Pipeline
+ * threads record what they finish and how far the batch is; whoever
+ * records calls takeDue() and sends what it gets as one update. A batch
+ * is due once INTERVAL passed since the last one, or sooner when
+ * MAX_ITEMS models are waiting. Thread-safe.
+ *
+ * Usage example:
+ *
+ * ProgressBatcher batcher;
+ * batcher.processed(modelId);
+ * batcher.progress("truck.g", 40);
+ * ProgressBatcher::Batch batch;
+ * if (batcher.takeDue(batch)) { ... one signal for batch.modelIds ... }
+ * ...
+ * if (batcher.take(batch)) { ... the rest at the end ... }
+ */
+class ProgressBatcher {
+public:
+    static constexpr std::chrono::milliseconds INTERVAL{ 100 };
+    static constexpr size_t MAX_ITEMS = 64;
+
+    struct Batch {
+        std::vector<int> modelIds;      // finished since the last batch, each once
+        bool hasProgress = false;       // status and percentage are set
+        std::string status;             // the latest reported
+        int percentage = 0;
+    };
+
+    explicit ProgressBatcher(std::chrono::milliseconds interval = INTERVAL, size_t maxItems = MAX_ITEMS);
+    ProgressBatcher(const ProgressBatcher&) = delete;
+    ProgressBatcher& operator=(const ProgressBatcher&) = delete;
+
+    // Both return whether a batch is due now
+    bool progress(const std::string& status, int percentage);
+    bool processed(int modelId);
+
+    // The waiting batch if it is due; false leaves batch alone
+    bool takeDue(Batch& batch);
+    // The waiting batch, due or not; false if there is nothing
+    bool take(Batch& batch);
+
+    // Batches taken so far
+    size_t batches() const;
+
+private:
+    bool dueLocked(std::chrono::steady_clock::time_point now) const;
+    void takeLocked(Batch& batch, std::chrono::steady_clock::time_point now);
+
+    const std::chrono::milliseconds interval;
+    const size_t maxItems;
+
+    mutable std::mutex mutex;
+    Batch waiting;
+    std::chrono::steady_clock::time_point lastTaken;
+    bool takenOnce = false;
+    size_t taken = 0;
+};
+
+#endif // PROGRESSBATCHER_H
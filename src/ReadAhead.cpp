@@ -0,0 +1,134 @@
+#include "ReadAhead.h"
+#include "BackgroundMode.h"
+
+#include <QDebug>
+#include <QSettings>
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ReadAhead::ReadAhead(int depth, int64_t budgetBytes)
+    : maxFiles(depth), budget(budgetBytes), background(BackgroundMode::enabled())
+{
+    QSettings settings;
+    if (maxFiles < 0) {
+        maxFiles = settings.value("readAheadFiles", 4).toInt();
+    }
+    if (budget < 0) {
+        budget = settings.value("readAheadMB", 256).toLongLong() * 1024 * 1024;
+    }
+    maxFiles = std::max(0, maxFiles);
+
+    // Hints are issued in order, one at a time
+    pool.setMaxThreadCount(1);
+}
+
+ReadAhead::~ReadAhead()
+{
+    stopping.store(true);
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ReadAhead::prefetch(const std::vector<ModelData>& upcoming)
+{
+    if (maxFiles == 0 || budget <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_set<std::string> window;
+    for (size_t i = 0; i < upcoming.size() && i < static_cast<size_t>(maxFiles); ++i) {
+        window.insert(upcoming[i].file_path);
+    }
+    for (auto entry = pending.begin(); entry != pending.end();) {
+        if (window.count(entry->first) == 0) {
+            pendingTotal -= entry->second;
+            entry = pending.erase(entry);
+        }
+        else {
+            ++entry;
+        }
+    }
+
+    for (size_t i = 0; i < upcoming.size() && i < static_cast<size_t>(maxFiles); ++i) {
+        const ModelData& modelData = upcoming[i];
+        // Unknown size: the fingerprint could not read the file either
+        if (modelData.file_path.empty() || modelData.file_size <= 0 || pending.count(modelData.file_path)) {
+            continue;
+        }
+        // Files in queue order; a later one must not overtake what does not fit
+        const int64_t bytes = std::min<int64_t>(modelData.file_size, budget - pendingTotal);
+        if (bytes <= 0) {
+            break;
+        }
+        pending[modelData.file_path] = bytes;
+        pendingTotal += bytes;
+
+        std::string filePath = modelData.file_path;
+        pool.start([this, filePath, bytes]() {
+            if (background) {
+                BackgroundMode::lowerCurrentThread();
+            }
+            if (!stopping.load() && advise(filePath, bytes, &stopping)) {
+                filesHinted.fetch_add(1);
+                bytesHinted.fetch_add(bytes);
+            }
+        });
+    }
+}
+
+int64_t ReadAhead::pendingBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pendingTotal;
+}
+
+void ReadAhead::wait()
+{
+    pool.waitForDone();
+}
+
+bool ReadAhead::advise(const std::string& filePath, int64_t length, const std::atomic<bool>* cancel)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // Returns at once; the kernel reads in the background
+    int error = ::posix_fadvise(fd, 0, static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+    ::close(fd);
+    if (error != 0) {
+        qDebug() << "[ReadAhead::advise] posix_fadvise failed for" << QString::fromStdString(filePath)
+            << "error" << error;
+        return false;
+    }
+    Q_UNUSED(cancel);
+    return true;
+#else
+    // No read-ahead hint here: reading the file through fills the cache
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const int64_t READ_CHUNK = 1 << 20;
+    std::vector<char> chunk(static_cast<size_t>(READ_CHUNK));
+    int64_t left = length;
+    while (left > 0 && !(cancel && cancel->load())) {
+        file.read(chunk.data(), std::min<int64_t>(left, READ_CHUNK));
+        if (file.gcount() <= 0) {
+            break;
+        }
+        left -= file.gcount();
+    }
+    return true;
+#endif
+}
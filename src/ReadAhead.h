@@ -0,0 +1,81 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <QThreadPool>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Model.h"
+
+/**
+ * @brief Starts reading the .g files the indexer opens next
+ *
+ * On network shares ged_open spends most of its time waiting for cold
+ * reads while the CPU sits idle. After every pop from the
+ * ProcessingQueue the indexer hands the next few queued models to
+ * prefetch(), which asks the OS to pull their files into the page cache
+ * (posix_fadvise WILLNEED, or reading them through where that is not
+ * available). By the time a worker opens a file it is mostly in memory,
+ * so opening one file overlaps with reading the next.
+ *
+ * Hints go out on a background thread of their own, since opening a file
+ * on a slow share can block. At most depth files and budgetBytes bytes
+ * are hinted at any time; a file that drops out of the upcoming window
+ * (opened, or overtaken by boosted models) frees its share of the budget.
+ *
+ * Usage example:
+ *
+ * ReadAhead readAhead;
+ * while (queue.pop(modelData)) {
+ *     readAhead.prefetch(queue.peek(readAhead.depth()));
+ *     processor.extract(modelData);
+ * }
+ */
+class ReadAhead {
+public:
+    // Negative values read the "readAheadFiles" and "readAheadMB" settings;
+    // a depth of 0 turns read-ahead off
+    explicit ReadAhead(int depth = -1, int64_t budgetBytes = -1);
+    ~ReadAhead();
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    int depth() const { return maxFiles; }
+
+    // Hints the files of upcoming models not hinted yet, in order, while
+    // they fit the budget; forgets hinted files no longer upcoming
+    void prefetch(const std::vector<ModelData>& upcoming);
+
+    // Bytes hinted for the current window
+    int64_t pendingBytes() const;
+    // Totals since construction, for the batch report
+    int hintedFiles() const { return filesHinted.load(); }
+    int64_t hintedBytes() const { return bytesHinted.load(); }
+
+    // Waits until every hint issued so far went out
+    void wait();
+
+    // Asks the OS to read the first length bytes of a file ahead of use
+    static bool advise(const std::string& filePath, int64_t length, const std::atomic<bool>* cancel = nullptr);
+
+private:
+    int maxFiles;
+    int64_t budget;
+    bool background;    // "backgroundMode": hints at idle I/O priority
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, int64_t> pending;   // file path to hinted bytes
+    int64_t pendingTotal = 0;
+
+    std::atomic<int> filesHinted{0};
+    std::atomic<int64_t> bytesHinted{0};
+    std::atomic<bool> stopping{false};
+    QThreadPool pool;
+};
+
+#endif // READAHEAD_H
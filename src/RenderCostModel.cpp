@@ -0,0 +1,98 @@
+#include "RenderCostModel.h"
+
+#include <QSettings>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Seconds on a typical workstation for a 512px hypersampled render
+const double BASE_SECONDS = 0.5;                // open, prep and shoot the empty scene
+const double FILE_SECONDS_PER_MB = 0.2;         // only when the mix is unknown
+const double OTHER_SECONDS_PER_MB = 0.05;
+const double SECONDS_PER_THOUSAND_SOLIDS = 0.4;
+const double SECONDS_PER_THOUSAND_COMBS = 0.1;
+const double MESH_SECONDS_PER_MB = 0.3;
+
+// Calibration counts the prior as this many samples at a factor of 1
+const double PRIOR_SAMPLES = 5.0;
+const double MIN_SCALE = 0.01;
+const double MAX_SCALE = 100.0;
+
+const double BYTES_PER_MB = 1024.0 * 1024.0;
+
+}
+
+double RenderCostModel::prior(const ModelData& modelData)
+{
+    const double fileMb = std::max<int64_t>(0, modelData.file_size) / BYTES_PER_MB;
+    if (modelData.object_count < 0 || modelData.comb_count < 0 || modelData.mesh_count < 0) {
+        return BASE_SECONDS + fileMb * FILE_SECONDS_PER_MB;
+    }
+
+    const double meshMb = std::max<int64_t>(0, modelData.mesh_bytes) / BYTES_PER_MB;
+    const double combs = static_cast<double>(modelData.comb_count);
+    const double solids = static_cast<double>(
+        std::max<int64_t>(0, modelData.object_count - modelData.comb_count - modelData.mesh_count));
+    return BASE_SECONDS
+        + std::max(0.0, fileMb - meshMb) * OTHER_SECONDS_PER_MB
+        + solids / 1000.0 * SECONDS_PER_THOUSAND_SOLIDS
+        + combs / 1000.0 * SECONDS_PER_THOUSAND_COMBS
+        + meshMb * MESH_SECONDS_PER_MB;
+}
+
+double RenderCostModel::estimate(const ModelData& modelData) const
+{
+    const double predicted = prior(modelData) * scale;
+    if (modelData.render_ms <= 0) {
+        return predicted;
+    }
+
+    const double measured = modelData.render_ms / 1000.0;
+    if (modelData.render_error != StageTimedOut) {
+        return measured;
+    }
+    // It ran out of time: the render takes longer than it was given
+    return std::max(predicted, measured * 2.0);
+}
+
+void RenderCostModel::calibrate(const std::vector<ModelData>& rendered)
+{
+    double logRatios = 0.0;
+    int count = 0;
+    for (const auto& modelData : rendered) {
+        if (modelData.render_ms <= 0 || modelData.render_error == StageTimedOut) {
+            continue;
+        }
+        logRatios += std::log((modelData.render_ms / 1000.0) / prior(modelData));
+        count++;
+    }
+
+    sampleCount = count;
+    scale = std::clamp(std::exp(logRatios / (count + PRIOR_SAMPLES)), MIN_SCALE, MAX_SCALE);
+}
+
+int RenderCostModel::timeLimitMs(double estimateSeconds, bool coarse, int attempt, int64_t lastLimitMs)
+{
+    QSettings settings;
+    const int baseMs = settings.value("previewTimer", 30).toInt() * 1000;
+    if (baseMs <= 0) {
+        return 0;
+    }
+
+    const double retryScale = static_cast<double>(1 << std::clamp(attempt, 0, MAX_RETRY_DOUBLINGS));
+    const double ceilingMs = static_cast<double>(baseMs) * MAX_TIMEOUT_SCALE * retryScale;
+    const double expectedMs = estimateSeconds * 1000.0 * (coarse ? COARSE_FRACTION : 1.0);
+    double limitMs = std::clamp(expectedMs * TIMEOUT_FACTOR, static_cast<double>(baseMs),
+                                static_cast<double>(baseMs) * MAX_TIMEOUT_SCALE) * retryScale;
+    limitMs = std::max(limitMs, 2.0 * static_cast<double>(std::max<int64_t>(0, lastLimitMs)));
+    return static_cast<int>(std::min(limitMs, ceilingMs));
+}
+
+int RenderCostModel::timeLimitMs(const ModelData& modelData, double estimateSeconds, bool coarse)
+{
+    // render_ms of a timeout is the limit that full render was given
+    const int64_t lastLimitMs = !coarse && modelData.render_error == StageTimedOut ? modelData.render_ms : 0;
+    return timeLimitMs(estimateSeconds, coarse, modelData.failure_count, lastLimitMs);
+}
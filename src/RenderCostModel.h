@@ -0,0 +1,71 @@
+#ifndef RENDERCOSTMODEL_H
+#define RENDERCOSTMODEL_H
+
+#include <vector>
+
+#include "Model.h"
+
+/**
+ * @brief Predicts how long a full thumbnail render of a model takes
+ *
+ * The prior is linear in what the header probe reads: a fixed start-up
+ * cost, CSG primitive and combination counts, and the bytes of mesh-like
+ * primitives (BoTs, B-reps, volumes), whose acceleration structures
+ * dominate prep time. Models not probed yet are judged by file size.
+ *
+ * calibrate() learns how fast this machine is from the render times the
+ * catalog recorded: the geometric mean of measured over predicted time,
+ * pulled toward 1 while there are few samples. A model rendered before
+ * is predicted by its own measurement.
+ *
+ * The indexer queues work shortest job first by the estimate, and each
+ * render gets a time limit scaled from it.
+ *
+ * Usage example:
+ *
+ * RenderCostModel costs;
+ * costs.calibrate(model->getRenderTimings());
+ * double seconds = costs.estimate(modelData);
+ * queue.enqueue(modelData, ProcessingQueue::Background, seconds);
+ * int limitMs = RenderCostModel::timeLimitMs(seconds, false);
+ */
+class RenderCostModel {
+public:
+    // Expected seconds for a full render
+    double estimate(const ModelData& modelData) const;
+
+    // Fits the speed factor to models with render_ms; timeouts are skipped
+    void calibrate(const std::vector<ModelData>& rendered);
+    // Measured over predicted time on this machine
+    double speedFactor() const { return scale; }
+    int samples() const { return sampleCount; }
+
+    /*
+     * Time limit for a render expected to take estimateSeconds:
+     * TIMEOUT_FACTOR times the estimate, but no less than the
+     * "previewTimer" setting and no more than MAX_TIMEOUT_SCALE times
+     * it. A "previewTimer" of 0 means no limit (0). Coarse passes are
+     * expected to take COARSE_FRACTION of a full render.
+     *
+     * Retries get more: the limit and its ceiling double with each earlier
+     * failed attempt, up to MAX_RETRY_DOUBLINGS times, and a render that
+     * timed out after lastLimitMs gets at least twice that.
+     */
+    static int timeLimitMs(double estimateSeconds, bool coarse, int attempt = 0, int64_t lastLimitMs = 0);
+    // The same for another attempt at modelData, from its recorded failures
+    static int timeLimitMs(const ModelData& modelData, double estimateSeconds, bool coarse);
+
+    static constexpr double TIMEOUT_FACTOR = 4.0;
+    static constexpr int MAX_TIMEOUT_SCALE = 20;
+    static constexpr double COARSE_FRACTION = 0.25;
+    static constexpr int MAX_RETRY_DOUBLINGS = 4;
+
+private:
+    // Uncalibrated prediction from size and primitive mix
+    static double prior(const ModelData& modelData);
+
+    double scale = 1.0;
+    int sampleCount = 0;
+};
+
+#endif // RENDERCOSTMODEL_H
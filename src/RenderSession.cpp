@@ -0,0 +1,555 @@
+#include "RenderSession.h"
+#include "BackgroundMode.h"
+
+#include <brlcad/raytrace.h>
+
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+namespace {
+
+int thumbnailHit(struct application* ap, struct partition* PartHeadp, struct seg* segs)
+{
+    (void)segs;
+
+    struct partition* pp = PartHeadp->pt_forw;
+    for (; pp != PartHeadp; pp = pp->pt_forw) {
+        if (pp->pt_outhit->hit_dist >= 0.0) {
+            break;
+        }
+    }
+    if (pp == PartHeadp) {
+        ap->a_user = 0;
+        return 0;
+    }
+
+    const ThumbnailOptions* options = static_cast<const ThumbnailOptions*>(ap->a_uptr);
+
+    // rt's default material is a light gray
+    vect_t base = { 0.8, 0.8, 0.8 };
+    if (pp->pt_regionp && pp->pt_regionp->reg_mater.ma_color_valid) {
+        VMOVE(base, pp->pt_regionp->reg_mater.ma_color);
+    }
+
+    fastf_t intensity = 1.0;
+    if (options->shaded) {
+        vect_t normal;
+        struct hit* hitp = pp->pt_inhit;
+        struct soltab* stp = pp->pt_inseg->seg_stp;
+        RT_HIT_NORMAL(normal, hitp, stp, &(ap->a_ray), pp->pt_inflip);
+
+        // Headlight: light travels along the view direction
+        intensity = 0.2 + 0.8 * std::fabs(VDOT(normal, ap->a_ray.r_dir));
+    }
+
+    VSCALE(ap->a_color, base, intensity);
+    ap->a_user = 1;
+    return 1;
+}
+
+int thumbnailMiss(struct application* ap)
+{
+    VSETALL(ap->a_color, 0.0);
+    ap->a_user = 0;
+    return 0;
+}
+
+// What the measuring rays of one grid row found
+struct RaySample {
+    fastf_t tolerance = 0.0;    // gap below which two partitions touch
+    fastf_t length = 0.0;       // inside the geometry
+    int crossings = 0;          // surfaces passed
+    bool hit = false;
+    point_t min;
+    point_t max;
+};
+
+int measureHit(struct application* ap, struct partition* PartHeadp, struct seg* segs)
+{
+    (void)segs;
+
+    RaySample* sample = static_cast<RaySample*>(ap->a_uptr);
+    fastf_t intervalEnd = -INFINITY;
+    for (struct partition* pp = PartHeadp->pt_forw; pp != PartHeadp; pp = pp->pt_forw) {
+        const fastf_t in = pp->pt_inhit->hit_dist;
+        const fastf_t out = pp->pt_outhit->hit_dist;
+        if (!(out > in)) {
+            continue;
+        }
+        sample->length += out - in;
+
+        // Regions that touch form one solid; the face they share is no surface
+        if (in - intervalEnd > sample->tolerance) {
+            sample->crossings += 2;
+        }
+        intervalEnd = out;
+
+        point_t point;
+        VJOIN1(point, ap->a_ray.r_pt, in, ap->a_ray.r_dir);
+        VMIN(sample->min, point);
+        VMAX(sample->max, point);
+        VJOIN1(point, ap->a_ray.r_pt, out, ap->a_ray.r_dir);
+        VMIN(sample->min, point);
+        VMAX(sample->max, point);
+        sample->hit = true;
+    }
+    return 1;
+}
+
+int measureMiss(struct application* ap)
+{
+    (void)ap;
+    return 0;
+}
+
+// Mean of per-direction estimates and the half-width of its 95% interval
+void meanAndError(const std::vector<double>& values, double& mean, double& error)
+{
+    const double n = static_cast<double>(values.size());
+    mean = std::accumulate(values.begin(), values.end(), 0.0) / n;
+    double squares = 0.0;
+    for (double value : values) {
+        squares += (value - mean) * (value - mean);
+    }
+    const double stddev = values.size() > 1 ? std::sqrt(squares / (n - 1.0)) : 0.0;
+    error = 1.96 * stddev / std::sqrt(n);
+}
+
+// The object itself, or every top-level object when it does not exist
+std::vector<std::string> objectsToRender(struct db_i* dbip, const std::string& objectName)
+{
+    std::vector<std::string> names;
+    if (db_lookup(dbip, objectName.c_str(), LOOKUP_QUIET) != RT_DIR_NULL) {
+        names.push_back(objectName);
+        return names;
+    }
+
+    struct directory** dirs = nullptr;
+    size_t count = db_ls(dbip, DB_LS_TOPS, nullptr, &dirs);
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back(dirs[i]->d_namep);
+    }
+    if (dirs) {
+        bu_free(dirs, "RenderSession tops");
+    }
+    return names;
+}
+
+// Eye placement for one view: rays run along dir, the image spans right and up
+struct ViewFrame {
+    vect_t toEye;
+    vect_t dir;
+    vect_t right;
+    vect_t up;
+};
+
+ViewFrame frameFor(const ThumbnailOptions& view)
+{
+    ViewFrame frame;
+    const fastf_t az = view.azimuth * DEG2RAD;
+    const fastf_t el = view.elevation * DEG2RAD;
+    VSET(frame.toEye, std::cos(el) * std::cos(az), std::cos(el) * std::sin(az), std::sin(el));
+    VREVERSE(frame.dir, frame.toEye);
+
+    // Straight down or up: z cannot serve as the up direction
+    vect_t zAxis = { 0.0, 0.0, 1.0 };
+    vect_t yAxis = { 0.0, 1.0, 0.0 };
+    const bool vertical = std::fabs(frame.dir[Z]) > 1.0 - 1e-9;
+    VCROSS(frame.right, frame.dir, vertical ? yAxis : zAxis);
+    VUNITIZE(frame.right);
+    VCROSS(frame.up, frame.right, frame.dir);
+    return frame;
+}
+
+}
+
+RenderSession::RenderSession(int threads)
+    : threads(std::clamp(threads > 0 ? threads : QThread::idealThreadCount(), 1, MAX_PSW))
+{
+    if (BackgroundMode::currentThreadLowered()) {
+        lowPool = std::make_unique<QThreadPool>();
+        lowPool->setMaxThreadCount(this->threads);
+    }
+}
+
+RenderSession::~RenderSession()
+{
+    close();
+}
+
+void RenderSession::close()
+{
+    if (rtip) {
+        // Also releases the resources registered with it
+        rt_free_rti(rtip);
+        rtip = nullptr;
+    }
+    resources.clear();
+    if (ownedDbip) {
+        db_close(ownedDbip);
+        ownedDbip = nullptr;
+    }
+    radius = 0.0;
+}
+
+bool RenderSession::open(const std::string& filePath, const std::string& objectName)
+{
+    close();
+    QElapsedTimer timer;
+    timer.start();
+
+    struct db_i* dbip = db_open(filePath.c_str(), DB_OPEN_READONLY);
+    if (dbip == DBI_NULL) {
+        qDebug() << "[RenderSession::open] Unable to open" << QString::fromStdString(filePath);
+        return false;
+    }
+    if (db_dirbuild(dbip) < 0) {
+        qDebug() << "[RenderSession::open] Unable to read directory of" << QString::fromStdString(filePath);
+        db_close(dbip);
+        return false;
+    }
+
+    if (!prepare(dbip, objectName)) {
+        db_close(dbip);
+        return false;
+    }
+    ownedDbip = dbip;
+    prepElapsedMs = timer.elapsed();
+    return true;
+}
+
+bool RenderSession::prepare(struct db_i* dbip, const std::string& objectName)
+{
+    close();
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!dbip) {
+        return false;
+    }
+
+    std::vector<std::string> names = objectsToRender(dbip, objectName);
+    if (names.empty()) {
+        qDebug() << "[RenderSession::prepare] Nothing to render for" << QString::fromStdString(objectName);
+        return false;
+    }
+
+    rtip = rt_new_rti(dbip);
+    if (!rtip) {
+        return false;
+    }
+
+    // One resource per tracing thread; they must exist before prep
+    resources.resize(static_cast<size_t>(threads));
+    for (int i = 0; i < threads; ++i) {
+        std::memset(&resources[i], 0, sizeof(struct resource));
+        rt_init_resource(&resources[i], i, rtip);
+    }
+
+    std::vector<const char*> argv;
+    for (const auto& name : names) {
+        argv.push_back(name.c_str());
+    }
+    if (rt_gettrees(rtip, static_cast<int>(argv.size()), argv.data(), threads) < 0) {
+        qDebug() << "[RenderSession::prepare] rt_gettrees failed for" << QString::fromStdString(objectName);
+        close();
+        return false;
+    }
+    rt_prep_parallel(rtip, threads);
+
+    vect_t extent;
+    VSUB2(extent, rtip->mdl_max, rtip->mdl_min);
+    radius = MAGNITUDE(extent) * 0.5;
+    if (!(radius > 0.0) || !std::isfinite(radius)) {
+        qDebug() << "[RenderSession::prepare] Empty bounding box for" << QString::fromStdString(objectName);
+        close();
+        return false;
+    }
+    VADD2SCALE(center, rtip->mdl_min, rtip->mdl_max, 0.5);
+
+    prepElapsedMs = timer.elapsed();
+    qDebug() << "[RenderSession::prepare] Prepped" << QString::fromStdString(objectName)
+        << "in" << prepElapsedMs << "ms";
+    return true;
+}
+
+bool RenderSession::trace(const std::vector<ThumbnailOptions>& views, std::vector<QImage>& images, int timeLimitMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    images.clear();
+
+    if (!rtip || views.empty()) {
+        return false;
+    }
+
+    std::vector<ViewFrame> frames;
+    std::vector<std::vector<QRgb>> pixels;
+    // Every row of every view, handed out in order
+    std::vector<std::pair<int, int>> rows;
+    for (size_t v = 0; v < views.size(); ++v) {
+        const int size = views[v].size;
+        if (size <= 0) {
+            return false;
+        }
+        frames.push_back(frameFor(views[v]));
+        pixels.emplace_back(static_cast<size_t>(size) * size, qRgb(0, 0, 0));
+        for (int y = 0; y < size; ++y) {
+            rows.emplace_back(static_cast<int>(v), y);
+        }
+    }
+
+    std::atomic<size_t> nextRow(0);
+    std::atomic<bool> timedOut(false);
+
+    auto traceRows = [&](int worker) {
+        struct application ap;
+        RT_APPLICATION_INIT(&ap);
+        ap.a_rt_i = rtip;
+        ap.a_resource = &resources[static_cast<size_t>(worker)];
+        ap.a_hit = thumbnailHit;
+        ap.a_miss = thumbnailMiss;
+        ap.a_onehit = 1;
+        std::uniform_real_distribution<fastf_t> offset(0.0, 1.0);
+
+        while (!timedOut.load()) {
+            const size_t row = nextRow.fetch_add(1);
+            if (row >= rows.size()) {
+                return;
+            }
+            if (timeLimitMs > 0 && timer.elapsed() > timeLimitMs) {
+                timedOut.store(true);
+                return;
+            }
+
+            const int v = rows[row].first;
+            const int y = rows[row].second;
+            const ThumbnailOptions& view = views[static_cast<size_t>(v)];
+            const ViewFrame& frame = frames[static_cast<size_t>(v)];
+            const int size = view.size;
+            ap.a_uptr = const_cast<ThumbnailOptions*>(&view);
+            VMOVE(ap.a_ray.r_dir, frame.dir);
+
+            // Seeded by row, so the image does not depend on which thread traced it
+            const int samples = 1 + std::max(0, view.hypersample);
+            std::mt19937 jitter(static_cast<unsigned>(y + 1));
+            QRgb* line = pixels[static_cast<size_t>(v)].data() + static_cast<size_t>(y) * size;
+
+            for (int x = 0; x < size; ++x) {
+                vect_t sum = VINIT_ZERO;
+                for (int s = 0; s < samples; ++s) {
+                    fastf_t jx = (s == 0) ? 0.5 : offset(jitter);
+                    fastf_t jy = (s == 0) ? 0.5 : offset(jitter);
+                    fastf_t u = ((x + jx) / size * 2.0 - 1.0) * radius;
+                    fastf_t w = (1.0 - (y + jy) / size * 2.0) * radius;
+                    VJOIN3(ap.a_ray.r_pt, center, radius * 2.0, frame.toEye, u, frame.right, w, frame.up);
+
+                    VSETALL(ap.a_color, 0.0);
+                    rt_shootray(&ap);
+                    VADD2(sum, sum, ap.a_color);
+                }
+                VSCALE(sum, sum, 1.0 / samples);
+                line[x] = qRgb(
+                    std::clamp(static_cast<int>(sum[X] * 255.0 + 0.5), 0, 255),
+                    std::clamp(static_cast<int>(sum[Y] * 255.0 + 0.5), 0, 255),
+                    std::clamp(static_cast<int>(sum[Z] * 255.0 + 0.5), 0, 255));
+            }
+        }
+    };
+
+    runWorkers(static_cast<int>(std::min(resources.size(), rows.size())), traceRows);
+
+    if (timedOut.load()) {
+        qDebug() << "[RenderSession::trace] Timed out after" << timeLimitMs / 1000 << "seconds.";
+        return false;
+    }
+
+    for (size_t v = 0; v < views.size(); ++v) {
+        const int size = views[v].size;
+        // copy() detaches the image from the pixel buffer going out of scope
+        images.push_back(QImage(reinterpret_cast<const uchar*>(pixels[v].data()), size, size,
+                                QImage::Format_RGB32).copy());
+    }
+    qDebug() << "[RenderSession::trace] Traced" << views.size() << "views in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool RenderSession::measure(GeometryMetrics& metrics, int timeLimitMs, int directions, int gridSize)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!rtip || directions <= 0 || gridSize <= 0) {
+        return false;
+    }
+
+    // Lines have no orientation, so a hemisphere of directions is enough; a
+    // golden-angle spiral spreads them evenly over it
+    std::vector<ViewFrame> frames;
+    const double goldenAngle = M_PI * (3.0 - std::sqrt(5.0));
+    for (int d = 0; d < directions; ++d) {
+        ThumbnailOptions direction;
+        direction.elevation = std::asin((d + 0.5) / directions) * RAD2DEG;
+        direction.azimuth = std::fmod(d * goldenAngle, 2.0 * M_PI) * RAD2DEG;
+        frames.push_back(frameFor(direction));
+    }
+
+    // Every grid row of every direction, each with its own sums
+    const size_t rowCount = static_cast<size_t>(directions) * static_cast<size_t>(gridSize);
+    std::vector<RaySample> samples(rowCount);
+    const fastf_t cell = 2.0 * radius / gridSize;
+    std::atomic<size_t> nextRow(0);
+    std::atomic<bool> timedOut(false);
+
+    auto measureRows = [&](int worker) {
+        struct application ap;
+        RT_APPLICATION_INIT(&ap);
+        ap.a_rt_i = rtip;
+        ap.a_resource = &resources[static_cast<size_t>(worker)];
+        ap.a_hit = measureHit;
+        ap.a_miss = measureMiss;
+        ap.a_onehit = 0;
+        std::uniform_real_distribution<fastf_t> offset(0.0, 1.0);
+
+        while (!timedOut.load()) {
+            const size_t row = nextRow.fetch_add(1);
+            if (row >= rowCount) {
+                return;
+            }
+            if (timeLimitMs > 0 && timer.elapsed() > timeLimitMs) {
+                timedOut.store(true);
+                return;
+            }
+
+            const ViewFrame& frame = frames[row / static_cast<size_t>(gridSize)];
+            const int y = static_cast<int>(row % static_cast<size_t>(gridSize));
+            RaySample& sample = samples[row];
+            sample.tolerance = rtip->rti_tol.dist;
+            VSETALL(sample.min, INFINITY);
+            VSETALL(sample.max, -INFINITY);
+            ap.a_uptr = &sample;
+            VMOVE(ap.a_ray.r_dir, frame.dir);
+
+            // One ray at a random spot of every cell, seeded by row
+            std::mt19937 jitter(static_cast<unsigned>(row + 1));
+            for (int x = 0; x < gridSize; ++x) {
+                fastf_t u = (x + offset(jitter)) * cell - radius;
+                fastf_t w = (y + offset(jitter)) * cell - radius;
+                VJOIN3(ap.a_ray.r_pt, center, radius * 2.0, frame.toEye, u, frame.right, w, frame.up);
+                rt_shootray(&ap);
+            }
+        }
+    };
+
+    runWorkers(static_cast<int>(std::min(resources.size(), rowCount)), measureRows);
+
+    if (timedOut.load()) {
+        qDebug() << "[RenderSession::measure] Timed out after" << timeLimitMs / 1000 << "seconds.";
+        return false;
+    }
+
+    // One estimate per direction; their spread gives the error bounds
+    std::vector<double> volumes(static_cast<size_t>(directions), 0.0);
+    std::vector<double> areas(static_cast<size_t>(directions), 0.0);
+    point_t min = { INFINITY, INFINITY, INFINITY };
+    point_t max = { -INFINITY, -INFINITY, -INFINITY };
+    bool anyHit = false;
+    for (size_t row = 0; row < rowCount; ++row) {
+        const RaySample& sample = samples[row];
+        const size_t d = row / static_cast<size_t>(gridSize);
+        volumes[d] += sample.length * cell * cell;
+        // Cauchy-Crofton: crossings times the area per ray, averaged over
+        // all directions, is half the surface area
+        areas[d] += 2.0 * sample.crossings * cell * cell;
+        if (sample.hit) {
+            VMIN(min, sample.min);
+            VMAX(max, sample.max);
+            anyHit = true;
+        }
+    }
+    if (!anyHit) {
+        qDebug() << "[RenderSession::measure] No ray hit the geometry.";
+        return false;
+    }
+
+    VMOVE(metrics.bbox_min, min);
+    VMOVE(metrics.bbox_max, max);
+    meanAndError(volumes, metrics.volume, metrics.volume_error);
+    meanAndError(areas, metrics.surface_area, metrics.surface_area_error);
+    metrics.sampled = true;
+    qDebug() << "[RenderSession::measure] Volume" << metrics.volume << "+/-" << metrics.volume_error
+        << "mm^3, area" << metrics.surface_area << "+/-" << metrics.surface_area_error
+        << "mm^2 in" << timer.elapsed() << "ms";
+    return true;
+}
+
+void RenderSession::runWorkers(int count, const std::function<void(int)>& work)
+{
+    if (count <= 1) {
+        work(0);
+        return;
+    }
+    std::vector<int> workers(static_cast<size_t>(count));
+    std::iota(workers.begin(), workers.end(), 0);
+    if (!lowPool) {
+        QtConcurrent::blockingMap(workers, work);
+        return;
+    }
+    QtConcurrent::blockingMap(lowPool.get(), workers, [&work](int worker) {
+        BackgroundMode::lowerCurrentThread();
+        work(worker);
+    });
+}
+
+bool RenderSession::shoot(const std::vector<ThumbnailOptions>& views, std::vector<std::vector<char>>& pngs,
+                          int timeLimitMs)
+{
+    pngs.clear();
+    std::vector<QImage> images;
+    if (!trace(views, images, timeLimitMs)) {
+        return false;
+    }
+
+    pngs.resize(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (!encodePng(images[i], pngs[i])) {
+            pngs.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RenderSession::shoot(const ThumbnailOptions& view, std::vector<char>& png, int timeLimitMs)
+{
+    std::vector<std::vector<char>> pngs;
+    if (!shoot(std::vector<ThumbnailOptions>{ view }, pngs, timeLimitMs)) {
+        return false;
+    }
+    png = std::move(pngs.front());
+    return true;
+}
+
+bool RenderSession::encodePng(const QImage& image, std::vector<char>& png)
+{
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "PNG")) {
+        qDebug() << "[RenderSession::encodePng] PNG encoding failed.";
+        return false;
+    }
+    png.assign(encoded.begin(), encoded.end());
+    return true;
+}
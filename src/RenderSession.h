@@ -0,0 +1,103 @@
+#ifndef RENDERSESSION_H
+#define RENDERSESSION_H
+
+#include <QImage>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GeometryMetrics.h"
+#include "ThumbnailRenderer.h"
+
+class QThreadPool;
+struct db_i;
+struct resource;
+struct rt_i;
+
+/**
+ * @brief Prepped geometry that any number of images are shot from
+ *
+ * On large assemblies, opening the database and running rt_prep cost far
+ * more than tracing an image. A session does both once for a file and
+ * object set, then traces as many views, sizes and lighting modes as
+ * asked for from the same rt_i. Rows of all requested images are handed
+ * out one at a time to a thread per librt resource, so every core stays
+ * busy until the last row is done. Views are orthographic and fitted to
+ * the model's bounding box; with the same options a session always
+ * produces the same image. The same prep also serves measure(), which
+ * samples the geometry's extent, volume and surface area.
+ *
+ * Usage example:
+ *
+ * RenderSession session;
+ * if (session.open("/lib/truck.g", "all")) {
+ *     std::vector<std::vector<char>> pngs;
+ *     session.shoot({ front, side, top }, pngs);
+ * }
+ */
+class RenderSession {
+public:
+    // threads <= 0 uses every core
+    explicit RenderSession(int threads = 0);
+    ~RenderSession();
+    RenderSession(const RenderSession&) = delete;
+    RenderSession& operator=(const RenderSession&) = delete;
+
+    /*
+     * Opens filePath read-only and preps objectName, or every top-level
+     * object when it does not exist. The file stays open until close().
+     */
+    bool open(const std::string& filePath, const std::string& objectName);
+    // Same on a database whose directory is built; it is not closed
+    bool prepare(struct db_i* dbip, const std::string& objectName);
+    bool isPrepared() const { return rtip != nullptr; }
+    void close();
+
+    // Time the last open or prepare took
+    int64_t prepMs() const { return prepElapsedMs; }
+
+    /*
+     * Traces one image per view. All or nothing: false when any view is
+     * invalid or the time limit (0 for none, counted from the call) runs
+     * out.
+     */
+    bool trace(const std::vector<ThumbnailOptions>& views, std::vector<QImage>& images, int timeLimitMs = 0);
+
+    // trace() encoded to PNG
+    bool shoot(const std::vector<ThumbnailOptions>& views, std::vector<std::vector<char>>& pngs, int timeLimitMs = 0);
+    bool shoot(const ThumbnailOptions& view, std::vector<char>& png, int timeLimitMs = 0);
+
+    static bool encodePng(const QImage& image, std::vector<char>& png);
+
+    /*
+     * Ray-samples the bounding box, volume and surface area of the prepped
+     * geometry into metrics (see GeometryMetrics): gridSize x gridSize
+     * jittered rays from each of directions directions, handed out to the
+     * tracing threads like image rows. Counts in metrics are left alone.
+     * False when the time limit (0 for none) runs out or nothing is hit.
+     */
+    static const int MEASURE_DIRECTIONS = 24;
+    static const int MEASURE_GRID = 64;
+    bool measure(GeometryMetrics& metrics, int timeLimitMs = 0, int directions = MEASURE_DIRECTIONS,
+                 int gridSize = MEASURE_GRID);
+
+private:
+    // Runs work(0 .. count - 1) on the tracing threads
+    void runWorkers(int count, const std::function<void(int)>& work);
+
+    int threads;
+    // Threads of their own when the session was made on a lowered
+    // (background mode) thread, so no shared pool thread stays lowered
+    std::unique_ptr<QThreadPool> lowPool;
+    struct db_i* ownedDbip = nullptr;
+    struct rt_i* rtip = nullptr;
+    std::vector<struct resource> resources;
+    double center[3] = { 0.0, 0.0, 0.0 };
+    double radius = 0.0;
+    int64_t prepElapsedMs = 0;
+};
+
+#endif // RENDERSESSION_H
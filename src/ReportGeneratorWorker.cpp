@@ -1,4 +1,5 @@
 #include "ReportGeneratorWorker.h"
+#include "MemoryBudget.h"
 #include "ProcessGFiles.h"
 #include <QDebug>
 #include <filesystem>
@@ -52,6 +53,16 @@ void ReportGeneratorWorker::process() {
 
     emit processingGistCall(QString::fromStdString(modelData.file_path));
 
+    // gist opens the whole database too; it waits for room next to the
+    // indexer instead of pushing the machine into swap
+    MemoryReservation reservation(
+        MemoryBudget::shared(), MemoryBudget::estimate(modelData),
+        []() { return QThread::currentThread()->isInterruptionRequested(); });
+    if (!reservation.admitted()) {
+      qDebug() << "ReportGeneratorWorker::process() stopping due to interruption request";
+      break;
+    }
+
     // Use the generateGistReport method
     auto [success, errorMessage, command] = processor.generateGistReport(
         modelData.file_path, path_gist_output, primary_obj, label);
@@ -1,6 +1,8 @@
 #include "SettingWindow.h"
 #include "ui_SettingWindow.h"
 #include <QSettings>
+#include <QThread>
+#include <algorithm>
 
 SettingWindow::SettingWindow(QWidget *parent)
     : QDialog(parent)
@@ -26,6 +28,23 @@ void SettingWindow::loadSettings()
     ui->previewTimer->setRange(0,2400);
     ui->previewTimer->setSingleStep(10);
     ui->previewTimer->setValue(previewLimit);
+
+    int indexingThreads = settings.value("indexingThreads", QThread::idealThreadCount()).toInt();
+    ui->indexingThreads->setRange(1, 64);
+    ui->indexingThreads->setValue(indexingThreads);
+
+    int renderThreads = settings.value("renderThreads", std::max(1, QThread::idealThreadCount() / 2)).toInt();
+    ui->renderThreads->setRange(1, 64);
+    ui->renderThreads->setValue(renderThreads);
+
+    ui->progressivePreviews->setChecked(settings.value("progressivePreviews", true).toBool());
+    ui->multiViewPreviews->setChecked(settings.value("multiViewPreviews", false).toBool());
+    ui->backgroundMode->setChecked(settings.value("backgroundMode", false).toBool());
+
+    // 0 disables the shared preview cache
+    ui->thumbnailCacheMB->setRange(0, 65536);
+    ui->thumbnailCacheMB->setSingleStep(64);
+    ui->thumbnailCacheMB->setValue(settings.value("thumbnailCacheMB", 512).toInt());
 }
 
 void SettingWindow::saveSettings()
@@ -35,6 +54,12 @@ void SettingWindow::saveSettings()
     if(ui->enablePreview->isChecked()){
     settings.setValue("previewTimer", ui->previewTimer->value());
     }
+    settings.setValue("indexingThreads", ui->indexingThreads->value());
+    settings.setValue("renderThreads", ui->renderThreads->value());
+    settings.setValue("progressivePreviews", ui->progressivePreviews->isChecked());
+    settings.setValue("multiViewPreviews", ui->multiViewPreviews->isChecked());
+    settings.setValue("backgroundMode", ui->backgroundMode->isChecked());
+    settings.setValue("thumbnailCacheMB", ui->thumbnailCacheMB->value());
 }
 
 void SettingWindow::on_buttonBox_accepted()
@@ -0,0 +1,91 @@
+#include "StageTime.h"
+
+#include <chrono>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+
+int64_t wallNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+int64_t StageClock::threadCpuUs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return -1;
+    }
+    // 100 ns ticks
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<int64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 10;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+#else
+    return -1;
+#endif
+}
+
+void StageClock::restart()
+{
+    wallStartUs = wallNowUs();
+    cpuStartUs = threadCpuUs();
+}
+
+StageTime StageClock::elapsed() const
+{
+    StageTime time = elapsedWall();
+    int64_t cpuNowUs = threadCpuUs();
+    time.cpuUs = cpuStartUs >= 0 && cpuNowUs >= 0 ? cpuNowUs - cpuStartUs : -1;
+    return time;
+}
+
+StageTime StageClock::elapsedWall() const
+{
+    StageTime time;
+    time.wallUs = wallNowUs() - wallStartUs;
+    time.cpuUs = -1;
+    return time;
+}
+
+void StageTotals::add(const StageTime& time)
+{
+    samples++;
+    wallUs += time.wallUs;
+    if (time.hasCpu()) {
+        cpuUs += time.cpuUs;
+    }
+    else {
+        cpuKnown = false;
+    }
+}
+
+std::string StageTotals::summary(const char* stage) const
+{
+    char line[160];
+    if (!cpuKnown || wallUs <= 0) {
+        std::snprintf(line, sizeof(line), "%s: %d files, %.1f s wall", stage, samples, wallUs / 1e6);
+    }
+    else {
+        int64_t waitUs = wallUs > cpuUs ? wallUs - cpuUs : 0;
+        std::snprintf(line, sizeof(line), "%s: %d files, %.1f s wall, %.1f s CPU, %d%% waiting", stage, samples,
+                      wallUs / 1e6, cpuUs / 1e6, static_cast<int>(100 * waitUs / wallUs));
+    }
+    return line;
+}
@@ -0,0 +1,197 @@
+#include "ThumbnailCache.h"
+#include "ContentHasher.h"
+
+#include <QDebug>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bumped whenever the renderer's output changes for the same inputs
+const char* const CACHE_FORMAT = "thumbnail-v1";
+
+// Running size per cache directory, shared by every instance in the process
+std::mutex cacheMutex;
+std::map<std::string, int64_t> cacheBytes;
+
+int64_t scanBytes(const std::string& directory)
+{
+    int64_t total = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            total += static_cast<int64_t>(it->file_size(ec));
+        }
+    }
+    return total;
+}
+
+}
+
+ThumbnailCache::ThumbnailCache(const std::string& directory, int64_t maxBytes)
+    : directory(directory), maxBytes(maxBytes)
+{
+    if (this->maxBytes < 0) {
+        QSettings settings;
+        this->maxBytes = settings.value("thumbnailCacheMB", 512).toLongLong() * 1024 * 1024;
+    }
+}
+
+std::string ThumbnailCache::defaultDirectory()
+{
+    QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return (fs::path(cacheRoot.toStdString()) / "thumbnails").string();
+}
+
+std::string ThumbnailCache::key(const std::string& contentHash, const std::string& objectName,
+                                const ThumbnailOptions& options)
+{
+    if (contentHash.empty()) {
+        return std::string();
+    }
+
+    std::ostringstream parts;
+    parts << CACHE_FORMAT << '\0' << contentHash << '\0' << objectName << '\0'
+          << options.size << '\0' << options.hypersample << '\0' << options.shaded << '\0'
+          << options.azimuth << '\0' << options.elevation;
+    std::string text = parts.str();
+
+    ContentHasher hasher;
+    hasher.update(text.data(), text.size());
+    return ContentHasher::toHex(hasher.digest());
+}
+
+std::string ThumbnailCache::entryPath(const std::string& key) const
+{
+    // Two-character fan-out keeps directories small
+    return (fs::path(directory) / key.substr(0, 2) / (key + ".png")).string();
+}
+
+bool ThumbnailCache::lookup(const std::string& key, std::vector<char>& png)
+{
+    if (key.empty()) {
+        return false;
+    }
+
+    std::string path = entryPath(key);
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.empty()) {
+        return false;
+    }
+
+    // Recently used entries are the last to be evicted
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+    png = std::move(data);
+    return true;
+}
+
+bool ThumbnailCache::store(const std::string& key, const std::vector<char>& png)
+{
+    if (key.empty() || png.empty() || maxBytes == 0) {
+        return false;
+    }
+
+    std::string path = entryPath(key);
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    // Written aside and renamed so readers never see a partial file
+    std::ostringstream tmpName;
+    tmpName << path << ".tmp" << std::this_thread::get_id();
+    std::string tmpPath = tmpName.str();
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.write(png.data(), static_cast<std::streamsize>(png.size()))) {
+            qDebug() << "[ThumbnailCache::store] Could not write" << QString::fromStdString(tmpPath);
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+
+    bool overCap = false;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cacheBytes.find(directory);
+        if (it == cacheBytes.end()) {
+            it = cacheBytes.emplace(directory, scanBytes(directory)).first;
+        }
+        else {
+            it->second += static_cast<int64_t>(png.size());
+        }
+        overCap = it->second > maxBytes;
+    }
+    if (overCap) {
+        trim();
+    }
+    return true;
+}
+
+void ThumbnailCache::trim()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        int64_t size;
+    };
+    std::vector<Entry> entries;
+    int64_t total = 0;
+
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        Entry entry{ it->path(), it->last_write_time(ec), static_cast<int64_t>(it->file_size(ec)) };
+        total += entry.size;
+        entries.push_back(entry);
+    }
+
+    // Evict down to 90% so the next few stores do not trim again
+    const int64_t target = maxBytes - maxBytes / 10;
+    if (total > maxBytes) {
+        std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.used < b.used; });
+
+        int evicted = 0;
+        for (const auto& entry : entries) {
+            if (total <= target) {
+                break;
+            }
+            if (fs::remove(entry.path, ec)) {
+                total -= entry.size;
+                evicted++;
+            }
+        }
+        qDebug() << "[ThumbnailCache::trim] Evicted" << evicted << "entries, cache now" << total << "bytes";
+    }
+
+    cacheBytes[directory] = total;
+}
+
+int64_t ThumbnailCache::totalBytes() const
+{
+    return scanBytes(directory);
+}
@@ -0,0 +1,57 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ThumbnailRenderer.h"
+
+/**
+ * @brief Content-addressed store of rendered previews, shared by all libraries
+ *
+ * An entry is keyed by what determines the image: the .g file's content
+ * hash, the rendered object and the render options (size, sampling,
+ * lighting, view). A reset catalog, a moved file or the same file in a
+ * second library therefore finds its preview here instead of rendering
+ * it again.
+ *
+ * Entries are plain PNG files below the user cache directory. Reading an
+ * entry refreshes its modification time; once the cache grows past its
+ * size cap, the least recently used entries are evicted.
+ *
+ * Usage example:
+ *
+ * ThumbnailCache cache;
+ * std::string key = ThumbnailCache::key(modelData.content_hash, "all", options);
+ * if (!cache.lookup(key, png)) {
+ *     ... render ...
+ *     cache.store(key, png);
+ * }
+ */
+class ThumbnailCache {
+public:
+    // maxBytes < 0 reads the "thumbnailCacheMB" setting
+    explicit ThumbnailCache(const std::string& directory = defaultDirectory(), int64_t maxBytes = -1);
+
+    static std::string defaultDirectory();
+
+    // Empty when contentHash is empty: nothing identifies the geometry then
+    static std::string key(const std::string& contentHash, const std::string& objectName,
+                           const ThumbnailOptions& options);
+
+    bool lookup(const std::string& key, std::vector<char>& png);
+    bool store(const std::string& key, const std::vector<char>& png);
+
+    // Evict least recently used entries until the cache fits its cap
+    void trim();
+    int64_t totalBytes() const;
+
+private:
+    std::string entryPath(const std::string& key) const;
+
+    std::string directory;
+    int64_t maxBytes;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,231 @@
+#include "ThumbnailRenderer.h"
+#include "RenderSession.h"
+
+#include <brlcad/raytrace.h>
+
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QImageWriter>
+#include <QPainter>
+
+#include <algorithm>
+
+namespace {
+
+bool encodeCompact(const QImage& image, const std::string& format, std::vector<char>& data)
+{
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, QByteArray::fromStdString(format));
+    // WebP: lossy at a quality that holds up for previews. PNG is
+    // lossless; quality 0 selects zlib's strongest compression.
+    writer.setQuality(format == "webp" ? 80 : 0);
+    if (!writer.write(image)) {
+        qDebug() << "[ThumbnailRenderer] Encoding" << QString::fromStdString(format) << "failed:" << writer.errorString();
+        return false;
+    }
+    data.assign(encoded.begin(), encoded.end());
+    return true;
+}
+
+}
+
+ThumbnailRenderer::ThumbnailRenderer(int threads)
+    : threads(std::clamp(threads, 1, MAX_PSW))
+{
+}
+
+bool ThumbnailRenderer::render(struct db_i* dbip, const std::string& objectName, const ThumbnailOptions& options,
+                               std::vector<char>& png, int timeLimitMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    RenderSession session(threads);
+    if (options.size <= 0 || !session.prepare(dbip, objectName)) {
+        return false;
+    }
+    std::vector<std::vector<char>> pngs;
+    if (!shootWithin(session, objectName, { options }, pngs, timeLimitMs, timer.elapsed())) {
+        return false;
+    }
+    png = std::move(pngs.front());
+    return true;
+}
+
+bool ThumbnailRenderer::renderFile(const std::string& filePath, const std::string& objectName,
+                                   const ThumbnailOptions& options, std::vector<char>& png, int timeLimitMs,
+                                   GeometryMetrics* metrics, int measureLimitMs)
+{
+    std::vector<std::vector<char>> pngs;
+    if (!renderFileViews(filePath, objectName, { options }, pngs, timeLimitMs, metrics, measureLimitMs)) {
+        return false;
+    }
+    png = std::move(pngs.front());
+    return true;
+}
+
+bool ThumbnailRenderer::renderFileViews(const std::string& filePath, const std::string& objectName,
+                                        const std::vector<ThumbnailOptions>& views,
+                                        std::vector<std::vector<char>>& pngs, int timeLimitMs,
+                                        GeometryMetrics* metrics, int measureLimitMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    lastMeasureMs = 0;
+
+    const bool validViews = !views.empty()
+        && std::all_of(views.begin(), views.end(), [](const ThumbnailOptions& view) { return view.size > 0; });
+    RenderSession session(threads);
+    if (!validViews || !session.open(filePath, objectName)) {
+        qDebug() << "[ThumbnailRenderer::renderFile] Unable to render" << QString::fromStdString(filePath);
+        return false;
+    }
+    if (!shootWithin(session, objectName, views, pngs, timeLimitMs, timer.elapsed())) {
+        return false;
+    }
+
+    // The prep is already paid for; sampling only costs its rays
+    if (metrics) {
+        timer.restart();
+        if (!session.measure(*metrics, measureLimitMs)) {
+            qDebug() << "[ThumbnailRenderer::renderFileViews] Geometry of" << QString::fromStdString(objectName)
+                << "could not be sampled";
+        }
+        lastMeasureMs = timer.elapsed();
+    }
+    return true;
+}
+
+bool ThumbnailRenderer::measureFile(const std::string& filePath, const std::string& objectName,
+                                    GeometryMetrics& metrics, int measureLimitMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    RenderSession session(threads);
+    bool ok = session.open(filePath, objectName) && session.measure(metrics, measureLimitMs);
+    lastMeasureMs = timer.elapsed();
+    if (!ok) {
+        qDebug() << "[ThumbnailRenderer::measureFile] Geometry of" << QString::fromStdString(objectName)
+            << "could not be sampled";
+    }
+    return ok;
+}
+
+bool ThumbnailRenderer::shootWithin(RenderSession& session, const std::string& objectName,
+                                    const std::vector<ThumbnailOptions>& views,
+                                    std::vector<std::vector<char>>& pngs, int timeLimitMs, int64_t elapsedMs)
+{
+    // Prep counts against the limit
+    int remainingMs = 0;
+    if (timeLimitMs > 0) {
+        remainingMs = timeLimitMs - static_cast<int>(elapsedMs);
+        if (remainingMs <= 0) {
+            qDebug() << "[ThumbnailRenderer::render] Timed out after" << timeLimitMs / 1000 << "seconds.";
+            return false;
+        }
+    }
+
+    if (!session.shoot(views, pngs, remainingMs)) {
+        return false;
+    }
+    qDebug() << "[ThumbnailRenderer::render] Rendered" << QString::fromStdString(objectName)
+        << "in" << views.size() << "view(s) at" << views.front().size << "px, prep took"
+        << session.prepMs() << "ms";
+    return true;
+}
+
+const std::vector<int>& ThumbnailRenderer::mipmapSizes()
+{
+    static const std::vector<int> sizes = { 64, 128, 512 };
+    return sizes;
+}
+
+std::string ThumbnailRenderer::compactFormat()
+{
+    static const bool hasWebp = QImageWriter::supportedImageFormats().contains("webp");
+    return hasWebp ? "webp" : "png";
+}
+
+std::vector<ThumbnailImage> ThumbnailRenderer::mipmaps(const std::vector<char>& png)
+{
+    std::vector<ThumbnailImage> images;
+    QImage source = QImage::fromData(reinterpret_cast<const uchar*>(png.data()), static_cast<int>(png.size()));
+    if (source.isNull()) {
+        return images;
+    }
+
+    const int sourceSize = std::max(source.width(), source.height());
+    std::vector<int> sizes;
+    for (int size : mipmapSizes()) {
+        if (size <= sourceSize) {
+            sizes.push_back(size);
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back(sourceSize);
+    }
+
+    const std::string format = compactFormat();
+    for (int size : sizes) {
+        QImage scaled = (size == sourceSize)
+            ? source
+            : source.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+        ThumbnailImage image;
+        if (!encodeCompact(scaled, format, image.data)) {
+            qDebug() << "[ThumbnailRenderer::mipmaps] Encoding" << size << "px failed";
+            continue;
+        }
+        image.size = size;
+        image.format = format;
+        images.push_back(std::move(image));
+    }
+    return images;
+}
+
+std::vector<ThumbnailOptions> ThumbnailRenderer::viewSet(const ThumbnailOptions& options)
+{
+    std::vector<ThumbnailOptions> views(4, options);
+    views[1].azimuth = 0.0;     // front
+    views[1].elevation = 0.0;
+    views[2].azimuth = 90.0;    // side
+    views[2].elevation = 0.0;
+    views[3].azimuth = 0.0;     // top
+    views[3].elevation = 90.0;
+    return views;
+}
+
+ThumbnailImage ThumbnailRenderer::packAtlas(const std::vector<std::vector<char>>& pngs, int tileSize)
+{
+    ThumbnailImage atlas;
+    if (pngs.empty() || tileSize <= 0) {
+        return atlas;
+    }
+
+    QImage packed(tileSize * static_cast<int>(pngs.size()), tileSize, QImage::Format_RGB32);
+    packed.fill(Qt::black);
+    QPainter painter(&packed);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (size_t i = 0; i < pngs.size(); ++i) {
+        QImage view = QImage::fromData(reinterpret_cast<const uchar*>(pngs[i].data()), static_cast<int>(pngs[i].size()));
+        if (view.isNull()) {
+            qDebug() << "[ThumbnailRenderer::packAtlas] View" << i << "does not decode";
+            return atlas;
+        }
+        painter.drawImage(QRect(static_cast<int>(i) * tileSize, 0, tileSize, tileSize), view);
+    }
+    painter.end();
+
+    const std::string format = compactFormat();
+    if (!encodeCompact(packed, format, atlas.data)) {
+        qDebug() << "[ThumbnailRenderer::packAtlas] Encoding the atlas failed";
+        return atlas;
+    }
+    atlas.size = tileSize;
+    atlas.format = format;
+    return atlas;
+}
@@ -0,0 +1,117 @@
+#ifndef THUMBNAILRENDERER_H
+#define THUMBNAILRENDERER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GeometryMetrics.h"
+
+class RenderSession;
+struct db_i;
+
+struct ThumbnailOptions {
+    int size = 512;         // square image edge in pixels
+    int hypersample = 0;    // extra jittered rays per pixel, as rt -H
+    bool shaded = true;     // lambert lighting; false gives flat region colors
+    double azimuth = 35.0;  // view direction in degrees, rt's defaults
+    double elevation = 25.0;
+};
+
+// One encoded size of a model's preview
+struct ThumbnailImage {
+    int size = 0;           // edge length in pixels
+    std::string format;     // "webp" or "png"
+    std::vector<char> data;
+};
+
+/**
+ * @brief Raytraces a preview image inside the process through librt
+ *
+ * Replaces spawning rt for every model: a RenderSession preps the
+ * geometry, traces the image on the given number of threads and encodes
+ * it to PNG in memory. The view is orthographic, fitted to the model's
+ * bounding box, from the options' azimuth and elevation. renderFileViews
+ * shoots a whole view set from one prep; packAtlas puts such a set into
+ * one image, tiles left to right, for cards and the model view to page
+ * through. Given metrics, they also ray-sample the model's extent,
+ * volume and surface area on the session that traced the views, so the
+ * geometry is prepped once for both.
+ *
+ * Usage example:
+ *
+ * ThumbnailRenderer renderer;
+ * std::vector<char> png;
+ * if (renderer.renderFile("/lib/truck.g", "all", ThumbnailOptions(), png)) { ... }
+ */
+class ThumbnailRenderer {
+public:
+    explicit ThumbnailRenderer(int threads = 1);
+
+    // dbip must already have its directory built; it is not closed
+    bool render(struct db_i* dbip, const std::string& objectName, const ThumbnailOptions& options,
+                std::vector<char>& png, int timeLimitMs = 0);
+
+    /*
+     * Opens filePath read-only for the duration of the render. With
+     * metrics, a successful render goes on to RenderSession::measure
+     * within measureLimitMs; a failed measurement leaves metrics unsampled
+     * and the render successful. Measuring is not part of timeLimitMs.
+     */
+    bool renderFile(const std::string& filePath, const std::string& objectName,
+                    const ThumbnailOptions& options, std::vector<char>& png, int timeLimitMs = 0,
+                    GeometryMetrics* metrics = nullptr, int measureLimitMs = 0);
+
+    // One PNG per view, all from a single prep; all or nothing
+    bool renderFileViews(const std::string& filePath, const std::string& objectName,
+                         const std::vector<ThumbnailOptions>& views, std::vector<std::vector<char>>& pngs,
+                         int timeLimitMs = 0, GeometryMetrics* metrics = nullptr, int measureLimitMs = 0);
+
+    // Measures without rendering, for a preview that came from the cache
+    bool measureFile(const std::string& filePath, const std::string& objectName, GeometryMetrics& metrics,
+                     int measureLimitMs = 0);
+
+    // Time the last measurement took, so callers can leave it out of render times
+    int64_t measureMs() const { return lastMeasureMs; }
+
+    // Fixed sizes stored per model: list cards, hi-dpi cards, detail view
+    static const std::vector<int>& mipmapSizes();
+
+    // WebP when the Qt image plugin is available, PNG otherwise
+    static std::string compactFormat();
+
+    /*
+     * Downscales a rendered PNG to every mipmap size not larger than the
+     * image and encodes each in the compact format. An image smaller than
+     * every size is kept at its own size.
+     */
+    static std::vector<ThumbnailImage> mipmaps(const std::vector<char>& png);
+
+    /*
+     * The "multiViewPreviews" set: options' own view first, then front,
+     * side and top (mged's ae 0 0, ae 90 0 and a view straight down),
+     * with the same size and sampling.
+     */
+    static std::vector<ThumbnailOptions> viewSet(const ThumbnailOptions& options);
+
+    // Edge of one view in an atlas; about what the model view shows
+    static const int ATLAS_TILE_SIZE = 256;
+
+    /*
+     * Scales every image to tileSize and packs them left to right into one
+     * image in the compact format, so the view count is width / height.
+     * size is the tile edge; empty data when any image does not decode.
+     */
+    static ThumbnailImage packAtlas(const std::vector<std::vector<char>>& pngs, int tileSize = ATLAS_TILE_SIZE);
+
+private:
+    // Shoots from a prepped session with what is left of timeLimitMs
+    bool shootWithin(RenderSession& session, const std::string& objectName,
+                     const std::vector<ThumbnailOptions>& views, std::vector<std::vector<char>>& pngs,
+                     int timeLimitMs, int64_t elapsedMs);
+
+    int threads;
+    int64_t lastMeasureMs = 0;
+};
+
+#endif // THUMBNAILRENDERER_H
@@ -0,0 +1,571 @@
+#include "WorkerProcess.h"
+#include "BackgroundMode.h"
+#include "MemoryBudget.h"
+#include "RenderCostModel.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QSettings>
+#include <QtEndian>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char* const WORKER_FLAG = "--process-worker";
+const char* const MEMORY_FLAG = "--memory-limit-mb";
+
+// Anything larger is a corrupt length prefix, not a result
+const quint32 MAX_FRAME = 1u << 30;
+const QDataStream::Version STREAM_VERSION = QDataStream::Qt_6_0;
+
+enum JobType : quint8 { ExtractJob = 1, RenderJob = 2 };
+
+void putString(QDataStream& out, const std::string& value)
+{
+    out << QByteArray::fromStdString(value);
+}
+
+std::string getString(QDataStream& in)
+{
+    QByteArray value;
+    in >> value;
+    return value.toStdString();
+}
+
+void putBytes(QDataStream& out, const std::vector<char>& value)
+{
+    out << QByteArray(value.data(), static_cast<qsizetype>(value.size()));
+}
+
+std::vector<char> getBytes(QDataStream& in)
+{
+    QByteArray value;
+    in >> value;
+    return std::vector<char>(value.begin(), value.end());
+}
+
+// Only what extract and render read
+void putModel(QDataStream& out, const ModelData& modelData)
+{
+    out << qint32(modelData.id);
+    putString(out, modelData.short_name);
+    putString(out, modelData.file_path);
+    putString(out, modelData.title);
+    putString(out, modelData.content_hash);
+    out << qint64(modelData.render_ms) << qint32(modelData.render_error) << qint32(modelData.failure_count);
+}
+
+ModelData getModel(QDataStream& in)
+{
+    ModelData modelData{};
+    qint32 id = 0;
+    in >> id;
+    modelData.id = id;
+    modelData.short_name = getString(in);
+    modelData.file_path = getString(in);
+    modelData.title = getString(in);
+    modelData.content_hash = getString(in);
+    qint64 renderMs = 0;
+    qint32 renderError = 0, failures = 0;
+    in >> renderMs >> renderError >> failures;
+    modelData.render_ms = renderMs;
+    modelData.render_error = renderError;
+    modelData.failure_count = failures;
+    return modelData;
+}
+
+void putTime(QDataStream& out, const StageTime& time)
+{
+    out << qint64(time.wallUs) << qint64(time.cpuUs);
+}
+
+StageTime getTime(QDataStream& in)
+{
+    StageTime time;
+    qint64 wallUs = 0, cpuUs = 0;
+    in >> wallUs >> cpuUs;
+    time.wallUs = wallUs;
+    time.cpuUs = cpuUs;
+    return time;
+}
+
+void putMetrics(QDataStream& out, const GeometryMetrics& metrics)
+{
+    out << qint32(metrics.primitive_count) << qint32(metrics.region_count)
+        << qint32(metrics.comb_count) << qint32(metrics.tree_depth);
+    out << quint32(metrics.primitive_types.size());
+    for (const auto& type : metrics.primitive_types) {
+        putString(out, type.first);
+        out << qint32(type.second);
+    }
+    out << metrics.sampled;
+    for (int axis = 0; axis < 3; ++axis) {
+        out << metrics.bbox_min[axis] << metrics.bbox_max[axis];
+    }
+    out << metrics.volume << metrics.volume_error << metrics.surface_area << metrics.surface_area_error;
+}
+
+GeometryMetrics getMetrics(QDataStream& in)
+{
+    GeometryMetrics metrics;
+    qint32 primitives = -1, regions = -1, combs = -1, depth = -1;
+    in >> primitives >> regions >> combs >> depth;
+    metrics.primitive_count = primitives;
+    metrics.region_count = regions;
+    metrics.comb_count = combs;
+    metrics.tree_depth = depth;
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        std::string type = getString(in);
+        qint32 typeCount = 0;
+        in >> typeCount;
+        metrics.primitive_types[type] = typeCount;
+    }
+    in >> metrics.sampled;
+    for (int axis = 0; axis < 3; ++axis) {
+        in >> metrics.bbox_min[axis] >> metrics.bbox_max[axis];
+    }
+    in >> metrics.volume >> metrics.volume_error >> metrics.surface_area >> metrics.surface_area_error;
+    return metrics;
+}
+
+void putExtraction(QDataStream& out, const ExtractionResult& extraction)
+{
+    out << extraction.ok;
+    putString(out, extraction.modelData.title);
+    putString(out, extraction.thumbnailObject);
+    out << quint32(extraction.objects.size());
+    for (const auto& object : extraction.objects) {
+        out << qint32(object.object_id) << qint32(object.model_id) << qint32(object.parent_object_id)
+            << object.is_selected;
+        putString(out, object.name);
+        putString(out, object.structure_hash);
+    }
+    putMetrics(out, extraction.metrics);
+    putTime(out, extraction.openTime);
+    putTime(out, extraction.extractTime);
+    out << qint64(extraction.peakRss);
+}
+
+void getExtraction(QDataStream& in, ExtractionResult& extraction)
+{
+    in >> extraction.ok;
+    extraction.modelData.title = getString(in);
+    extraction.thumbnailObject = getString(in);
+    quint32 count = 0;
+    in >> count;
+    extraction.objects.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ObjectData object{};
+        qint32 objectId = 0, modelId = 0, parentId = 0;
+        in >> objectId >> modelId >> parentId >> object.is_selected;
+        object.object_id = objectId;
+        object.model_id = modelId;
+        object.parent_object_id = parentId;
+        object.name = getString(in);
+        object.structure_hash = getString(in);
+        extraction.objects.push_back(std::move(object));
+    }
+    extraction.metrics = getMetrics(in);
+    extraction.openTime = getTime(in);
+    extraction.extractTime = getTime(in);
+    qint64 peakRss = 0;
+    in >> peakRss;
+    extraction.peakRss = peakRss;
+}
+
+void putImage(QDataStream& out, const ThumbnailImage& image)
+{
+    out << qint32(image.size);
+    putString(out, image.format);
+    putBytes(out, image.data);
+}
+
+ThumbnailImage getImage(QDataStream& in)
+{
+    ThumbnailImage image;
+    qint32 size = 0;
+    in >> size;
+    image.size = size;
+    image.format = getString(in);
+    image.data = getBytes(in);
+    return image;
+}
+
+void putRender(QDataStream& out, const RenderResult& render)
+{
+    out << render.ok << render.coarse << qint32(render.error) << qint64(render.renderMs);
+    putBytes(out, render.thumbnail);
+    out << quint32(render.sizes.size());
+    for (const auto& image : render.sizes) {
+        putImage(out, image);
+    }
+    putImage(out, render.viewAtlas);
+    putMetrics(out, render.metrics);
+    putTime(out, render.renderTime);
+    out << qint64(render.peakRss);
+}
+
+void getRender(QDataStream& in, RenderResult& render)
+{
+    qint32 error = StageOk;
+    qint64 renderMs = 0;
+    in >> render.ok >> render.coarse >> error >> renderMs;
+    render.error = error;
+    render.renderMs = renderMs;
+    render.thumbnail = getBytes(in);
+    quint32 count = 0;
+    in >> count;
+    render.sizes.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        render.sizes.push_back(getImage(in));
+    }
+    render.viewAtlas = getImage(in);
+    render.metrics = getMetrics(in);
+    render.renderTime = getTime(in);
+    qint64 peakRss = 0;
+    in >> peakRss;
+    render.peakRss = peakRss;
+}
+
+int stageError(WorkerProcess::Status status)
+{
+    switch (status) {
+    case WorkerProcess::Crashed:
+        return StageCrashed;
+    case WorkerProcess::TimedOut:
+        return StageTimedOut;
+    default:
+        return StageFailed;
+    }
+}
+
+// Helper side of the pipe: blocking stdio, no event loop
+bool readFrame(FILE* in, QByteArray& payload)
+{
+    uchar header[4];
+    if (std::fread(header, 1, sizeof(header), in) != sizeof(header)) {
+        return false;
+    }
+    quint32 size = qFromBigEndian<quint32>(header);
+    if (size > MAX_FRAME) {
+        return false;
+    }
+    payload.resize(static_cast<qsizetype>(size));
+    return std::fread(payload.data(), 1, size, in) == size;
+}
+
+bool writeFrame(FILE* out, const QByteArray& payload)
+{
+    uchar header[4];
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size()), header);
+    const size_t size = static_cast<size_t>(payload.size());
+    return std::fwrite(header, 1, sizeof(header), out) == sizeof(header)
+        && std::fwrite(payload.constData(), 1, size, out) == size
+        && std::fflush(out) == 0;
+}
+
+QByteArray handle(ProcessGFiles& processor, const QByteArray& request)
+{
+    QDataStream in(request);
+    in.setVersion(STREAM_VERSION);
+    quint8 type = 0;
+    in >> type;
+    ModelData modelData = getModel(in);
+
+    QByteArray response;
+    QDataStream out(&response, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+
+    // One job at a time here, so the process peak is the job's own
+    MemoryBudget::resetPeakRss();
+    if (type == ExtractJob) {
+        ExtractionResult extraction = processor.extract(modelData);
+        extraction.peakRss = MemoryBudget::peakRss();
+        putExtraction(out, extraction);
+    }
+    else if (type == RenderJob) {
+        ExtractionResult extraction;
+        extraction.modelData = modelData;
+        extraction.thumbnailObject = getString(in);
+        extraction.ok = true;
+        bool coarse = false;
+        in >> coarse >> extraction.renderCost;
+        RenderResult render = processor.render(extraction, coarse);
+        render.peakRss = MemoryBudget::peakRss();
+        putRender(out, render);
+    }
+    return response;
+}
+
+}
+
+WorkerProcess::WorkerProcess(int timeoutMs, int memoryLimitMb)
+    : timeoutMs(timeoutMs), memoryLimitMb(memoryLimitMb)
+{
+    QSettings settings;
+    if (this->timeoutMs < 0) {
+        this->timeoutMs = settings.value("workerTimeoutSec", 120).toInt() * 1000;
+    }
+    if (this->memoryLimitMb < 0) {
+        this->memoryLimitMb = settings.value("workerMemoryMB", 2048).toInt();
+    }
+}
+
+WorkerProcess::~WorkerProcess()
+{
+    if (!process) {
+        return;
+    }
+    // End of input lets the helper exit on its own
+    process->closeWriteChannel();
+    if (!process->waitForFinished(1000)) {
+        discard();
+    }
+}
+
+bool WorkerProcess::enabled()
+{
+    QSettings settings;
+    return settings.value("isolatedWorkers", false).toBool();
+}
+
+bool WorkerProcess::isWorkerCommandLine(int argc, char** argv)
+{
+    return argc > 1 && std::strcmp(argv[1], WORKER_FLAG) == 0;
+}
+
+bool WorkerProcess::ensureStarted()
+{
+    if (process && process->state() == QProcess::Running) {
+        return true;
+    }
+    discard();
+
+    process = std::make_unique<QProcess>();
+    process->setProgram(QCoreApplication::applicationFilePath());
+    process->setArguments({ WORKER_FLAG, MEMORY_FLAG, QString::number(memoryLimitMb) });
+    // Helper logging goes straight to our stderr; stdout carries results only
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    BackgroundMode::prepareChild(*process);
+    process->start();
+    if (!process->waitForStarted()) {
+        qDebug() << "[WorkerProcess::ensureStarted] Could not start helper:" << process->errorString();
+        process.reset();
+        return false;
+    }
+    tracked = std::make_unique<TrackedChild>(process->processId());
+
+    if (startCount++ > 0) {
+        restartCount++;
+        qDebug() << "[WorkerProcess::ensureStarted] Restarted helper, restart" << restartCount;
+    }
+    return true;
+}
+
+void WorkerProcess::discard()
+{
+    if (!process) {
+        return;
+    }
+    if (process->state() != QProcess::NotRunning) {
+        process->kill();
+        process->waitForFinished();
+    }
+    tracked.reset();
+    process.reset();
+}
+
+WorkerProcess::Status WorkerProcess::call(const QByteArray& request, QByteArray& response, int deadlineMs)
+{
+    if (!ensureStarted()) {
+        return Failed;
+    }
+
+    QByteArray frame(4, '\0');
+    qToBigEndian<quint32>(static_cast<quint32>(request.size()), frame.data());
+    frame.append(request);
+    process->write(frame);
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray buffer;
+    quint32 expected = 0;
+    bool haveHeader = false;
+
+    while (true) {
+        buffer.append(process->readAllStandardOutput());
+        if (!haveHeader && buffer.size() >= 4) {
+            expected = qFromBigEndian<quint32>(buffer.constData());
+            haveHeader = true;
+            if (expected > MAX_FRAME) {
+                qDebug() << "[WorkerProcess::call] Malformed result from helper";
+                discard();
+                return Failed;
+            }
+        }
+        if (haveHeader && buffer.size() >= 4 + static_cast<qsizetype>(expected)) {
+            break;
+        }
+
+        qint64 remainingMs = deadlineMs - timer.elapsed();
+        if (remainingMs <= 0) {
+            qDebug() << "[WorkerProcess::call] Helper timed out after" << deadlineMs / 1000 << "seconds";
+            discard();
+            return TimedOut;
+        }
+        if (!process->waitForReadyRead(static_cast<int>(remainingMs)) && process->state() == QProcess::NotRunning) {
+            buffer.append(process->readAllStandardOutput());
+            if (haveHeader && buffer.size() >= 4 + static_cast<qsizetype>(expected)) {
+                break;
+            }
+            qDebug() << "[WorkerProcess::call] Helper died, exit status" << process->exitStatus()
+                << "code" << process->exitCode();
+            discard();
+            return Crashed;
+        }
+    }
+
+    response = buffer.mid(4, static_cast<qsizetype>(expected));
+    return Done;
+}
+
+WorkerProcess::Status WorkerProcess::extract(const ModelData& modelData, ExtractionResult& extraction)
+{
+    extraction = ExtractionResult();
+    extraction.modelData = modelData;
+
+    QByteArray request;
+    QDataStream out(&request, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    out << quint8(ExtractJob);
+    putModel(out, modelData);
+
+    QByteArray response;
+    Status status = call(request, response, timeoutMs);
+    if (status != Done) {
+        extraction.error = stageError(status);
+        return status;
+    }
+
+    QDataStream in(response);
+    in.setVersion(STREAM_VERSION);
+    getExtraction(in, extraction);
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "[WorkerProcess::extract] Malformed result for model ID:" << modelData.id;
+        extraction.ok = false;
+        extraction.error = StageFailed;
+        extraction.objects.clear();
+        return Failed;
+    }
+    return Done;
+}
+
+WorkerProcess::Status WorkerProcess::render(const ExtractionResult& extraction, bool coarse, RenderResult& render)
+{
+    render = RenderResult();
+    render.modelId = extraction.modelData.id;
+    render.coarse = coarse;
+
+    QByteArray request;
+    QDataStream out(&request, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    out << quint8(RenderJob);
+    putModel(out, extraction.modelData);
+    putString(out, extraction.thumbnailObject);
+    out << coarse << extraction.renderCost;
+
+    // The helper keeps to the render's own time limit; only past that and
+    // the usual allowance does it count as hung
+    const int renderLimitMs = RenderCostModel::timeLimitMs(extraction.modelData, extraction.renderCost, coarse);
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray response;
+    Status status = call(request, response, timeoutMs + renderLimitMs);
+    if (status != Done) {
+        render.error = stageError(status);
+        if (status == TimedOut) {
+            render.renderMs = timer.elapsed();
+        }
+        return status;
+    }
+
+    QDataStream in(response);
+    in.setVersion(STREAM_VERSION);
+    getRender(in, render);
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "[WorkerProcess::render] Malformed result for model ID:" << render.modelId;
+        render.ok = false;
+        render.error = StageFailed;
+        render.thumbnail.clear();
+        render.sizes.clear();
+        render.viewAtlas = ThumbnailImage();
+        return Failed;
+    }
+    return Done;
+}
+
+int WorkerProcess::serve(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    // Same settings and cache locations as the application
+    QCoreApplication::setOrganizationName("BRL-CAD");
+    QCoreApplication::setOrganizationDomain("brlcad.org");
+    QCoreApplication::setApplicationName("CADventory");
+
+    long memoryLimitMb = 0;
+    for (int i = 2; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], MEMORY_FLAG) == 0) {
+            memoryLimitMb = std::strtol(argv[i + 1], nullptr, 10);
+        }
+    }
+
+    // librt and libged may print to stdout; it is kept for the results only
+#ifdef _WIN32
+    // No memory limit here; that would take a job object
+    _setmode(_fileno(stdin), _O_BINARY);
+    int protocolFd = _dup(_fileno(stdout));
+    _dup2(_fileno(stderr), _fileno(stdout));
+    _setmode(protocolFd, _O_BINARY);
+    FILE* out = _fdopen(protocolFd, "wb");
+#else
+    if (memoryLimitMb > 0) {
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(memoryLimitMb) * 1024 * 1024;
+        if (setrlimit(RLIMIT_AS, &limit) != 0) {
+            qDebug() << "[WorkerProcess::serve] Could not limit memory to" << memoryLimitMb << "MB";
+        }
+    }
+    int protocolFd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    FILE* out = fdopen(protocolFd, "wb");
+#endif
+    if (!out) {
+        return 1;
+    }
+
+    ProcessGFiles processor(nullptr, 0);
+    QByteArray request;
+    while (readFrame(stdin, request)) {
+        if (!writeFrame(out, handle(processor, request))) {
+            break;
+        }
+    }
+    std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef WORKERPROCESS_H
+#define WORKERPROCESS_H
+
+#include <memory>
+
+#include "ProcessGFiles.h"
+
+class QByteArray;
+class QProcess;
+class TrackedChild;
+
+/**
+ * @brief Runs ProcessGFiles in a helper process, so a bad .g file cannot
+ * take CADventory down with it
+ *
+ * The helper is this executable started with --process-worker. Jobs and
+ * results travel over its stdin/stdout as length-prefixed QDataStream
+ * frames. Every job has a time limit and the helper runs under an
+ * address-space limit; a helper that crashes, runs out of memory or
+ * overruns is killed and a fresh one is started for the next job.
+ *
+ * The indexer gives each of its pipeline threads one WorkerProcess, so
+ * the helpers form a pool that scales with the "indexingThreads" and
+ * "renderThreads" settings. It is used when the "isolatedWorkers"
+ * setting is on.
+ *
+ * Usage example:
+ *
+ * WorkerProcess helper;
+ * ExtractionResult extraction;
+ * helper.extract(modelData, extraction);   // extraction.error tells a crash
+ * processor.persistExtraction(extraction);
+ */
+class WorkerProcess {
+public:
+    enum Status {
+        Done,       // the helper answered; the result may still be not ok
+        Failed,     // the helper could not be started
+        Crashed,
+        TimedOut
+    };
+
+    // Negative values read the "workerTimeoutSec" and "workerMemoryMB"
+    // settings. Renders get their RenderCostModel time limit on top.
+    explicit WorkerProcess(int timeoutMs = -1, int memoryLimitMb = -1);
+    ~WorkerProcess();
+    WorkerProcess(const WorkerProcess&) = delete;
+    WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+    Status extract(const ModelData& modelData, ExtractionResult& extraction);
+    Status render(const ExtractionResult& extraction, bool coarse, RenderResult& render);
+
+    // Helpers started after the first one died
+    int restarts() const { return restartCount; }
+
+    // "isolatedWorkers" setting
+    static bool enabled();
+
+    // main(): is this process a helper, and its loop if so
+    static bool isWorkerCommandLine(int argc, char** argv);
+    static int serve(int argc, char** argv);
+
+private:
+    bool ensureStarted();
+    Status call(const QByteArray& request, QByteArray& response, int deadlineMs);
+    void discard();
+
+    std::unique_ptr<QProcess> process;
+    std::unique_ptr<TrackedChild> tracked;
+    int timeoutMs;
+    int memoryLimitMb;
+    int startCount = 0;
+    int restartCount = 0;
+};
+
+#endif // WORKERPROCESS_H
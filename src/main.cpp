@@ -1,4 +1,6 @@
+#include "BackgroundMode.h"
 #include "CADventory.h"
+#include "WorkerProcess.h"
 
 #include <QDir>
 #include <QTimer>
@@ -95,8 +97,15 @@ main(int argc, char **argv)
 #endif
   // Install the custom message handler
   qInstallMessageHandler(myMessageHandler);
+
+  // Crash-isolated indexing helper started by WorkerProcess; no GUI
+  if (WorkerProcess::isWorkerCommandLine(argc, argv)) {
+    return WorkerProcess::serve(argc, argv);
+  }
   
   CADventory app(argc, argv);
+  // Background mode throttles indexing while the user is at work
+  BackgroundMode::installInputWatcher(&app);
   app.showSplash();
 
   QTimer::singleShot(250, [&app]() {
@@ -0,0 +1,100 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "BackgroundMode.h"
+
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+
+static BackgroundMode::Sample sampleOf(double othersLoad, int64_t idleMs) {
+  BackgroundMode::Sample sample;
+  sample.othersLoad = othersLoad;
+  sample.idleMs = idleMs;
+  return sample;
+}
+
+
+TEST_CASE("BackgroundMode: Throttles On Load With Hysteresis", "[BackgroundMode]") {
+  BackgroundMode mode(0.5, 60);
+  REQUIRE_FALSE(mode.throttled());
+
+  REQUIRE_FALSE(mode.update(sampleOf(0.3, -1)));
+  REQUIRE(mode.update(sampleOf(0.7, -1)));
+
+  // Below the threshold is not yet calm enough
+  REQUIRE(mode.update(sampleOf(0.4, -1)));
+  REQUIRE_FALSE(mode.update(sampleOf(0.2, -1)));
+
+  // Unknown load never throttles
+  REQUIRE_FALSE(mode.update(sampleOf(-1.0, -1)));
+}
+
+
+TEST_CASE("BackgroundMode: Throttles While The User Is Active", "[BackgroundMode]") {
+  BackgroundMode mode(0.5, 60);
+  REQUIRE(mode.update(sampleOf(0.0, 1000)));
+  REQUIRE(mode.update(sampleOf(0.0, 59000)));
+  REQUIRE_FALSE(mode.update(sampleOf(0.0, 61000)));
+
+  // Idle input does not lift a throttle the load holds
+  REQUIRE(mode.update(sampleOf(0.9, 61000)));
+  REQUIRE(mode.update(sampleOf(0.3, 120000)));
+}
+
+
+TEST_CASE("BackgroundMode: The First Worker Never Waits", "[BackgroundMode]") {
+  BackgroundMode mode(0.5, 60);
+  REQUIRE(mode.update(sampleOf(1.0, 0)));
+
+  REQUIRE(mode.waitForTurn(0));
+  REQUIRE_FALSE(mode.waitForTurn(0, []() { return true; }));
+
+  // Throttled: the others wait until cancelled
+  int polls = 0;
+  REQUIRE_FALSE(mode.waitForTurn(1, [&polls]() { return ++polls > 2; }));
+  REQUIRE(polls == 3);
+
+  // Samples from update() stand for a whole interval
+  REQUIRE_FALSE(mode.update(sampleOf(0.0, -1)));
+  REQUIRE(mode.waitForTurn(1));
+}
+
+
+TEST_CASE("BackgroundMode: Lowers Only The Calling Thread", "[BackgroundMode]") {
+  REQUIRE_FALSE(BackgroundMode::currentThreadLowered());
+#ifdef __linux__
+  const int mainNiceness = getpriority(PRIO_PROCESS, 0);
+#endif
+
+  bool lowered = false;
+  int niceness = 0;
+  int policy = -1;
+  std::thread worker([&]() {
+    BackgroundMode::lowerCurrentThread();
+    lowered = BackgroundMode::currentThreadLowered();
+#ifdef __linux__
+    niceness = getpriority(PRIO_PROCESS, 0);
+    policy = sched_getscheduler(0);
+#endif
+  });
+  worker.join();
+
+  REQUIRE(lowered);
+  REQUIRE_FALSE(BackgroundMode::currentThreadLowered());
+#ifdef __linux__
+  REQUIRE(niceness == 19);
+  // Still scheduled normally, so it cannot starve holding a lock
+  REQUIRE(policy == SCHED_OTHER);
+  REQUIRE(getpriority(PRIO_PROCESS, 0) == mainNiceness);
+#else
+  (void)niceness;
+  (void)policy;
+#endif
+}
@@ -0,0 +1,83 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "BoundedQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("BoundedQueue: FIFO Order And Close", "[BoundedQueue]") {
+  BoundedQueue<int> queue(4);
+  REQUIRE(queue.push(1));
+  REQUIRE(queue.push(2));
+  REQUIRE(queue.size() == 2);
+
+  queue.close();
+  REQUIRE_FALSE(queue.push(3));
+
+  // Items queued before close are still delivered
+  int value = 0;
+  REQUIRE(queue.pop(value));
+  REQUIRE(value == 1);
+  REQUIRE(queue.pop(value));
+  REQUIRE(value == 2);
+  REQUIRE_FALSE(queue.pop(value));
+}
+
+
+TEST_CASE("BoundedQueue: Producer Blocks At Capacity", "[BoundedQueue]") {
+  BoundedQueue<int> queue(2);
+  std::atomic<int> pushed(0);
+
+  std::thread producer([&] {
+    for (int i = 0; i < 100; ++i) {
+      queue.push(i);
+      pushed++;
+    }
+    queue.close();
+  });
+
+  // Without a consumer the producer stalls once the queue is full
+  while (queue.size() < 2) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  REQUIRE(pushed.load() == 2);
+
+  std::vector<int> received;
+  int value = 0;
+  while (queue.pop(value)) {
+    received.push_back(value);
+  }
+  producer.join();
+
+  REQUIRE(received.size() == 100);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(received[i] == i);
+  }
+}
+
+
+TEST_CASE("BoundedQueue: Timed Pop", "[BoundedQueue]") {
+  BoundedQueue<int> queue(2);
+  int value = 0;
+  bool timedOut = false;
+
+  // Nothing yet: gives up without closing
+  REQUIRE_FALSE(queue.popFor(value, std::chrono::milliseconds(10), timedOut));
+  REQUIRE(timedOut);
+
+  REQUIRE(queue.push(7));
+  REQUIRE(queue.popFor(value, std::chrono::milliseconds(10), timedOut));
+  REQUIRE(value == 7);
+  REQUIRE_FALSE(timedOut);
+
+  queue.close();
+  REQUIRE_FALSE(queue.popFor(value, std::chrono::milliseconds(10), timedOut));
+  REQUIRE_FALSE(timedOut);
+}
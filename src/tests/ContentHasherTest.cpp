@@ -0,0 +1,99 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "ContentHasher.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+
+class ContentHasherFixture {
+public:
+  std::filesystem::path testDir;
+
+  ContentHasherFixture() {
+    testDir = std::filesystem::temp_directory_path() / "ContentHasherTest";
+    std::filesystem::create_directories(testDir);
+    std::ofstream(testDir / "empty.g");
+    std::ofstream(testDir / "abc.g") << "abc";
+
+    /* large enough to cross several 32-byte stripes */
+    std::ofstream big(testDir / "big.g", std::ios::binary);
+    for (int i = 0; i < 100000; ++i) {
+      big.put(static_cast<char>(i * 7));
+    }
+  }
+
+  ~ContentHasherFixture() {
+    std::filesystem::remove_all(testDir);
+  }
+};
+
+
+TEST_CASE("MatchesReferenceVectors", "[ContentHasher]") {
+  ContentHasher empty;
+  REQUIRE(ContentHasher::toHex(empty.digest()) == "ef46db3751d8e999");
+
+  ContentHasher abc;
+  abc.update("abc", 3);
+  REQUIRE(ContentHasher::toHex(abc.digest()) == "44bc2cf5ad770999");
+
+  const char* sentence = "Nobody inspects the spammish repetition";
+  ContentHasher longer;
+  longer.update(sentence, std::strlen(sentence));
+  REQUIRE(ContentHasher::toHex(longer.digest()) == "fbcea83c8a378bf1");
+}
+
+
+TEST_CASE("StreamingMatchesOneShot", "[ContentHasher]") {
+  std::string data(1000, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 13);
+  }
+
+  ContentHasher oneShot;
+  oneShot.update(data.data(), data.size());
+
+  ContentHasher pieces;
+  pieces.update(data.data(), 13);
+  pieces.update(data.data() + 13, 500);
+  pieces.update(data.data() + 513, 487);
+
+  REQUIRE(oneShot.digest() == pieces.digest());
+}
+
+
+TEST_CASE_METHOD(ContentHasherFixture, "HashesFilesOnDisk", "[ContentHasher]") {
+  uint64_t digest = 0;
+  REQUIRE(ContentHasher::hashFile((testDir / "abc.g").string(), digest));
+  REQUIRE(ContentHasher::toHex(digest) == "44bc2cf5ad770999");
+
+  REQUIRE(ContentHasher::hashFile((testDir / "empty.g").string(), digest));
+  REQUIRE(ContentHasher::toHex(digest) == "ef46db3751d8e999");
+
+  REQUIRE_FALSE(ContentHasher::hashFile((testDir / "missing.g").string(), digest));
+}
+
+
+TEST_CASE_METHOD(ContentHasherFixture, "FingerprintsBatchInOrder", "[ContentHasher]") {
+  std::vector<std::string> paths = {
+    (testDir / "big.g").string(),
+    (testDir / "missing.g").string(),
+    (testDir / "abc.g").string()
+  };
+
+  std::vector<FileFingerprint> prints = ContentHasher::fingerprintFiles(paths);
+  REQUIRE(prints.size() == 3);
+
+  REQUIRE(prints[0].valid());
+  REQUIRE(prints[0].size == 100000);
+  REQUIRE(prints[0].file_path == paths[0]);
+
+  REQUIRE_FALSE(prints[1].valid());
+
+  REQUIRE(prints[2].valid());
+  REQUIRE(prints[2].content_hash == "44bc2cf5ad770999");
+  REQUIRE(prints[2].size == 3);
+}
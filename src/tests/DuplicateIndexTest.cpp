@@ -0,0 +1,95 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "DuplicateIndex.h"
+#include "Model.h"
+
+#include <filesystem>
+
+
+class DuplicateIndexFixture {
+public:
+  std::filesystem::path rootDir;
+  Model* first;
+  Model* second;
+
+  DuplicateIndexFixture() {
+    rootDir = std::filesystem::temp_directory_path() / "DuplicateIndexTest";
+    std::filesystem::remove_all(rootDir);
+    std::filesystem::create_directories(rootDir / "first");
+    std::filesystem::create_directories(rootDir / "second");
+
+    first = new Model((rootDir / "first").string());
+    second = new Model((rootDir / "second").string());
+  }
+
+  ~DuplicateIndexFixture() {
+    delete first;
+    delete second;
+    std::filesystem::remove_all(rootDir);
+  }
+
+  int addModel(Model* model, const std::string& name, const std::string& hash) {
+    ModelData modelData = {0, name, "", "", "", {}, "", "/lib/" + name, "", false, true, true, {}};
+    REQUIRE(model->insertModel(modelData));
+    int id = model->getModelByFilePath(modelData.file_path).id;
+
+    FileFingerprint fp;
+    fp.file_path = modelData.file_path;
+    fp.content_hash = hash;
+    REQUIRE(model->updateFingerprint(id, fp));
+    return id;
+  }
+};
+
+
+TEST_CASE_METHOD(DuplicateIndexFixture, "ClustersIdenticalFilesAcrossLibraries", "[DuplicateIndex]") {
+  addModel(first, "truck.g", "00000000000000aa");
+  addModel(first, "tank.g", "00000000000000bb");
+  addModel(second, "truck_copy.g", "00000000000000aa");
+
+  DuplicateIndex index;
+  index.addCatalog("first", first);
+  index.addCatalog("second", second);
+
+  std::vector<DuplicateCluster> clusters = index.fileClusters();
+  REQUIRE(clusters.size() == 1);
+  REQUIRE(clusters[0].kind == DuplicateCluster::File);
+  REQUIRE(clusters[0].hash == "00000000000000aa");
+  REQUIRE(clusters[0].members.size() == 2);
+  REQUIRE(clusters[0].members[0].library_name == "first");
+  REQUIRE(clusters[0].members[1].file_path == "/lib/truck_copy.g");
+}
+
+
+TEST_CASE_METHOD(DuplicateIndexFixture, "ClustersIdenticalAssembliesUnderDifferentNames", "[DuplicateIndex]") {
+  int truck = addModel(first, "truck.g", "00000000000000aa");
+  int jeep = addModel(second, "jeep.g", "00000000000000cc");
+
+  ObjectData wheel = {0, truck, "wheel.c", -1, false, "1111111111111111"};
+  ObjectData tire = {0, jeep, "tire_assy", -1, false, "1111111111111111"};
+  ObjectData body = {0, jeep, "body.c", -1, false, "2222222222222222"};
+  REQUIRE(first->insertObject(wheel) > 0);
+  REQUIRE(second->insertObject(tire) > 0);
+  REQUIRE(second->insertObject(body) > 0);
+
+  // Same comb referenced twice in one file counts once
+  REQUIRE(first->insertObject(wheel) > 0);
+
+  DuplicateIndex index;
+  index.addCatalog("first", first);
+  index.addCatalog("second", second);
+
+  std::vector<DuplicateCluster> clusters = index.assemblyClusters();
+  REQUIRE(clusters.size() == 1);
+  REQUIRE(clusters[0].kind == DuplicateCluster::Assembly);
+  REQUIRE(clusters[0].members.size() == 2);
+  REQUIRE(clusters[0].members[0].object_name == "wheel.c");
+  REQUIRE(clusters[0].members[1].object_name == "tire_assy");
+  REQUIRE(clusters[0].members[1].file_path == "/lib/jeep.g");
+
+  REQUIRE(index.fileClusters().empty());
+  REQUIRE(index.allClusters().size() == 1);
+}
@@ -0,0 +1,150 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "GFileProbe.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/* builds v5 database images the way librt lays them out */
+class GFileProbeFixture {
+public:
+  std::filesystem::path testDir;
+
+  GFileProbeFixture() {
+    testDir = std::filesystem::temp_directory_path() / "GFileProbeTest";
+    std::filesystem::create_directories(testDir);
+  }
+
+  ~GFileProbeFixture() {
+    std::filesystem::remove_all(testDir);
+  }
+
+  static std::vector<unsigned char> header() {
+    return {0x76, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x35};
+  }
+
+  /* one-byte lengths; the object is padded to a multiple of 8 bytes */
+  static void addObject(std::vector<unsigned char>& db, const std::string& name,
+                        const std::string& attributes = std::string(),
+                        unsigned char minorType = 0) {
+    std::vector<unsigned char> object = {0x76, 0x20, 0x00, 0x00, 0x01, minorType, 0x00};
+    if (!attributes.empty()) {
+      object[2] = 0x20;
+    }
+    object.push_back(static_cast<unsigned char>(name.size() + 1));
+    object.insert(object.end(), name.begin(), name.end());
+    object.push_back(0);
+    if (!attributes.empty()) {
+      object.push_back(static_cast<unsigned char>(attributes.size()));
+      object.insert(object.end(), attributes.begin(), attributes.end());
+    }
+    size_t total = (object.size() + 1 + 7) / 8 * 8;
+    object.resize(total - 1, 0);
+    object.push_back(0x35);
+    object[6] = static_cast<unsigned char>(total / 8);
+    db.insert(db.end(), object.begin(), object.end());
+  }
+
+  std::string write(const std::string& name, const std::vector<unsigned char>& db) {
+    std::filesystem::path path = testDir / name;
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(db.data()), static_cast<std::streamsize>(db.size()));
+    return path.string();
+  }
+};
+
+
+TEST_CASE("GFileProbe: Reads Title, Units And Object Count", "[GFileProbe]") {
+  std::vector<unsigned char> db = GFileProbeFixture::header();
+  GFileProbeFixture::addObject(db, "_GLOBAL", std::string("title\0Truck\0units\0" "25.4\0", 23) + '\0');
+  GFileProbeFixture::addObject(db, "wheel.s");
+  GFileProbeFixture::addObject(db, "truck.c");
+
+  GFileHeader header = GFileProbe::parse(db.data(), db.size());
+  REQUIRE(header.ok);
+  REQUIRE(header.db_version == 5);
+  REQUIRE(header.title == "Truck");
+  REQUIRE(header.units == "in");
+  REQUIRE(header.object_count == 2);
+}
+
+
+TEST_CASE("GFileProbe: Counts The Primitive Mix", "[GFileProbe]") {
+  std::vector<unsigned char> db = GFileProbeFixture::header();
+  GFileProbeFixture::addObject(db, "_GLOBAL", std::string("title\0Truck\0", 12) + '\0');
+  GFileProbeFixture::addObject(db, "wheel.s", std::string(), 1);   /* torus */
+  GFileProbeFixture::addObject(db, "body.bot", std::string(), 30);
+  GFileProbeFixture::addObject(db, "hull.brep", std::string(), 37);
+  GFileProbeFixture::addObject(db, "wheel.r", std::string(), 31);
+  GFileProbeFixture::addObject(db, "truck.c", std::string(), 31);
+
+  GFileHeader header = GFileProbe::parse(db.data(), db.size());
+  REQUIRE(header.ok);
+  REQUIRE(header.object_count == 5);
+  REQUIRE(header.comb_count == 2);
+  REQUIRE(header.mesh_count == 2);
+  REQUIRE(header.mesh_bytes == 48);
+}
+
+
+TEST_CASE("GFileProbe: Reads v4 Ident Title", "[GFileProbe]") {
+  std::vector<unsigned char> db(128, 0);
+  db[0] = 'I';
+  db[1] = 1;
+  std::string version = "v4";
+  std::copy(version.begin(), version.end(), db.begin() + 2);
+  std::string title = "Old Tank";
+  std::copy(title.begin(), title.end(), db.begin() + 8);
+
+  GFileHeader header = GFileProbe::parse(db.data(), db.size());
+  REQUIRE(header.ok);
+  REQUIRE(header.db_version == 4);
+  REQUIRE(header.title == "Old Tank");
+  REQUIRE(header.object_count == -1);
+}
+
+
+TEST_CASE("GFileProbe: Rejects Damaged Files", "[GFileProbe]") {
+  std::string text = "not a database";
+  GFileHeader notDb = GFileProbe::parse(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+  REQUIRE_FALSE(notDb.ok);
+  REQUIRE(notDb.db_version == 0);
+
+  /* an object cut off halfway */
+  std::vector<unsigned char> db = GFileProbeFixture::header();
+  GFileProbeFixture::addObject(db, "wheel.s");
+  db.resize(db.size() - 4);
+  REQUIRE_FALSE(GFileProbe::parse(db.data(), db.size()).ok);
+}
+
+
+TEST_CASE("GFileProbe: Probes Files In Order", "[GFileProbe]") {
+  GFileProbeFixture fixture;
+
+  std::vector<unsigned char> one = GFileProbeFixture::header();
+  GFileProbeFixture::addObject(one, "a.s");
+  std::vector<unsigned char> three = GFileProbeFixture::header();
+  GFileProbeFixture::addObject(three, "a.s");
+  GFileProbeFixture::addObject(three, "b.s");
+  GFileProbeFixture::addObject(three, "c.r");
+
+  std::vector<std::string> paths = {
+    fixture.write("one.g", one),
+    (fixture.testDir / "missing.g").string(),
+    fixture.write("three.g", three)
+  };
+  std::vector<GFileHeader> headers = GFileProbe::probeFiles(paths);
+
+  REQUIRE(headers.size() == 3);
+  REQUIRE(headers[0].ok);
+  REQUIRE(headers[0].object_count == 1);
+  REQUIRE_FALSE(headers[1].ok);
+  REQUIRE(headers[1].file_path == paths[1]);
+  REQUIRE(headers[2].object_count == 3);
+}
@@ -0,0 +1,211 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "LibraryScanner.h"
+#include "Model.h"
+
+#include <QDir>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+
+class LibraryScannerFixture {
+public:
+  std::filesystem::path libraryDir;
+  Model* model;
+
+  LibraryScannerFixture() {
+    libraryDir = std::filesystem::temp_directory_path() / "LibraryScannerTest";
+    std::filesystem::remove_all(libraryDir);
+    std::filesystem::create_directories(libraryDir / "sub");
+
+    writeFile("a.g", "first model");
+    writeFile("sub/b.g", "second model");
+    writeFile("c.g", "third model");
+
+    model = new Model(libraryDir.string());
+    for (const char* name : {"a.g", "sub/b.g", "c.g"}) {
+      ModelData modelData = {0, name, "", "", "", {}, "", pathOf(name), "", false, true, true, {}};
+      REQUIRE(model->insertModel(modelData));
+    }
+    model->fingerprintModels(model->getAllModels());
+  }
+
+  ~LibraryScannerFixture() {
+    delete model;
+    std::filesystem::remove_all(libraryDir);
+  }
+
+  std::string pathOf(const std::string& name) const {
+    return QDir::cleanPath(QString::fromStdString((libraryDir / name).string())).toStdString();
+  }
+
+  void writeFile(const std::string& name, const std::string& contents) {
+    std::ofstream(libraryDir / name, std::ios::binary | std::ios::trunc) << contents;
+  }
+
+  void bumpMtime(const std::string& name) {
+    auto path = libraryDir / name;
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(10));
+  }
+};
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "ListsGFilesRecursively", "[LibraryScanner]") {
+  writeFile("notes.txt", "ignored");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  std::vector<std::string> files = scanner.listGFiles();
+
+  REQUIRE(files.size() == 3);
+  REQUIRE(std::find(files.begin(), files.end(), pathOf("sub/b.g")) != files.end());
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "UnchangedFilesAreKept", "[LibraryScanner]") {
+  int id = model->getModelByFilePath(pathOf("a.g")).id;
+  ObjectData obj = {0, id, "all.g", 0, false};
+  REQUIRE(model->insertObject(obj) > 0);
+  REQUIRE(model->addTagToModel(id, "keep"));
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ScanResult result = scanner.rescan();
+
+  REQUIRE(result.unchanged == 3);
+  REQUIRE(result.modified == 0);
+  REQUIRE(model->getModelById(id).is_processed);
+  REQUIRE(model->getObjectsForModel(id).size() == 1);
+  REQUIRE(model->getTagsForModel(id).size() == 1);
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "TouchedButIdenticalFilesAreKept", "[LibraryScanner]") {
+  bumpMtime("c.g");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ScanResult result = scanner.rescan();
+
+  REQUIRE(result.modified == 0);
+  ModelData c = model->getModelByFilePath(pathOf("c.g"));
+  REQUIRE(c.is_processed);
+
+  int64_t size = 0;
+  int64_t mtime = 0;
+  REQUIRE(ContentHasher::statFile(c.file_path, size, mtime));
+  REQUIRE(c.file_mtime == mtime);
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "ModifiedFilesAreQueued", "[LibraryScanner]") {
+  int id = model->getModelByFilePath(pathOf("sub/b.g")).id;
+  ObjectData obj = {0, id, "all.g", 0, false};
+  REQUIRE(model->insertObject(obj) > 0);
+  REQUIRE(model->addTagToModel(id, "keep"));
+
+  writeFile("sub/b.g", "second model, edited");
+  bumpMtime("sub/b.g");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ScanResult result = scanner.rescan();
+
+  REQUIRE(result.modified == 1);
+  REQUIRE(result.modifiedIds == std::vector<int>{id});
+  REQUIRE(result.unchanged == 2);
+
+  ModelData b = model->getModelById(id);
+  REQUIRE_FALSE(b.is_processed);
+  REQUIRE(model->getObjectsForModel(id).empty());
+  REQUIRE(model->getTagsForModel(id).size() == 1);
+
+  std::vector<ModelData> queued = model->getIncludedNotProcessedModels();
+  REQUIRE(queued.size() == 1);
+  REQUIRE(queued[0].id == id);
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "MissingAndNewFilesAreReported", "[LibraryScanner]") {
+  std::filesystem::remove(libraryDir / "c.g");
+  writeFile("sub/d.g", "fourth model");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ScanResult result = scanner.rescan();
+
+  REQUIRE(result.removed == 1);
+  REQUIRE(result.added == 1);
+  REQUIRE(model->getModelByFilePath(pathOf("c.g")).id == 0);
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "MovedFilesKeepTheirData", "[LibraryScanner]") {
+  ModelData a = model->getModelByFilePath(pathOf("a.g"));
+  ObjectData obj = {0, a.id, "all.g", 0, true};
+  REQUIRE(model->insertObject(obj) > 0);
+  REQUIRE(model->addTagToModel(a.id, "keep"));
+
+  std::filesystem::rename(libraryDir / "a.g", libraryDir / "sub" / "renamed.g");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ScanResult result = scanner.rescan();
+
+  REQUIRE(result.moved == 1);
+  REQUIRE(result.removed == 0);
+  REQUIRE(result.added == 0);
+
+  ModelData moved = model->getModelByFilePath(pathOf("sub/renamed.g"));
+  REQUIRE(moved.id == a.id);
+  REQUIRE(moved.short_name == "renamed.g");
+  REQUIRE(moved.is_processed);
+  REQUIRE(model->getSelectedObjectsForModel(a.id).size() == 1);
+  REQUIRE(model->getTagsForModel(a.id).size() == 1);
+  REQUIRE(model->getModelByFilePath(pathOf("a.g")).id == 0);
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "CopiedThenDeletedFilesMatchByContent", "[LibraryScanner]") {
+  int id = model->getModelByFilePath(pathOf("c.g")).id;
+
+  // Copying produces a new inode, so only the content hash can match
+  std::filesystem::copy_file(libraryDir / "c.g", libraryDir / "sub" / "c_copy.g");
+  std::filesystem::remove(libraryDir / "c.g");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ModelData moved = scanner.detectMove(pathOf("sub/c_copy.g"));
+
+  REQUIRE(moved.id == id);
+  REQUIRE(moved.file_path == pathOf("sub/c_copy.g"));
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "NewFilesAreNotMistakenForMoves", "[LibraryScanner]") {
+  std::filesystem::remove(libraryDir / "c.g");
+  writeFile("sub/other.g", "other model");   // same size, different bytes
+
+  LibraryScanner scanner(model, libraryDir.string());
+  REQUIRE(scanner.detectMove(pathOf("sub/other.g")).id == 0);
+}
+
+
+TEST_CASE_METHOD(LibraryScannerFixture, "PlanLeavesTheCatalogAlone", "[LibraryScanner]") {
+  int b = model->getModelByFilePath(pathOf("sub/b.g")).id;
+  int c = model->getModelByFilePath(pathOf("c.g")).id;
+  writeFile("sub/b.g", "second model, edited");
+  bumpMtime("sub/b.g");
+  std::filesystem::remove(libraryDir / "c.g");
+
+  LibraryScanner scanner(model, libraryDir.string());
+  ScanPlan plan = scanner.plan();
+
+  REQUIRE(plan.removedIds == std::vector<int>{c});
+  REQUIRE(plan.hashed.size() == 1);
+  REQUIRE(model->getModelByFilePath(pathOf("c.g")).id == c);
+  REQUIRE(model->getIncludedNotProcessedModels().empty());
+
+  ScanResult result = scanner.apply(plan);
+  REQUIRE(result.removed == 1);
+  REQUIRE(result.modifiedIds == std::vector<int>{b});
+  REQUIRE(model->getModelByFilePath(pathOf("c.g")).id == 0);
+}
@@ -0,0 +1,111 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "MemoryBudget.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+static ModelData modelOfSize(int64_t fileSize, int64_t objects, int64_t meshBytes) {
+  ModelData modelData = {1, "model", "", "{}", "", {}, "", "/lib/model.g", "Library", false, false, true, {}};
+  modelData.file_size = fileSize;
+  modelData.object_count = objects;
+  modelData.mesh_bytes = meshBytes;
+  return modelData;
+}
+
+
+TEST_CASE("MemoryBudget: Estimates Grow With The Database", "[MemoryBudget]") {
+  int64_t small = MemoryBudget::estimate(modelOfSize(1 << 20, 100, 0));
+  REQUIRE(small > MemoryBudget::BASE_BYTES);
+  REQUIRE(MemoryBudget::estimate(modelOfSize(1 << 30, 100, 0)) > small);
+  REQUIRE(MemoryBudget::estimate(modelOfSize(1 << 20, 100000, 0)) > small);
+  REQUIRE(MemoryBudget::estimate(modelOfSize(1 << 20, 100, 1 << 28)) > small);
+
+  // Not probed yet: only what is known counts
+  REQUIRE(MemoryBudget::estimate(modelOfSize(0, -1, -1)) == MemoryBudget::BASE_BYTES);
+
+  // A measured peak beats any guess
+  ModelData measured = modelOfSize(1 << 30, 100, 0);
+  measured.peak_rss = 300 << 20;
+  REQUIRE(MemoryBudget::estimate(measured) == 300 << 20);
+}
+
+
+TEST_CASE("MemoryBudget: Admits Jobs While They Fit", "[MemoryBudget]") {
+  MemoryBudget budget(100);
+  REQUIRE(budget.isOversize(51));
+  REQUIRE_FALSE(budget.isOversize(50));
+
+  REQUIRE(budget.acquire(60));
+  REQUIRE(budget.reserved() == 60);
+
+  // Does not fit next to the first one; gives up when cancelled
+  auto now = std::chrono::steady_clock::now();
+  auto after = [now](int ms) {
+    return [now, ms]() { return std::chrono::steady_clock::now() - now > std::chrono::milliseconds(ms); };
+  };
+  REQUIRE_FALSE(budget.acquire(60, after(150)));
+  REQUIRE(budget.running() == 1);
+
+  // Admitted as soon as the first one is done
+  std::atomic<bool> admitted(false);
+  std::thread waiter([&]() { admitted.store(budget.acquire(60)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  REQUIRE_FALSE(admitted.load());
+  budget.release(60);
+  waiter.join();
+  REQUIRE(admitted.load());
+  budget.release(60);
+
+  // Larger than the whole budget: admitted alone
+  REQUIRE(budget.acquire(250));
+  REQUIRE_FALSE(budget.acquire(1, after(50)));
+  budget.release(250);
+  REQUIRE(budget.reserved() == 0);
+  REQUIRE(budget.running() == 0);
+}
+
+
+TEST_CASE("MemoryBudget: Waiting Oversize Jobs Go First", "[MemoryBudget]") {
+  MemoryBudget budget(100);
+  REQUIRE(budget.acquire(30));
+
+  std::atomic<bool> admitted(false);
+  std::thread oversize([&]() { admitted.store(budget.acquire(90, nullptr, true)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Would fit, but the oversize job has been waiting
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE_FALSE(budget.acquire(10, [start]() {
+    return std::chrono::steady_clock::now() - start > std::chrono::milliseconds(150);
+  }));
+
+  budget.release(30);
+  oversize.join();
+  REQUIRE(admitted.load());
+  budget.release(90);
+}
+
+
+TEST_CASE("MemoryBudget: Reservations Release On Scope Exit", "[MemoryBudget]") {
+  MemoryBudget budget(100);
+  {
+    MemoryReservation reservation(budget, 40);
+    REQUIRE(reservation.admitted());
+    REQUIRE(budget.reserved() == 40);
+
+    // Alone the whole time: the process peak is the job's own
+    if (MemoryBudget::peakRss() > 0) {
+      REQUIRE(reservation.peakRssAlone() > 0);
+    }
+    MemoryReservation second(budget, 40);
+    REQUIRE(reservation.peakRssAlone() == 0);
+  }
+  REQUIRE(budget.reserved() == 0);
+  REQUIRE(MemoryBudget::physicalMemory() >= 0);
+}
@@ -1,10 +1,13 @@
 // Catch2 is used for writing and running unit tests
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
 #include <fstream>
 #include "Model.h"
 #include <filesystem>
 #include <memory>
+#include <chrono>
+#include <ctime>
 
 // Helper function to create a temporary test directory
 std::string setupTestDirectory() {
@@ -141,6 +144,384 @@ TEST_CASE("Object Management and Transactions", "[Model]") {
         auto selectedObjects = model.getSelectedObjectsForModel(fetchedModel.id);
         REQUIRE(selectedObjects.empty());
     }
+
+    // Test reusing the extraction of an identical model
+    SECTION("Copy Extraction Between Duplicates") {
+        ObjectData top = {0, fetchedModel.id, "all.g", -1, true, "00000000000000aa"};
+        top.object_id = model.insertObject(top);
+        ObjectData child = {0, fetchedModel.id, "part.c", top.object_id, false};
+        REQUIRE(model.insertObject(child) != -1);
+
+        ModelData copy = {0, "CopyTest", "./path/to/copy", "{}", "", {}, "Author", "/file/copy", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(copy) == true);
+        copy = model.getModelByFilePath(copy.file_path);
+
+        REQUIRE(model.copyExtraction(fetchedModel.id, copy.id));
+
+        auto copied = model.getObjectsForModel(copy.id);
+        REQUIRE(copied.size() == 2);
+        REQUIRE(copied[0].structure_hash == "00000000000000aa");
+        REQUIRE(copied[1].parent_object_id == copied[0].object_id);
+        REQUIRE(model.getModelById(copy.id).is_processed);
+        REQUIRE(model.getModelById(copy.id).title == "Object Title");
+    }
+
+    SECTION("Store Extraction And Thumbnail") {
+        REQUIRE(model.addTagToModel(fetchedModel.id, "kept"));
+
+        // Parents are referenced by index until the rows exist
+        std::vector<ObjectData> objects = {
+            {0, 0, "all.g", -1, true, "00000000000000bb"},
+            {0, 0, "body.c", 0, false},
+            {0, 0, "bolt.s", 1, false}
+        };
+        REQUIRE(model.storeExtraction(fetchedModel.id, "Extracted Title", objects));
+
+        auto stored = model.getObjectsForModel(fetchedModel.id);
+        REQUIRE(stored.size() == 3);
+        REQUIRE(stored[0].parent_object_id == -1);
+        REQUIRE(stored[1].parent_object_id == stored[0].object_id);
+        REQUIRE(stored[2].parent_object_id == stored[1].object_id);
+        REQUIRE(model.getModelById(fetchedModel.id).title == "Extracted Title");
+        REQUIRE_FALSE(model.getModelById(fetchedModel.id).is_processed);
+
+        // Storing again replaces rather than appends
+        REQUIRE(model.storeExtraction(fetchedModel.id, "Extracted Title", objects));
+        REQUIRE(model.getObjectsForModel(fetchedModel.id).size() == 3);
+
+        std::vector<char> png = {'\x89', 'P', 'N', 'G'};
+        REQUIRE(model.storeThumbnail(fetchedModel.id, png));
+        ModelData done = model.getModelById(fetchedModel.id);
+        REQUIRE(done.is_processed);
+        REQUIRE(done.thumbnail == png);
+        REQUIRE(model.getTagsForModel(fetchedModel.id).size() == 1);
+    }
+
+    SECTION("Store Header") {
+        GFileHeader header;
+        header.ok = true;
+        header.db_version = 5;
+        header.title = "Probed Title";
+        header.object_count = 42;
+        REQUIRE(model.storeHeader(fetchedModel.id, header));
+
+        ModelData probed = model.getModelById(fetchedModel.id);
+        REQUIRE(probed.title == "Probed Title");
+        REQUIRE(probed.db_version == 5);
+        REQUIRE(probed.object_count == 42);
+
+        // Once extracted, the title from librt is kept
+        REQUIRE(model.storeThumbnail(fetchedModel.id, {}));
+        header.title = "Other Title";
+        REQUIRE(model.storeHeader(fetchedModel.id, header));
+        REQUIRE(model.getModelById(fetchedModel.id).title == "Probed Title");
+    }
+
+    SECTION("Quarantine Crashing Files") {
+        ModelData crashing = {0, "Crashing", "./path/to/crash", "{}", "", {}, "Author", "/file/crash", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(crashing) == true);
+        int crashingId = model.getModelByFilePath(crashing.file_path).id;
+
+        auto pending = [&]() {
+            auto models = model.getIncludedNotProcessedModels();
+            return std::any_of(models.begin(), models.end(),
+                               [crashingId](const ModelData& m) { return m.id == crashingId; });
+        };
+
+        for (int i = 0; i < Model::QUARANTINE_CRASHES; ++i) {
+            REQUIRE(pending());
+            REQUIRE(model.recordCrash(crashingId));
+        }
+        REQUIRE_FALSE(pending());
+        REQUIRE(model.getModelById(crashingId).crash_count == Model::QUARANTINE_CRASHES);
+
+        // New contents get another chance
+        REQUIRE(model.markModelForReprocessing(crashingId));
+        REQUIRE(pending());
+    }
+
+    SECTION("Stage Progress And Backoff") {
+        ModelData failing = {0, "Failing", "./path/to/failing", "{}", "", {}, "Author", "/file/failing", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(failing) == true);
+        int failingId = model.getModelByFilePath(failing.file_path).id;
+
+        auto pending = [&]() {
+            auto models = model.getIncludedNotProcessedModels();
+            return std::any_of(models.begin(), models.end(),
+                               [failingId](const ModelData& m) { return m.id == failingId; });
+        };
+
+        // Each failure doubles the wait
+        int64_t before = std::time(nullptr);
+        REQUIRE(model.recordStage(failingId, ProcessingStage::Extract, StageFailed));
+        ModelData state = model.getModelById(failingId);
+        REQUIRE(state.extract_error == StageFailed);
+        REQUIRE(state.failure_count == 1);
+        REQUIRE(state.retry_after >= before + Model::RETRY_BASE_SECONDS);
+        REQUIRE_FALSE(pending());
+
+        REQUIRE(model.recordStage(failingId, ProcessingStage::Extract, StageTimedOut));
+        state = model.getModelById(failingId);
+        REQUIRE(state.failure_count == 2);
+        REQUIRE(state.retry_after >= before + 2 * Model::RETRY_BASE_SECONDS);
+        REQUIRE(state.crash_count == 1);
+
+        // A stored extraction is the checkpoint the next run resumes from
+        REQUIRE(model.storeExtraction(failingId, "Recovered", {{0, 0, "all.g", -1, true}}));
+        state = model.getModelById(failingId);
+        REQUIRE(state.extracted_at >= before);
+        REQUIRE(state.extract_error == StageOk);
+        REQUIRE(state.failure_count == 0);
+        REQUIRE(pending());
+
+        REQUIRE(model.recordStage(failingId, ProcessingStage::Tag, StageOk));
+        REQUIRE(model.getModelById(failingId).tagged_at >= before);
+
+        // Probe and tag failures never hold back indexing
+        REQUIRE(model.recordStage(failingId, ProcessingStage::Probe, StageFailed));
+        REQUIRE(model.getModelById(failingId).probe_error == StageFailed);
+        REQUIRE(pending());
+    }
+
+    SECTION("Render Timings For The Cost Model") {
+        GFileHeader header;
+        header.ok = true;
+        header.db_version = 5;
+        header.object_count = 120;
+        header.comb_count = 20;
+        header.mesh_count = 3;
+        header.mesh_bytes = 4096;
+        REQUIRE(model.storeHeader(fetchedModel.id, header));
+        ModelData state = model.getModelById(fetchedModel.id);
+        REQUIRE(state.comb_count == 20);
+        REQUIRE(state.mesh_count == 3);
+        REQUIRE(state.mesh_bytes == 4096);
+        REQUIRE(state.render_ms == 0);
+
+        REQUIRE(model.getRenderTimings().empty());
+        REQUIRE(model.recordRenderTime(fetchedModel.id, 2500));
+        auto timings = model.getRenderTimings();
+        REQUIRE(timings.size() == 1);
+        REQUIRE(timings[0].id == fetchedModel.id);
+        REQUIRE(timings[0].render_ms == 2500);
+        REQUIRE(timings[0].object_count == 120);
+        REQUIRE(timings[0].mesh_bytes == 4096);
+
+        // New contents, new timing
+        REQUIRE(model.markModelForReprocessing(fetchedModel.id));
+        REQUIRE(model.getModelById(fetchedModel.id).render_ms == 0);
+        REQUIRE(model.getRenderTimings().empty());
+    }
+
+    SECTION("Store Deep Extraction") {
+        // A long chain of nested assemblies plus a wide one under the top
+        std::vector<ObjectData> objects = {{0, 0, "all.g", -1, true}};
+        for (int i = 0; i < 200; ++i) {
+            objects.push_back({0, 0, "level" + std::to_string(i), i, false});
+        }
+        for (int i = 0; i < 5000; ++i) {
+            objects.push_back({0, 0, "part" + std::to_string(i), 0, false});
+        }
+        REQUIRE(model.storeExtraction(fetchedModel.id, "Deep", objects));
+
+        auto stored = model.getObjectsForModel(fetchedModel.id);
+        REQUIRE(stored.size() == objects.size());
+        for (size_t i = 1; i <= 200; ++i) {
+            REQUIRE(stored[i].parent_object_id == stored[i - 1].object_id);
+        }
+        REQUIRE(stored.back().parent_object_id == stored[0].object_id);
+
+        // Copies keep the shape
+        ModelData copy = {0, "DeepCopy", "./path/to/deep", "{}", "", {}, "Author", "/file/deep", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(copy) == true);
+        copy = model.getModelByFilePath(copy.file_path);
+        REQUIRE(model.copyExtraction(fetchedModel.id, copy.id));
+        auto copied = model.getObjectsForModel(copy.id);
+        REQUIRE(copied.size() == objects.size());
+        REQUIRE(copied[200].parent_object_id == copied[199].object_id);
+    }
+
+    SECTION("Coarse Preview Until Full Render") {
+        REQUIRE(model.getModelsPendingFullRender().empty());
+
+        std::vector<char> coarse = {'\x89', 'P', 'N', 'G', 'c'};
+        REQUIRE(model.storeCoarseThumbnail(fetchedModel.id, coarse));
+
+        // Not included yet, so nothing is queued for refinement
+        REQUIRE(model.getModelsPendingFullRender().empty());
+        ModelData included = model.getModelById(fetchedModel.id);
+        REQUIRE(included.is_processed);
+        REQUIRE(included.coarse_thumbnail == coarse);
+        REQUIRE(included.coarse_rendered_at > 0);
+        REQUIRE(included.thumbnail_rendered_at == 0);
+
+        included.is_included = true;
+        REQUIRE(model.updateModel(fetchedModel.id, included));
+        REQUIRE(model.getModelsPendingFullRender().size() == 1);
+
+        // A failed full render keeps the coarse image and stays pending,
+        // but waits out its backoff first
+        REQUIRE(model.recordStage(fetchedModel.id, ProcessingStage::Render, StageFailed));
+        ModelData failed = model.getModelById(fetchedModel.id);
+        REQUIRE(failed.thumbnail_rendered_at == 0);
+        REQUIRE(failed.coarse_thumbnail == coarse);
+        REQUIRE(failed.failure_count == 1);
+        REQUIRE(failed.retry_after > 0);
+        REQUIRE(model.getModelsPendingFullRender().empty());
+
+        // The full render that finally succeeds clears the failures
+        std::vector<char> full = {'\x89', 'P', 'N', 'G', 'f'};
+        REQUIRE(model.storeThumbnail(fetchedModel.id, full));
+        REQUIRE(model.recordStage(fetchedModel.id, ProcessingStage::Render, StageOk));
+        ModelData refined = model.getModelById(fetchedModel.id);
+        REQUIRE(refined.thumbnail_rendered_at > 0);
+        REQUIRE(refined.coarse_thumbnail == coarse);
+        REQUIRE(refined.failure_count == 0);
+        REQUIRE(refined.retry_after == 0);
+        REQUIRE(model.getModelsPendingFullRender().empty());
+
+        REQUIRE(model.markModelForReprocessing(fetchedModel.id));
+        ModelData reset = model.getModelById(fetchedModel.id);
+        REQUIRE(reset.coarse_thumbnail.empty());
+        REQUIRE(reset.coarse_rendered_at == 0);
+        REQUIRE(reset.thumbnail_rendered_at == 0);
+    }
+
+    SECTION("Thumbnail Sizes") {
+        REQUIRE(model.getThumbnail(fetchedModel.id, 128).size == 0);
+
+        std::vector<ThumbnailImage> images = {
+            {64, "png", {'s'}},
+            {128, "png", {'m'}},
+            {512, "webp", {'l'}}
+        };
+        REQUIRE(model.storeThumbnailSizes(fetchedModel.id, images));
+        REQUIRE(model.getThumbnailSizes(fetchedModel.id) == std::vector<int>{64, 128, 512});
+
+        // Smallest size that is large enough, else the largest there is
+        REQUIRE(model.getThumbnail(fetchedModel.id, 80).size == 128);
+        REQUIRE(model.getThumbnail(fetchedModel.id, 128).data == std::vector<char>{'m'});
+        REQUIRE(model.getThumbnail(fetchedModel.id, 300).format == "webp");
+        REQUIRE(model.getThumbnail(fetchedModel.id, 1024).size == 512);
+        REQUIRE(model.getThumbnail(fetchedModel.id, 0).size == 64);
+
+        // Storing again replaces the whole set
+        REQUIRE(model.storeThumbnailSizes(fetchedModel.id, {{64, "png", {'c'}}}));
+        REQUIRE(model.getThumbnailSizes(fetchedModel.id) == std::vector<int>{64});
+        REQUIRE(model.getThumbnail(fetchedModel.id, 512).data == std::vector<char>{'c'});
+
+        REQUIRE(model.markModelForReprocessing(fetchedModel.id));
+        REQUIRE(model.getThumbnailSizes(fetchedModel.id).empty());
+    }
+
+    SECTION("Previews Stay Out Of The List") {
+        std::vector<char> png = {'\x89', 'P', 'N', 'G'};
+        ModelData shown = {0, "Shown", "./path/to/shown", "{}", "", png, "Author", "/file/shown", "Library", true, true, true, {}};
+        REQUIRE(model.insertModel(shown) == true);
+        model.refreshModelData();
+        int shownId = model.getModelByFilePath(shown.file_path).id;
+
+        // The catalog keeps the blob; rows load it only to paint
+        REQUIRE(model.getModelById(shownId).thumbnail == png);
+        for (const auto& row : model.getSelectedModels()) {
+            REQUIRE(row.thumbnail.empty());
+            REQUIRE(row.coarse_thumbnail.empty());
+        }
+
+        ThumbnailImage legacy = model.getThumbnail(shownId, 128);
+        REQUIRE(legacy.size == 0);
+        REQUIRE(legacy.format == "png");
+        REQUIRE(legacy.data == png);
+    }
+
+    SECTION("View Atlas") {
+        REQUIRE(model.getViewAtlas(fetchedModel.id).empty());
+
+        REQUIRE(model.storeViewAtlas(fetchedModel.id, {256, "webp", {'a', 't'}}));
+        REQUIRE(model.getViewAtlas(fetchedModel.id) == std::vector<char>{'a', 't'});
+
+        // Exact copies show the same views
+        ModelData copy = {0, "AtlasCopy", "./path/to/copy", "{}", "", {}, "Author", "/file/copy", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(copy) == true);
+        copy = model.getModelByFilePath(copy.file_path);
+        REQUIRE(model.copyExtraction(fetchedModel.id, copy.id));
+        REQUIRE(model.getViewAtlas(copy.id) == std::vector<char>{'a', 't'});
+
+        REQUIRE(model.markModelForReprocessing(fetchedModel.id));
+        REQUIRE(model.getViewAtlas(fetchedModel.id).empty());
+    }
+
+    SECTION("Peak Memory") {
+        REQUIRE(model.getModelById(fetchedModel.id).peak_rss == 0);
+
+        // The highest peak of any job on the file is kept
+        REQUIRE(model.recordPeakRss(fetchedModel.id, 300));
+        REQUIRE(model.recordPeakRss(fetchedModel.id, 200));
+        REQUIRE(model.getModelById(fetchedModel.id).peak_rss == 300);
+
+        REQUIRE(model.markModelForReprocessing(fetchedModel.id));
+        REQUIRE(model.getModelById(fetchedModel.id).peak_rss == 0);
+    }
+
+    SECTION("Geometry Metrics") {
+        REQUIRE(model.getMetrics(fetchedModel.id).primitive_count == -1);
+
+        GeometryMetrics metrics;
+        metrics.primitive_count = 5;
+        metrics.region_count = 2;
+        metrics.comb_count = 3;
+        metrics.tree_depth = 3;
+        metrics.primitive_types = {{"arb8", 4}, {"tor", 1}};
+        REQUIRE(model.storeMetrics(fetchedModel.id, metrics));
+
+        // Counts without sampling leave the measurements unset
+        GeometryMetrics stored = model.getMetrics(fetchedModel.id);
+        REQUIRE(stored.primitive_count == 5);
+        REQUIRE(stored.comb_count == 3);
+        REQUIRE(stored.primitive_types == metrics.primitive_types);
+        REQUIRE_FALSE(stored.sampled);
+        REQUIRE(stored.volume == -1.0);
+
+        metrics.sampled = true;
+        metrics.bbox_max[0] = metrics.bbox_max[1] = metrics.bbox_max[2] = 10.0;
+        metrics.volume = 900.0;
+        metrics.volume_error = 12.5;
+        metrics.surface_area = 580.0;
+        metrics.surface_area_error = 40.0;
+        metrics.primitive_types = {{"arb8", 5}};
+        REQUIRE(model.storeMetrics(fetchedModel.id, metrics));
+        stored = model.getMetrics(fetchedModel.id);
+        REQUIRE(stored.sampled);
+        REQUIRE(stored.bbox_max[2] == 10.0);
+        REQUIRE(stored.volume == 900.0);
+        REQUIRE(stored.surface_area_error == 40.0);
+        REQUIRE(stored.primitive_types.size() == 1);
+
+        // Measurements from the render keep the counts
+        GeometryMetrics measured;
+        REQUIRE_FALSE(model.storeMeasurements(fetchedModel.id, measured));
+        measured.sampled = true;
+        measured.volume = 850.0;
+        REQUIRE(model.storeMeasurements(fetchedModel.id, measured));
+        stored = model.getMetrics(fetchedModel.id);
+        REQUIRE(stored.volume == 850.0);
+        REQUIRE(stored.primitive_count == 5);
+        REQUIRE(stored.primitive_types.size() == 1);
+        REQUIRE(model.storeMetrics(fetchedModel.id, metrics));
+
+        ModelData copy = {0, "MetricsCopy", "./path/to/copy", "{}", "", {}, "Author", "/file/metrics", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(copy) == true);
+        copy = model.getModelByFilePath(copy.file_path);
+        REQUIRE(model.copyExtraction(fetchedModel.id, copy.id));
+        REQUIRE(model.getMetrics(copy.id).volume == 900.0);
+        REQUIRE(model.getMetrics(copy.id).primitive_types == stored.primitive_types);
+
+        REQUIRE(model.markModelForReprocessing(fetchedModel.id));
+        stored = model.getMetrics(fetchedModel.id);
+        REQUIRE(stored.primitive_count == -1);
+        REQUIRE_FALSE(stored.sampled);
+        REQUIRE(stored.primitive_types.empty());
+    }
 }
 
 
@@ -203,6 +584,22 @@ TEST_CASE("Model: Hashing Functionality", "[Model]") {
         REQUIRE(hashValue == 0); // Nonexistent file should return a hash of 0
     }
 
+    // Test storing a 64-bit fingerprint for a model
+    SECTION("Fingerprint Models") {
+        ModelData hashed = {0, "Hashed", "./file", "{}", "Title", {}, "Author", validFilePath, "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(hashed));
+        hashed = model.getModelByFilePath(validFilePath);
+
+        auto prints = model.fingerprintModels({hashed});
+        REQUIRE(prints.size() == 1);
+        REQUIRE(prints[0].content_hash.size() == 16);
+
+        auto stored = model.getModelById(hashed.id);
+        REQUIRE(stored.content_hash == prints[0].content_hash);
+        REQUIRE(stored.file_size == prints[0].size);
+        REQUIRE(stored.file_mtime == prints[0].mtime);
+    }
+
     cleanupTestDirectory(testDir);
 }
 
@@ -230,6 +627,44 @@ TEST_CASE("Model: Refresh Data and Roles", "[Model]") {
         REQUIRE_NOTHROW(model.refreshModelData());
     }
 
+    // Only the named rows are reread; missing rows reload the list
+    SECTION("Refresh Selected Models") {
+        ModelData first = {0, "First", "./first", "{}", "First Title", {}, "Author", "/first/path", "Library", false, false, true, {}};
+        ModelData second = {0, "Second", "./second", "{}", "Second Title", {}, "Author", "/second/path", "Library", false, false, true, {}};
+        REQUIRE(model.insertModel(first));
+        REQUIRE(model.insertModel(second));
+        int firstId = model.getModelByFilePath(first.file_path).id;
+        int secondId = model.getModelByFilePath(second.file_path).id;
+        REQUIRE(model.rowCount() == 2);
+
+        auto titleOf = [&model](int id) {
+            for (int row = 0; row < model.rowCount(); ++row) {
+                QModelIndex index = model.index(row, 0);
+                if (model.data(index, Model::IdRole).toInt() == id) {
+                    return model.data(index, Model::TitleRole).toString().toStdString();
+                }
+            }
+            return std::string();
+        };
+
+        // Another connection changes both; this one only rereads the first
+        Model writer(testDir);
+        ModelData changed = writer.getModelById(firstId);
+        changed.title = "First Changed";
+        REQUIRE(writer.updateModel(firstId, changed));
+        changed = writer.getModelById(secondId);
+        changed.title = "Second Changed";
+        REQUIRE(writer.updateModel(secondId, changed));
+
+        model.refreshModels({firstId});
+        REQUIRE(titleOf(firstId) == "First Changed");
+        REQUIRE(titleOf(secondId) == "Second Title");
+
+        REQUIRE(writer.deleteModel(secondId));
+        model.refreshModels({secondId});
+        REQUIRE(model.rowCount() == 1);
+    }
+
     // Ensure role names map to expected values
     SECTION("Role Names") {
         auto roles = model.roleNames();
@@ -556,3 +991,63 @@ TEST_CASE("Model: Get Included Not Processed Models", "[Model]") {
     // Clean up after test execution
     cleanupTestDirectory(testDir);
 }
+
+// Test case for removing orphaned catalog rows and stale previews
+TEST_CASE("Model: Garbage Collection", "[Model]") {
+    std::string testDir = setupTestDirectory();
+    cleanupTestDirectory(testDir);
+    std::filesystem::create_directories(testDir);
+
+    Model model(testDir);
+
+    ModelData kept = {0, "Kept", "./kept", "{}", "Kept", {}, "Author", "/kept", "Library", false, true, true, {}};
+    REQUIRE(model.insertModel(kept));
+    kept = model.getModelByFilePath(kept.file_path);
+    REQUIRE(model.addTagToModel(kept.id, "vehicle"));
+    ObjectData keptObject = {0, kept.id, "all.g", -1, true};
+    REQUIRE(model.insertObject(keptObject) != -1);
+
+    // Rows left behind by models deleted before deleteModel cleaned up
+    ObjectData orphan = {0, 9999, "lost.c", -1, false};
+    REQUIRE(model.insertObject(orphan) != -1);
+    REQUIRE(model.addTagToModel(9999, "orphaned"));
+
+    // A preview left behind by an interrupted render
+    auto previews = std::filesystem::path(model.getHiddenDirectoryPath()) / "previews";
+    std::filesystem::create_directories(previews);
+    std::ofstream(previews / "stale.png") << "not really a png";
+    std::filesystem::last_write_time(previews / "stale.png",
+        std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+
+    SECTION("Deleting a model removes its tag links") {
+        ModelData doomed = {0, "Doomed", "./doomed", "{}", "Doomed", {}, "Author", "/doomed", "Library", false, true, true, {}};
+        REQUIRE(model.insertModel(doomed));
+        doomed = model.getModelByFilePath(doomed.file_path);
+        REQUIRE(model.addTagToModel(doomed.id, "doomed"));
+
+        REQUIRE(model.deleteModel(doomed.id));
+        REQUIRE(model.getTagsForModel(doomed.id).empty());
+    }
+
+    SECTION("Collect Garbage") {
+        GarbageReport report = model.collectGarbage();
+
+        REQUIRE(report.orphan_objects == 1);
+        REQUIRE(report.orphan_model_tags == 1);
+        REQUIRE(report.stale_previews == 1);
+        REQUIRE(report.preview_bytes > 0);
+        REQUIRE_FALSE(std::filesystem::exists(previews / "stale.png"));
+
+        REQUIRE(model.getObjectsForModel(kept.id).size() == 1);
+        REQUIRE(model.getTagsForModel(kept.id).size() == 1);
+        // Tags no model uses any more are still offered
+        REQUIRE(model.getAllTags().size() == 2);
+
+        // A second pass finds nothing left to do
+        GarbageReport again = model.collectGarbage();
+        REQUIRE(again.orphan_objects == 0);
+        REQUIRE(again.orphan_model_tags == 0);
+    }
+
+    cleanupTestDirectory(testDir);
+}
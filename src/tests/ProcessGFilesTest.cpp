@@ -3,6 +3,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include "../ProcessGFiles.h"
 #include "../Model.h"
+#include "../RenderCostModel.h"
 #include <filesystem>
 #include <memory>
 #include <QDir>
@@ -132,3 +133,163 @@ TEST_CASE("ProcessGFiles - Generate Gist Report and Check PDF Output", "[Process
 
     cleanupTestLibraryPath();
 }
+
+// An extraction stored by an interrupted run is not redone
+TEST_CASE("ProcessGFiles - Resume After Stored Extraction", "[ProcessGFiles]") {
+    setupTestLibraryPath();
+    auto model = std::make_unique<Model>(TEST_LIBRARY_PATH, nullptr);
+    ProcessGFiles processor(model.get());
+
+    // The file is gone: only the checkpoint can supply the extraction
+    ModelData modelData = createTestModelData(0, "resumed", "resumed.g");
+    modelData.file_path = TEST_LIBRARY_PATH + "/missing.g";
+    modelData.is_included = true;
+    REQUIRE(model->insertModel(modelData));
+    modelData = model->getModelByFilePath(modelData.file_path);
+
+    ExtractionResult failed = processor.extract(modelData);
+    REQUIRE_FALSE(failed.ok);
+    REQUIRE_FALSE(processor.persistExtraction(failed));
+    REQUIRE(model->getModelById(modelData.id).failure_count == 1);
+
+    REQUIRE(model->storeExtraction(modelData.id, "Stored", {{0, 0, "tank", -1, true}, {0, 0, "hull", 0, false}}));
+    modelData = model->getModelById(modelData.id);
+
+    ExtractionResult resumed = processor.extract(modelData);
+    REQUIRE(resumed.ok);
+    REQUIRE(resumed.resumed);
+    REQUIRE(resumed.thumbnailObject == "tank");
+
+    // Persisting keeps the stored objects as they are
+    REQUIRE(processor.persistExtraction(resumed));
+    REQUIRE(model->getObjectsForModel(modelData.id).size() == 2);
+
+    cleanupTestLibraryPath();
+}
+
+// Extraction counts the whole database; the full render measures the
+// thumbnail object on the session it traces with
+TEST_CASE("ProcessGFiles - Extraction Counts, Render Measures", "[ProcessGFiles]") {
+    std::string testFilePath = "../src/tests/annual_gift_man.g";
+    if (!std::filesystem::exists(testFilePath)) {
+        WARN("annual_gift_man.g file not found, skipping test");
+        return;
+    }
+    setupTestLibraryPath();
+    auto model = std::make_unique<Model>(TEST_LIBRARY_PATH, nullptr);
+    ProcessGFiles processor(model.get());
+
+    ModelData modelData = createTestModelData(0, "annual_gift_man", testFilePath);
+    modelData.file_path = testFilePath;
+    modelData.is_included = true;
+    REQUIRE(model->insertModel(modelData));
+    modelData = model->getModelByFilePath(testFilePath);
+
+    ExtractionResult extraction = processor.extract(modelData);
+    REQUIRE(extraction.ok);
+    const GeometryMetrics& metrics = extraction.metrics;
+    REQUIRE(metrics.primitive_count > 0);
+    REQUIRE(metrics.region_count > 0);
+    REQUIRE(metrics.tree_depth > 1);
+    int typed = 0;
+    for (const auto& type : metrics.primitive_types) {
+        typed += type.second;
+    }
+    REQUIRE(typed == metrics.primitive_count);
+    REQUIRE_FALSE(metrics.sampled);
+
+    // Counts are stored with the extraction
+    REQUIRE(processor.persistExtraction(extraction));
+    GeometryMetrics stored = model->getMetrics(modelData.id);
+    REQUIRE(stored.primitive_count == metrics.primitive_count);
+    REQUIRE(stored.primitive_types == metrics.primitive_types);
+    REQUIRE_FALSE(stored.sampled);
+
+    // A coarse pass does not sample
+    RenderResult coarse = processor.render(extraction, true);
+    REQUIRE(coarse.ok);
+    REQUIRE_FALSE(coarse.metrics.sampled);
+
+    RenderResult full = processor.render(extraction);
+    REQUIRE(full.ok);
+    REQUIRE(full.metrics.sampled);
+    REQUIRE(full.metrics.volume > 0.0);
+
+    // Measurements join the counts
+    REQUIRE(processor.persistRender(full));
+    stored = model->getMetrics(modelData.id);
+    REQUIRE(stored.sampled);
+    REQUIRE(stored.volume == full.metrics.volume);
+    REQUIRE(stored.primitive_count == metrics.primitive_count);
+
+    cleanupTestLibraryPath();
+}
+
+// A failed render leaves the model pending under backoff instead of done
+TEST_CASE("ProcessGFiles - Failed Render Is Retried", "[ProcessGFiles]") {
+    setupTestLibraryPath();
+    auto model = std::make_unique<Model>(TEST_LIBRARY_PATH, nullptr);
+    ProcessGFiles processor(model.get());
+
+    ModelData modelData = createTestModelData(0, "unrendered", "unrendered.g");
+    modelData.file_path = TEST_LIBRARY_PATH + "/unrendered.g";
+    modelData.is_included = true;
+    REQUIRE(model->insertModel(modelData));
+    modelData = model->getModelByFilePath(modelData.file_path);
+    REQUIRE(model->storeExtraction(modelData.id, "Stored", {{0, 0, "tank", -1, true}}));
+
+    RenderResult failed;
+    failed.modelId = modelData.id;
+    failed.error = StageFailed;
+    REQUIRE_FALSE(processor.persistRender(failed));
+
+    ModelData pending = model->getModelById(modelData.id);
+    REQUIRE_FALSE(pending.is_processed);
+    REQUIRE(pending.thumbnail_rendered_at == 0);
+    REQUIRE(pending.render_error == StageFailed);
+    REQUIRE(pending.failure_count == 1);
+    REQUIRE(model->getIncludedNotProcessedModels().empty());
+
+    cleanupTestLibraryPath();
+}
+
+TEST_CASE("ProcessGFiles - Timed Out Renders Climb The Ladder", "[ProcessGFiles]") {
+    setupTestLibraryPath();
+    QSettings().setValue("previewTimer", 30);
+    auto model = std::make_unique<Model>(TEST_LIBRARY_PATH, nullptr);
+    ProcessGFiles processor(model.get());
+
+    ModelData modelData = createTestModelData(0, "huge", "huge.g");
+    modelData.file_path = TEST_LIBRARY_PATH + "/huge.g";
+    modelData.is_included = true;
+    REQUIRE(model->insertModel(modelData));
+    modelData = model->getModelByFilePath(modelData.file_path);
+    REQUIRE(model->storeExtraction(modelData.id, "Stored", {{0, 0, "tank", -1, true}}));
+
+    // Every rung of the ladder gets its try with a longer limit
+    int lastLimitMs = 0;
+    for (int attempt = 0; attempt <= RenderCostModel::MAX_RETRY_DOUBLINGS; ++attempt) {
+        ModelData state = model->getModelById(modelData.id);
+        REQUIRE_FALSE(state.is_processed);
+        REQUIRE(state.crash_count == 0);
+
+        int limitMs = RenderCostModel::timeLimitMs(state, 20.0, false);
+        REQUIRE(limitMs > lastLimitMs);
+        lastLimitMs = limitMs;
+
+        RenderResult timedOut;
+        timedOut.modelId = modelData.id;
+        timedOut.error = StageTimedOut;
+        timedOut.renderMs = limitMs;
+        REQUIRE_FALSE(processor.persistRender(timedOut));
+    }
+
+    // Only the timeout at the longest limit counts toward quarantine
+    ModelData state = model->getModelById(modelData.id);
+    REQUIRE(state.failure_count == RenderCostModel::MAX_RETRY_DOUBLINGS + 1);
+    REQUIRE(state.crash_count == 1);
+    REQUIRE(state.crash_count < Model::QUARANTINE_CRASHES);
+
+    QSettings().remove("previewTimer");
+    cleanupTestLibraryPath();
+}
@@ -0,0 +1,159 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "ProcessingQueue.h"
+
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+
+static ModelData modelWithId(int id) {
+  ModelData modelData = {id, "model" + std::to_string(id), "", "{}", "", {}, "", "/lib/model" + std::to_string(id) + ".g", "Library", false, false, true, {}};
+  return modelData;
+}
+
+static std::vector<int> drain(ProcessingQueue& queue) {
+  std::vector<int> ids;
+  ModelData next;
+  while (queue.pop(next)) {
+    ids.push_back(next.id);
+  }
+  return ids;
+}
+
+
+TEST_CASE("ProcessingQueue: First In First Out Without Boosts", "[ProcessingQueue]") {
+  ProcessingQueue queue(0.0);
+  REQUIRE(queue.enqueue(modelWithId(1)));
+  REQUIRE(queue.enqueue(modelWithId(2)));
+  REQUIRE(queue.enqueue(modelWithId(3)));
+
+  // Already waiting: refreshed, not added twice
+  REQUIRE_FALSE(queue.enqueue(modelWithId(2)));
+  REQUIRE(queue.size() == 3);
+
+  REQUIRE(drain(queue) == std::vector<int>{1, 2, 3});
+  REQUIRE(queue.size() == 0);
+}
+
+
+TEST_CASE("ProcessingQueue: Boosts Reorder Waiting Models", "[ProcessingQueue]") {
+  ProcessingQueue queue(0.0);
+  for (int id = 1; id <= 5; ++id) {
+    queue.enqueue(modelWithId(id));
+  }
+
+  queue.setVisible({4});
+  queue.boost(3, ProcessingQueue::NewlyIncluded);
+  queue.prioritize(5);
+  REQUIRE(drain(queue) == std::vector<int>{5, 4, 3, 1, 2});
+}
+
+
+TEST_CASE("ProcessingQueue: Visibility Follows The Viewport", "[ProcessingQueue]") {
+  ProcessingQueue queue(0.0);
+  for (int id = 1; id <= 3; ++id) {
+    queue.enqueue(modelWithId(id));
+  }
+
+  queue.setVisible({3});
+  queue.setVisible({2});
+  REQUIRE(drain(queue) == std::vector<int>{2, 1, 3});
+}
+
+
+TEST_CASE("ProcessingQueue: Boosts Wait For Models Not Yet Queued", "[ProcessingQueue]") {
+  ProcessingQueue queue(0.0);
+  queue.enqueue(modelWithId(1));
+  queue.prioritize(2);
+  REQUIRE_FALSE(queue.contains(2));
+
+  queue.enqueue(modelWithId(2));
+  REQUIRE(drain(queue) == std::vector<int>{2, 1});
+}
+
+
+TEST_CASE("ProcessingQueue: Aging Lets Background Work Through", "[ProcessingQueue]") {
+  // One newly-included boost worth of aging per millisecond
+  ProcessingQueue queue(ProcessingQueue::NewlyIncluded * 1000.0);
+  queue.enqueue(modelWithId(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.enqueue(modelWithId(2), ProcessingQueue::NewlyIncluded);
+
+  REQUIRE(drain(queue) == std::vector<int>{1, 2});
+
+  // Without aging, the boost wins
+  queue.setAgingRate(0.0);
+  queue.enqueue(modelWithId(1));
+  queue.enqueue(modelWithId(2), ProcessingQueue::NewlyIncluded);
+  REQUIRE(drain(queue) == std::vector<int>{2, 1});
+}
+
+
+TEST_CASE("ProcessingQueue: Shortest Jobs First Within A Priority", "[ProcessingQueue]") {
+  ProcessingQueue queue(0.0);
+  queue.enqueue(modelWithId(1), ProcessingQueue::Background, 120.0);
+  queue.enqueue(modelWithId(2), ProcessingQueue::Background, 2.0);
+  queue.enqueue(modelWithId(3), ProcessingQueue::Background, 30.0);
+  queue.enqueue(modelWithId(4), ProcessingQueue::Visible, 86400.0);
+
+  // A new estimate moves a waiting model
+  queue.enqueue(modelWithId(3), ProcessingQueue::Background, 1.0);
+  REQUIRE(drain(queue) == std::vector<int>{4, 3, 2, 1});
+
+  // Long jobs still get their turn once they have waited long enough
+  queue.setAgingRate(1000.0);
+  queue.enqueue(modelWithId(1), ProcessingQueue::Background, 3.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  queue.enqueue(modelWithId(2), ProcessingQueue::Background, 1.0);
+  REQUIRE(drain(queue) == std::vector<int>{1, 2});
+}
+
+
+TEST_CASE("ProcessingQueue: Concurrent Consumers Take Each Model Once", "[ProcessingQueue]") {
+  ProcessingQueue queue;
+  for (int id = 1; id <= 1000; ++id) {
+    queue.enqueue(modelWithId(id));
+  }
+
+  std::vector<std::vector<int>> taken(4);
+  std::vector<std::thread> consumers;
+  for (size_t i = 0; i < taken.size(); ++i) {
+    consumers.emplace_back([&queue, &taken, i]() { taken[i] = drain(queue); });
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+
+  std::set<int> all;
+  size_t total = 0;
+  for (const auto& ids : taken) {
+    all.insert(ids.begin(), ids.end());
+    total += ids.size();
+  }
+  REQUIRE(total == 1000);
+  REQUIRE(all.size() == 1000);
+}
+
+
+TEST_CASE("ProcessingQueue: Peek Shows What Comes Next", "[ProcessingQueue]") {
+  ProcessingQueue queue(0.0);
+  for (int id = 1; id <= 4; ++id) {
+    queue.enqueue(modelWithId(id));
+  }
+  queue.prioritize(3);
+
+  std::vector<ModelData> upcoming = queue.peek(2);
+  REQUIRE(upcoming.size() == 2);
+  REQUIRE(upcoming[0].id == 3);
+  REQUIRE(upcoming[1].id == 1);
+  REQUIRE(queue.peek(10).size() == 4);
+
+  // Peeking leaves the queue as it was
+  REQUIRE(drain(queue) == std::vector<int>{3, 1, 2, 4});
+  REQUIRE(queue.peek(1).empty());
+}
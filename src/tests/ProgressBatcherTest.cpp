@@ -0,0 +1,63 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "ProgressBatcher.h"
+
+#include <chrono>
+#include <thread>
+
+
+TEST_CASE("ProgressBatcher: First News Goes Out At Once", "[ProgressBatcher]") {
+  ProgressBatcher batcher(std::chrono::milliseconds(10000), 64);
+  ProgressBatcher::Batch batch;
+  REQUIRE_FALSE(batcher.takeDue(batch));
+  REQUIRE_FALSE(batcher.take(batch));
+
+  REQUIRE(batcher.processed(1));
+  REQUIRE(batcher.takeDue(batch));
+  REQUIRE(batch.modelIds == std::vector<int>{1});
+  REQUIRE_FALSE(batch.hasProgress);
+
+  // Within the interval everything waits, the latest progress wins
+  REQUIRE_FALSE(batcher.processed(2));
+  REQUIRE_FALSE(batcher.progress("a.g", 10));
+  REQUIRE_FALSE(batcher.processed(3));
+  REQUIRE_FALSE(batcher.processed(2));
+  REQUIRE_FALSE(batcher.progress("b.g", 20));
+  REQUIRE_FALSE(batcher.takeDue(batch));
+
+  // What is left goes out when asked for
+  REQUIRE(batcher.take(batch));
+  const std::vector<int> waited = {2, 3};
+  REQUIRE(batch.modelIds == waited);
+  REQUIRE(batch.hasProgress);
+  REQUIRE(batch.status == "b.g");
+  REQUIRE(batch.percentage == 20);
+  REQUIRE(batcher.batches() == 2);
+  REQUIRE_FALSE(batcher.take(batch));
+}
+
+
+TEST_CASE("ProgressBatcher: Due After The Interval Or Enough Items", "[ProgressBatcher]") {
+  ProgressBatcher::Batch batch;
+
+  ProgressBatcher timed(std::chrono::milliseconds(20), 64);
+  REQUIRE(timed.progress("a.g", 1));
+  REQUIRE(timed.takeDue(batch));
+  REQUIRE_FALSE(timed.processed(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  REQUIRE(timed.takeDue(batch));
+  REQUIRE(batch.modelIds == std::vector<int>{1});
+
+  ProgressBatcher counted(std::chrono::milliseconds(10000), 3);
+  REQUIRE(counted.processed(1));
+  REQUIRE(counted.takeDue(batch));
+  REQUIRE_FALSE(counted.processed(2));
+  REQUIRE_FALSE(counted.processed(3));
+  REQUIRE(counted.processed(4));
+  REQUIRE(counted.takeDue(batch));
+  const std::vector<int> piledUp = {2, 3, 4};
+  REQUIRE(batch.modelIds == piledUp);
+}
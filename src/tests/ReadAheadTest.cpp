@@ -0,0 +1,78 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "ReadAhead.h"
+
+#include <filesystem>
+#include <fstream>
+
+
+class ReadAheadFixture {
+public:
+  std::filesystem::path dir;
+
+  ReadAheadFixture() {
+    dir = std::filesystem::temp_directory_path() / "ReadAheadTest";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+  }
+
+  ~ReadAheadFixture() {
+    std::filesystem::remove_all(dir);
+  }
+
+  ModelData file(int id, int64_t size) {
+    std::string path = (dir / ("model" + std::to_string(id) + ".g")).string();
+    std::ofstream(path, std::ios::binary) << std::string(static_cast<size_t>(size), 'g');
+    ModelData modelData = {id, "model" + std::to_string(id), "", "{}", "", {}, "", path, "Library", false, false, true, {}};
+    modelData.file_size = size;
+    return modelData;
+  }
+};
+
+
+TEST_CASE_METHOD(ReadAheadFixture, "ReadAhead: Stays Within Its Budget", "[ReadAhead]") {
+  ModelData a = file(1, 1000), b = file(2, 1000), c = file(3, 1000);
+
+  // The second file only fits in part; the third is past the depth
+  ReadAhead readAhead(2, 1500);
+  readAhead.prefetch({a, b, c});
+  REQUIRE(readAhead.pendingBytes() == 1500);
+  readAhead.wait();
+  REQUIRE(readAhead.hintedFiles() == 2);
+  REQUIRE(readAhead.hintedBytes() == 1500);
+
+  // The first one was opened: its share goes to the next file
+  readAhead.prefetch({b, c});
+  REQUIRE(readAhead.pendingBytes() == 1500);
+  readAhead.wait();
+  REQUIRE(readAhead.hintedFiles() == 3);
+
+  // Files already hinted are not hinted again
+  readAhead.prefetch({b, c});
+  readAhead.wait();
+  REQUIRE(readAhead.hintedFiles() == 3);
+
+  readAhead.prefetch({});
+  REQUIRE(readAhead.pendingBytes() == 0);
+}
+
+
+TEST_CASE_METHOD(ReadAheadFixture, "ReadAhead: Skips What It Cannot Read", "[ReadAhead]") {
+  ModelData empty = file(1, 0);
+  ModelData missing = file(2, 100);
+  std::filesystem::remove(missing.file_path);
+
+  ReadAhead readAhead(4, 1 << 20);
+  readAhead.prefetch({empty, missing});
+  readAhead.wait();
+  REQUIRE(readAhead.hintedFiles() == 0);
+  REQUIRE_FALSE(ReadAhead::advise(missing.file_path, 100));
+
+  // Depth 0 turns read-ahead off
+  ReadAhead off(0, 1 << 20);
+  off.prefetch({file(3, 100)});
+  REQUIRE(off.pendingBytes() == 0);
+}
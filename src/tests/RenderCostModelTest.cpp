@@ -0,0 +1,152 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "RenderCostModel.h"
+
+#include <QCoreApplication>
+#include <QSettings>
+
+#include <vector>
+
+
+static ModelData modelWithMix(int id, int64_t fileSize, int64_t objects, int64_t combs,
+                              int64_t meshes, int64_t meshBytes) {
+  ModelData modelData = {id, "model" + std::to_string(id), "", "{}", "", {}, "", "/lib/model" + std::to_string(id) + ".g", "Library", false, false, true, {}};
+  modelData.file_size = fileSize;
+  modelData.object_count = objects;
+  modelData.comb_count = combs;
+  modelData.mesh_count = meshes;
+  modelData.mesh_bytes = meshBytes;
+  return modelData;
+}
+
+/* keeps the tests away from the user's settings */
+class PreviewTimerFixture {
+public:
+  PreviewTimerFixture() {
+    QCoreApplication::setOrganizationName("BRL-CAD");
+    QCoreApplication::setApplicationName("CADventoryTests");
+  }
+
+  ~PreviewTimerFixture() {
+    QSettings().remove("previewTimer");
+  }
+
+  void set(int seconds) {
+    QSettings().setValue("previewTimer", seconds);
+  }
+};
+
+const int64_t MB = 1024 * 1024;
+
+
+TEST_CASE("RenderCostModel: Estimates Grow With Size And Primitive Mix", "[RenderCostModel]") {
+  RenderCostModel costs;
+
+  double bolt = costs.estimate(modelWithMix(1, 64 * 1024, 20, 5, 0, 0));
+  double engine = costs.estimate(modelWithMix(2, 50 * MB, 20000, 4000, 0, 0));
+  double scan = costs.estimate(modelWithMix(3, 50 * MB, 10, 2, 4, 48 * MB));
+  REQUIRE(bolt > 0.0);
+  REQUIRE(bolt < engine);
+  REQUIRE(engine < scan);
+
+  /* not probed yet: the file size alone decides */
+  ModelData unprobed = modelWithMix(4, 50 * MB, -1, -1, -1, -1);
+  REQUIRE(costs.estimate(unprobed) > bolt);
+  REQUIRE(costs.estimate(unprobed) < costs.estimate(modelWithMix(5, 500 * MB, -1, -1, -1, -1)));
+}
+
+
+TEST_CASE("RenderCostModel: Calibrates To Recorded Render Times", "[RenderCostModel]") {
+  RenderCostModel uncalibrated;
+  REQUIRE(uncalibrated.speedFactor() == 1.0);
+
+  /* this machine renders everything three times slower than the prior */
+  std::vector<ModelData> rendered;
+  for (int id = 1; id <= 45; ++id) {
+    ModelData modelData = modelWithMix(id, id * MB, id * 100, id * 10, 0, 0);
+    modelData.render_ms = static_cast<int64_t>(uncalibrated.estimate(modelData) * 3000.0);
+    rendered.push_back(modelData);
+  }
+  /* timeouts only say the render took longer; they do not calibrate */
+  ModelData timedOut = modelWithMix(46, MB, 100, 10, 0, 0);
+  timedOut.render_ms = 1;
+  timedOut.render_error = StageTimedOut;
+  rendered.push_back(timedOut);
+
+  RenderCostModel costs;
+  costs.calibrate(rendered);
+  REQUIRE(costs.samples() == 45);
+  REQUIRE(costs.speedFactor() > 2.5);
+  REQUIRE(costs.speedFactor() < 3.0);
+
+  ModelData fresh = modelWithMix(100, 10 * MB, 1000, 100, 0, 0);
+  REQUIRE(costs.estimate(fresh) > 2.5 * uncalibrated.estimate(fresh));
+
+  /* a single sample moves the factor only a little */
+  RenderCostModel sparse;
+  sparse.calibrate({rendered.front()});
+  REQUIRE(sparse.speedFactor() > 1.0);
+  REQUIRE(sparse.speedFactor() < 1.5);
+}
+
+
+TEST_CASE("RenderCostModel: Own Measurements Win", "[RenderCostModel]") {
+  RenderCostModel costs;
+  ModelData modelData = modelWithMix(1, 200 * MB, 100000, 20000, 100, 150 * MB);
+
+  modelData.render_ms = 1500;
+  REQUIRE(costs.estimate(modelData) == 1.5);
+
+  /* timed out after 600s: ask for more than it was given */
+  modelData.render_ms = 600000;
+  modelData.render_error = StageTimedOut;
+  REQUIRE(costs.estimate(modelData) >= 1200.0);
+}
+
+
+TEST_CASE("RenderCostModel: Time Limits Scale With The Estimate", "[RenderCostModel]") {
+  PreviewTimerFixture settings;
+  settings.set(30);
+
+  /* never below the preview timer, never above twenty times it */
+  REQUIRE(RenderCostModel::timeLimitMs(0.0, false) == 30000);
+  REQUIRE(RenderCostModel::timeLimitMs(1.0, false) == 30000);
+  REQUIRE(RenderCostModel::timeLimitMs(20.0, false) == 80000);
+  REQUIRE(RenderCostModel::timeLimitMs(20.0, true) == 30000);
+  REQUIRE(RenderCostModel::timeLimitMs(80.0, true) == 80000);
+  REQUIRE(RenderCostModel::timeLimitMs(100000.0, false) == 600000);
+
+  /* 0 turns the limit off */
+  settings.set(0);
+  REQUIRE(RenderCostModel::timeLimitMs(20.0, false) == 0);
+}
+
+
+TEST_CASE("RenderCostModel: Retries Get More Time", "[RenderCostModel]") {
+  PreviewTimerFixture settings;
+  settings.set(30);
+
+  /* each failed attempt doubles the limit and its ceiling */
+  REQUIRE(RenderCostModel::timeLimitMs(20.0, false, 1) == 160000);
+  REQUIRE(RenderCostModel::timeLimitMs(20.0, false, 2) == 320000);
+  REQUIRE(RenderCostModel::timeLimitMs(100000.0, false, 1) == 1200000);
+  REQUIRE(RenderCostModel::timeLimitMs(100000.0, false, 50) == 9600000);
+
+  /* a timeout gets twice what it was given, within the ceiling */
+  REQUIRE(RenderCostModel::timeLimitMs(1.0, false, 1, 400000) == 800000);
+  REQUIRE(RenderCostModel::timeLimitMs(1.0, false, 1, 900000) == 1200000);
+
+  /* from what the catalog recorded; coarse passes ignore full render times */
+  ModelData modelData = modelWithMix(1, MB, 10, 2, 0, 0);
+  modelData.render_ms = 100000;
+  modelData.render_error = StageTimedOut;
+  modelData.failure_count = 1;
+  REQUIRE(RenderCostModel::timeLimitMs(modelData, 20.0, false) == 200000);
+  REQUIRE(RenderCostModel::timeLimitMs(modelData, 20.0, true) == 60000);
+
+  modelData.render_error = StageFailed;
+  REQUIRE(RenderCostModel::timeLimitMs(modelData, 20.0, false) == 160000);
+}
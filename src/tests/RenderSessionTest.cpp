@@ -0,0 +1,139 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "RenderSession.h"
+
+#include <QImage>
+#include <filesystem>
+
+
+// Same sample geometry the ProcessGFiles tests use
+static const std::string SAMPLE_FILE = "../src/tests/annual_gift_man.g";
+
+static ThumbnailOptions view(int size, double azimuth, double elevation, bool shaded = true) {
+  ThumbnailOptions options;
+  options.size = size;
+  options.azimuth = azimuth;
+  options.elevation = elevation;
+  options.shaded = shaded;
+  return options;
+}
+
+
+TEST_CASE("RenderSession: Shoots Many Views From One Prep", "[RenderSession]") {
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    WARN("annual_gift_man.g file not found, skipping test");
+    return;
+  }
+
+  RenderSession session(2);
+  REQUIRE(session.open(SAMPLE_FILE, "all"));
+  REQUIRE(session.isPrepared());
+
+  // Sizes, views and lighting all vary; straight down works too
+  std::vector<ThumbnailOptions> views = {
+    view(64, 35.0, 25.0),
+    view(32, 0.0, 90.0, false),
+    view(48, 90.0, 0.0)
+  };
+  std::vector<std::vector<char>> pngs;
+  REQUIRE(session.shoot(views, pngs));
+  REQUIRE(pngs.size() == views.size());
+
+  for (size_t i = 0; i < views.size(); ++i) {
+    QImage image = QImage::fromData(reinterpret_cast<const uchar*>(pngs[i].data()), static_cast<int>(pngs[i].size()));
+    REQUIRE(image.width() == views[i].size);
+    REQUIRE(image.height() == views[i].size);
+  }
+
+  // The session stays usable
+  std::vector<char> png;
+  REQUIRE(session.shoot(view(16, 180.0, 10.0), png));
+  REQUIRE_FALSE(png.empty());
+}
+
+
+TEST_CASE("RenderSession: Images Do Not Depend On The Batch", "[RenderSession]") {
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    WARN("annual_gift_man.g file not found, skipping test");
+    return;
+  }
+
+  ThumbnailOptions iso = view(40, 35.0, 25.0);
+  iso.hypersample = 3;
+
+  RenderSession single(1);
+  REQUIRE(single.open(SAMPLE_FILE, "all"));
+  std::vector<QImage> alone;
+  REQUIRE(single.trace({iso}, alone));
+
+  RenderSession parallel(4);
+  REQUIRE(parallel.open(SAMPLE_FILE, "all"));
+  std::vector<QImage> batch;
+  REQUIRE(parallel.trace({view(24, 0.0, 0.0), iso, view(24, 90.0, 0.0)}, batch));
+
+  REQUIRE(batch.size() == 3);
+  REQUIRE(batch[1] == alone[0]);
+}
+
+
+TEST_CASE("RenderSession: Needs Prepped Geometry", "[RenderSession]") {
+  RenderSession session;
+  std::vector<char> png;
+  REQUIRE_FALSE(session.shoot(ThumbnailOptions(), png));
+  REQUIRE_FALSE(session.open("does_not_exist.g", "all"));
+  REQUIRE_FALSE(session.isPrepared());
+
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    return;
+  }
+  REQUIRE(session.open(SAMPLE_FILE, "all"));
+  REQUIRE_FALSE(session.shoot(view(0, 0.0, 0.0), png));
+
+  session.close();
+  REQUIRE_FALSE(session.isPrepared());
+  REQUIRE_FALSE(session.shoot(ThumbnailOptions(), png));
+}
+
+
+TEST_CASE("RenderSession: Measures Geometry", "[RenderSession]") {
+  RenderSession unprepared;
+  GeometryMetrics none;
+  REQUIRE_FALSE(unprepared.measure(none));
+  REQUIRE_FALSE(none.sampled);
+
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    WARN("annual_gift_man.g file not found, skipping test");
+    return;
+  }
+
+  RenderSession single(1);
+  REQUIRE(single.open(SAMPLE_FILE, "all"));
+  GeometryMetrics metrics;
+  REQUIRE(single.measure(metrics, 0, 8, 32));
+  REQUIRE(metrics.sampled);
+  for (int axis = 0; axis < 3; ++axis) {
+    REQUIRE(metrics.bbox_min[axis] < metrics.bbox_max[axis]);
+  }
+  REQUIRE(metrics.volume > 0.0);
+  REQUIRE(metrics.volume_error >= 0.0);
+  REQUIRE(metrics.surface_area > 0.0);
+  REQUIRE(metrics.surface_area_error >= 0.0);
+
+  // Sampled volume cannot exceed the box it was found in
+  double box = 1.0;
+  for (int axis = 0; axis < 3; ++axis) {
+    box *= metrics.bbox_max[axis] - metrics.bbox_min[axis];
+  }
+  REQUIRE(metrics.volume <= box * 1.01);
+
+  // Every ray has a fixed seed, so thread count does not change results
+  RenderSession parallel(4);
+  REQUIRE(parallel.open(SAMPLE_FILE, "all"));
+  GeometryMetrics again;
+  REQUIRE(parallel.measure(again, 0, 8, 32));
+  REQUIRE(again.volume == metrics.volume);
+  REQUIRE(again.surface_area == metrics.surface_area);
+}
@@ -0,0 +1,48 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "StageTime.h"
+
+#include <chrono>
+#include <thread>
+
+
+TEST_CASE("StageTime: Sleeping Counts As Waiting", "[StageTime]") {
+  StageClock clock;
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  StageTime slept = clock.elapsed();
+  REQUIRE(slept.wallUs >= 50000);
+  if (slept.hasCpu()) {
+    REQUIRE(slept.cpuUs < slept.wallUs);
+    REQUIRE(slept.waitUs() > 0);
+  }
+
+  // Wall time only: nothing is waiting as far as we know
+  StageTime wall = clock.elapsedWall();
+  REQUIRE_FALSE(wall.hasCpu());
+  REQUIRE(wall.waitUs() == 0);
+}
+
+
+TEST_CASE("StageTime: Totals Summarize A Batch", "[StageTime]") {
+  StageTotals totals;
+  StageTime first;
+  first.wallUs = 3000000;
+  first.cpuUs = 1000000;
+  StageTime second;
+  second.wallUs = 1000000;
+  second.cpuUs = 0;
+  totals.add(first);
+  totals.add(second);
+  REQUIRE(totals.count() == 2);
+  REQUIRE(totals.summary("open") == "open: 2 files, 4.0 s wall, 1.0 s CPU, 75% waiting");
+
+  StageTotals renders;
+  StageTime render;
+  render.wallUs = 2500000;
+  render.cpuUs = -1;
+  renders.add(render);
+  REQUIRE(renders.summary("render") == "render: 1 files, 2.5 s wall");
+}
@@ -0,0 +1,94 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "ThumbnailCache.h"
+
+#include <chrono>
+#include <filesystem>
+
+
+class ThumbnailCacheFixture {
+public:
+  std::filesystem::path cacheDir;
+
+  ThumbnailCacheFixture() {
+    cacheDir = std::filesystem::temp_directory_path() / "ThumbnailCacheTest";
+    std::filesystem::remove_all(cacheDir);
+  }
+
+  ~ThumbnailCacheFixture() {
+    std::filesystem::remove_all(cacheDir);
+  }
+};
+
+
+TEST_CASE("ThumbnailCache: Key Depends On Content, Object And View", "[ThumbnailCache]") {
+  ThumbnailOptions options;
+  std::string base = ThumbnailCache::key("00000000000000aa", "all", options);
+  REQUIRE(base.size() == 16);
+  REQUIRE(base == ThumbnailCache::key("00000000000000aa", "all", options));
+
+  REQUIRE(base != ThumbnailCache::key("00000000000000bb", "all", options));
+  REQUIRE(base != ThumbnailCache::key("00000000000000aa", "body.c", options));
+
+  ThumbnailOptions small = options;
+  small.size = 64;
+  REQUIRE(base != ThumbnailCache::key("00000000000000aa", "all", small));
+
+  ThumbnailOptions turned = options;
+  turned.azimuth = 270.0;
+  REQUIRE(base != ThumbnailCache::key("00000000000000aa", "all", turned));
+
+  // Without a content hash nothing can be cached
+  REQUIRE(ThumbnailCache::key("", "all", options).empty());
+}
+
+
+TEST_CASE_METHOD(ThumbnailCacheFixture, "ThumbnailCache: Store And Lookup", "[ThumbnailCache]") {
+  ThumbnailCache cache(cacheDir.string(), 1024 * 1024);
+  std::string key = ThumbnailCache::key("00000000000000aa", "all", ThumbnailOptions());
+
+  std::vector<char> png;
+  REQUIRE_FALSE(cache.lookup(key, png));
+
+  std::vector<char> image = {'\x89', 'P', 'N', 'G', '1'};
+  REQUIRE(cache.store(key, image));
+  REQUIRE(cache.lookup(key, png));
+  REQUIRE(png == image);
+
+  // A second instance (another library) sees the same entry
+  ThumbnailCache other(cacheDir.string(), 1024 * 1024);
+  png.clear();
+  REQUIRE(other.lookup(key, png));
+  REQUIRE(png == image);
+}
+
+
+TEST_CASE_METHOD(ThumbnailCacheFixture, "ThumbnailCache: Evicts Least Recently Used", "[ThumbnailCache]") {
+  ThumbnailCache cache((cacheDir / "lru").string(), 100);
+  std::vector<char> image(40, 'x');
+
+  std::string a = ThumbnailCache::key("000000000000000a", "all", ThumbnailOptions());
+  std::string b = ThumbnailCache::key("000000000000000b", "all", ThumbnailOptions());
+  std::string c = ThumbnailCache::key("000000000000000c", "all", ThumbnailOptions());
+  REQUIRE(cache.store(a, image));
+  REQUIRE(cache.store(b, image));
+
+  // a was stored first but read last, so b is the one to go
+  auto entry = [&](const std::string& key) {
+    return cacheDir / "lru" / key.substr(0, 2) / (key + ".png");
+  };
+  auto now = std::filesystem::file_time_type::clock::now();
+  std::filesystem::last_write_time(entry(a), now - std::chrono::seconds(20));
+  std::filesystem::last_write_time(entry(b), now - std::chrono::seconds(10));
+  std::vector<char> png;
+  REQUIRE(cache.lookup(a, png));
+
+  REQUIRE(cache.store(c, image));
+  REQUIRE(cache.totalBytes() <= 100);
+  REQUIRE(std::filesystem::exists(entry(a)));
+  REQUIRE_FALSE(std::filesystem::exists(entry(b)));
+  REQUIRE(std::filesystem::exists(entry(c)));
+}
@@ -0,0 +1,154 @@
+
+/* let catch provide main() */
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch_test_macros.hpp>
+
+#include "ThumbnailRenderer.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <cstdlib>
+#include <filesystem>
+
+
+// Same sample geometry the ProcessGFiles tests use
+static const std::string SAMPLE_FILE = "../src/tests/annual_gift_man.g";
+
+
+TEST_CASE("ThumbnailRenderer: Renders PNG In Memory", "[ThumbnailRenderer]") {
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    WARN("annual_gift_man.g file not found, skipping test");
+    return;
+  }
+
+  ThumbnailRenderer renderer(2);
+  ThumbnailOptions options;
+  options.size = 64;
+
+  // "all" does not exist in the sample, so every top-level object is drawn
+  std::vector<char> png;
+  REQUIRE(renderer.renderFile(SAMPLE_FILE, "all", options, png));
+  REQUIRE(png.size() > 8);
+  REQUIRE(png[1] == 'P');
+  REQUIRE(png[2] == 'N');
+  REQUIRE(png[3] == 'G');
+
+  QImage image = QImage::fromData(reinterpret_cast<const uchar*>(png.data()), static_cast<int>(png.size()));
+  REQUIRE(image.width() == 64);
+  REQUIRE(image.height() == 64);
+
+  // Some geometry hit the middle of the frame
+  bool anyLit = false;
+  for (int y = 16; y < 48 && !anyLit; ++y) {
+    for (int x = 16; x < 48; ++x) {
+      if (qGray(image.pixel(x, y)) > 0) {
+        anyLit = true;
+        break;
+      }
+    }
+  }
+  REQUIRE(anyLit);
+}
+
+
+TEST_CASE("ThumbnailRenderer: Rejects Missing Files", "[ThumbnailRenderer]") {
+  ThumbnailRenderer renderer;
+  std::vector<char> png;
+  REQUIRE_FALSE(renderer.renderFile("does_not_exist.g", "all", ThumbnailOptions(), png));
+  REQUIRE(png.empty());
+}
+
+
+TEST_CASE("ThumbnailRenderer: Renders A View Set From One Prep", "[ThumbnailRenderer]") {
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    WARN("annual_gift_man.g file not found, skipping test");
+    return;
+  }
+
+  ThumbnailRenderer renderer(2);
+  ThumbnailOptions options;
+  options.size = 64;
+  std::vector<ThumbnailOptions> views = ThumbnailRenderer::viewSet(options);
+  REQUIRE(views.size() == 4);
+  REQUIRE(views[3].elevation == 90.0);
+
+  std::vector<std::vector<char>> pngs;
+  REQUIRE(renderer.renderFileViews(SAMPLE_FILE, "all", views, pngs));
+  REQUIRE(pngs.size() == views.size());
+
+  // The first view is the thumbnail a single render gives
+  std::vector<char> single;
+  REQUIRE(renderer.renderFile(SAMPLE_FILE, "all", options, single));
+  REQUIRE(pngs[0] == single);
+  REQUIRE(pngs[1] != pngs[0]);
+
+  ThumbnailImage atlas = ThumbnailRenderer::packAtlas(pngs, 32);
+  REQUIRE(atlas.size == 32);
+  QImage image = QImage::fromData(reinterpret_cast<const uchar*>(atlas.data.data()),
+                                  static_cast<int>(atlas.data.size()));
+  REQUIRE(image.width() == 4 * 32);
+  REQUIRE(image.height() == 32);
+}
+
+
+TEST_CASE("ThumbnailRenderer: Measures On The Render Session", "[ThumbnailRenderer]") {
+  if (!std::filesystem::exists(SAMPLE_FILE)) {
+    WARN("annual_gift_man.g file not found, skipping test");
+    return;
+  }
+
+  ThumbnailRenderer renderer(2);
+  ThumbnailOptions options;
+  options.size = 64;
+  std::vector<char> png;
+  GeometryMetrics metrics;
+  REQUIRE(renderer.renderFile(SAMPLE_FILE, "all", options, png, 0, &metrics));
+  REQUIRE(metrics.sampled);
+  REQUIRE(metrics.volume > 0.0);
+  REQUIRE(metrics.bbox_max[0] > metrics.bbox_min[0]);
+
+  // The same estimate without a render, as a cached preview needs
+  GeometryMetrics measured;
+  REQUIRE(renderer.measureFile(SAMPLE_FILE, "all", measured));
+  REQUIRE(measured.sampled);
+  REQUIRE(measured.volume > 0.0);
+
+  // Nothing rendered, nothing measured
+  GeometryMetrics none;
+  REQUIRE_FALSE(renderer.renderFile("does_not_exist.g", "all", options, png, 0, &none));
+  REQUIRE_FALSE(none.sampled);
+}
+
+
+TEST_CASE("ThumbnailRenderer: Packs Views Left To Right", "[ThumbnailRenderer]") {
+  // Solid views are easy to find again after lossy encoding
+  std::vector<QColor> colors = {Qt::red, Qt::green, Qt::blue};
+  std::vector<std::vector<char>> pngs;
+  for (const QColor& color : colors) {
+    QImage view(48, 48, QImage::Format_RGB32);
+    view.fill(color);
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    REQUIRE(view.save(&buffer, "PNG"));
+    pngs.emplace_back(encoded.begin(), encoded.end());
+  }
+
+  ThumbnailImage atlas = ThumbnailRenderer::packAtlas(pngs, 16);
+  REQUIRE(atlas.size == 16);
+  REQUIRE(atlas.format == ThumbnailRenderer::compactFormat());
+  QImage image = QImage::fromData(reinterpret_cast<const uchar*>(atlas.data.data()),
+                                  static_cast<int>(atlas.data.size()));
+  REQUIRE(image.width() == 48);
+  REQUIRE(image.height() == 16);
+  for (size_t i = 0; i < colors.size(); ++i) {
+    QColor center = image.pixelColor(static_cast<int>(i) * 16 + 8, 8);
+    REQUIRE(std::abs(center.red() - colors[i].red()) < 16);
+    REQUIRE(std::abs(center.green() - colors[i].green()) < 16);
+    REQUIRE(std::abs(center.blue() - colors[i].blue()) < 16);
+  }
+
+  // One bad view spoils the atlas
+  pngs[1] = {'x'};
+  REQUIRE(ThumbnailRenderer::packAtlas(pngs, 16).data.empty());
+}
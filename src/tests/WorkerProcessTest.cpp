@@ -0,0 +1,85 @@
+// The test binary is its own helper: WorkerProcess starts
+// applicationFilePath() with --process-worker
+#include <catch2/catch_session.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "WorkerProcess.h"
+
+#include <QCoreApplication>
+
+#include <filesystem>
+
+namespace {
+
+// Same sample geometry the ProcessGFiles tests use
+const std::string SAMPLE_FILE = "../src/tests/annual_gift_man.g";
+
+ModelData modelFor(int id, const std::string& filePath) {
+    std::string shortName = std::filesystem::path(filePath).stem().string();
+    return ModelData{id, shortName, "", "", "", {}, "", filePath, "Library", false, false, true, {}};
+}
+
+}
+
+
+TEST_CASE("WorkerProcess: Extraction Matches In-Process", "[WorkerProcess]") {
+    if (!std::filesystem::exists(SAMPLE_FILE)) {
+        WARN("annual_gift_man.g file not found, skipping test");
+        return;
+    }
+    ModelData modelData = modelFor(1, SAMPLE_FILE);
+
+    ProcessGFiles processor(nullptr, 0);
+    ExtractionResult local = processor.extract(modelData);
+
+    WorkerProcess helper;
+    ExtractionResult isolated;
+    REQUIRE(helper.extract(modelData, isolated) == WorkerProcess::Done);
+
+    REQUIRE(isolated.ok == local.ok);
+    REQUIRE(isolated.modelData.id == 1);
+    REQUIRE(isolated.modelData.title == local.modelData.title);
+    REQUIRE(isolated.thumbnailObject == local.thumbnailObject);
+    REQUIRE(isolated.objects.size() == local.objects.size());
+    for (size_t i = 0; i < local.objects.size(); ++i) {
+        REQUIRE(isolated.objects[i].name == local.objects[i].name);
+        REQUIRE(isolated.objects[i].parent_object_id == local.objects[i].parent_object_id);
+        REQUIRE(isolated.objects[i].structure_hash == local.objects[i].structure_hash);
+    }
+
+    // One helper serves many jobs
+    REQUIRE(helper.extract(modelFor(2, SAMPLE_FILE), isolated) == WorkerProcess::Done);
+    REQUIRE(isolated.modelData.id == 2);
+    REQUIRE(helper.restarts() == 0);
+}
+
+
+TEST_CASE("WorkerProcess: Unreadable Files Fail Without Crashing", "[WorkerProcess]") {
+    WorkerProcess helper;
+    ExtractionResult extraction;
+    REQUIRE(helper.extract(modelFor(3, "does_not_exist.g"), extraction) == WorkerProcess::Done);
+    REQUIRE_FALSE(extraction.ok);
+    REQUIRE(helper.restarts() == 0);
+}
+
+
+TEST_CASE("WorkerProcess: Overrunning Helpers Are Replaced", "[WorkerProcess]") {
+    // Far too little time for a helper to even start up
+    WorkerProcess helper(1);
+    ExtractionResult extraction;
+    REQUIRE(helper.extract(modelFor(4, SAMPLE_FILE), extraction) == WorkerProcess::TimedOut);
+    REQUIRE_FALSE(extraction.ok);
+
+    REQUIRE(helper.extract(modelFor(4, SAMPLE_FILE), extraction) == WorkerProcess::TimedOut);
+    REQUIRE(helper.restarts() == 1);
+}
+
+
+int main(int argc, char** argv) {
+    if (WorkerProcess::isWorkerCommandLine(argc, argv)) {
+        return WorkerProcess::serve(argc, argv);
+    }
+
+    QCoreApplication app(argc, argv);
+    return Catch::Session().run(argc, argv);
+}